@@ -54,6 +54,15 @@ QDBusVariant AdaptorModel::execute (const QString &s)
     return QDBusVariant (model->execute (s));
 }
 
+QStringList AdaptorModel::executeBatch (const QStringList &commands, QList <int> &errorLevels)
+{
+    // One round trip, one layout and one undo step for all commands
+    QStringList results;
+    foreach (QVariant v, model->executeBatch (commands, errorLevels))
+	results << v.toString();
+    return results;
+}
+
 QDBusVariant AdaptorModel::errorLevel()
 {
     return QDBusVariant ();  // model->parser.errorLevel() );     // FIXME-2 really still needed?
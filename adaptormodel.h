@@ -28,6 +28,7 @@ public slots: // METHODS
     QDBusVariant getCurrentModelID();
     QDBusVariant branchCount();
     QDBusVariant execute (const QString &s);
+    QStringList executeBatch (const QStringList &commands, QList <int> &errorLevels);
     QDBusVariant errorLevel();
     QDBusVariant errorDescription();
     QDBusVariant listCommands();
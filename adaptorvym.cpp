@@ -5,6 +5,7 @@
 #include "adaptorvym.h"
 #include "command.h"
 #include "mainwindow.h"
+#include "vymmodel.h"
 
 extern QString vymInstanceName;
 extern QString vymVersion;
@@ -43,6 +44,22 @@ QDBusVariant AdaptorVym::execute(const QString &s)
     return QDBusVariant (mainWindow->runScript( s ) );
 }
 
+QStringList AdaptorVym::executeBatch (const QStringList &commands, QList <int> &errorLevels)
+{
+    // Changes in current map are done as one undo step
+    QVariantList list;
+    VymModel *m = mainWindow->currentModel();
+    if (m)
+	list = m->executeBatch (commands, errorLevels);
+    else
+	list = mainWindow->runScriptBatch (commands, NULL, errorLevels);
+
+    QStringList results;
+    foreach (QVariant v, list)
+	results << v.toString();
+    return results;
+}
+
 QDBusVariant AdaptorVym::listCommands ()
 {
     QStringList list;
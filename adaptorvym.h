@@ -20,6 +20,7 @@ public slots: // METHODS
     QDBusVariant getInstanceName();
     QDBusVariant getVersion();
     QDBusVariant execute ( const QString &s);
+    QStringList executeBatch (const QStringList &commands, QList <int> &errorLevels);
     QDBusVariant listCommands();
     QDBusVariant currentMapIndex();
 
@@ -2,6 +2,8 @@
 
 #include <math.h>
 
+#include "vymmodel.h"
+
 AnimPoint::AnimPoint()
 {
     init();
@@ -16,7 +18,7 @@ void AnimPoint::operator= ( const QPointF & other )
 {
     init();
     setX (other.x() );
-    setY (other.x() );
+    setY (other.y() );
 }
 
 bool AnimPoint::operator== ( const QPointF& other )
@@ -39,23 +41,23 @@ bool AnimPoint::operator== ( AnimPoint  other )
 void AnimPoint::init ()
 {
     animated=false;
-    n=0;
+    elapsed=0;
     startPos=QPointF(0,0);
     destPos=QPointF(0,0);
     vector=QPointF(0,0);
-    animTicks=10;
+    duration=100;
 }
 
 void AnimPoint::copy (AnimPoint other)
 {
     setX (other.x() );
-    setY (other.x() );
+    setY (other.y() );
     startPos=other.startPos;
     destPos=other.destPos;
     vector=other.vector;
     animated=other.animated;
-    n=other.n;
-    animTicks=other.animTicks;
+    elapsed=other.elapsed;
+    duration=other.duration;
 }
 
 void AnimPoint::setStart(const QPointF &p)
@@ -81,20 +83,20 @@ QPointF AnimPoint::getDest()
     return destPos;
 }
 
-void AnimPoint::setTicks (const uint &t)
+void AnimPoint::setDuration (const int &ms)
 {
-    animTicks=t;
+    duration=qMax (1, ms);
 }
 
-uint AnimPoint::getTicks()
+int AnimPoint::getDuration()
 {
-    return (uint) animTicks;
+    return duration;
 }
 
 void AnimPoint::setAnimated(bool b)
 {
     animated=b;
-    if (b) n=0;
+    if (b) elapsed=0;
 }
 
 bool AnimPoint::isAnimated()
@@ -102,11 +104,11 @@ bool AnimPoint::isAnimated()
     return animated;
 }
 
-bool AnimPoint::animate()
+bool AnimPoint::animate(const int &ms)
 {
     if (!animated) return false;
-    n++;
-    if (n>animTicks)
+    elapsed+=ms;
+    if (elapsed>=duration)
     {
 	vector=QPointF(0,0);
 	animated=false;
@@ -116,7 +118,7 @@ bool AnimPoint::animate()
     }
 
     // Some math to slow down the movement in the end
-    qreal f=1-n/(qreal)animTicks;
+    qreal f=1-elapsed/(qreal)duration;
     qreal ff=1-f*f*f;
     setX (startPos.x() + vector.x()*ff );
     setY (startPos.y() + vector.y()*ff );
@@ -138,3 +140,30 @@ void AnimPoint::initVector()
 }
 
 
+
+/////////////////////////////////////////////////////////////////
+// AnimationDriver
+/////////////////////////////////////////////////////////////////
+
+AnimationDriver::AnimationDriver (VymModel *m) : QAbstractAnimation (m)
+{
+    model=m;
+    lastTime=0;
+}
+
+int AnimationDriver::duration() const
+{
+    return -1;	// Run until stopped by model
+}
+
+void AnimationDriver::updateCurrentTime (int currentTime)
+{
+    int ms=currentTime-lastTime;
+    lastTime=currentTime;
+    if (ms>0) model->animate (ms);
+}
+
+void AnimationDriver::updateState (QAbstractAnimation::State newState, QAbstractAnimation::State)
+{
+    if (newState==QAbstractAnimation::Running) lastTime=0;
+}
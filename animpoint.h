@@ -1,8 +1,11 @@
 #ifndef ANIMPOINT_H
 #define ANIMPOINT_H
 
+#include <QAbstractAnimation>
 #include <QPointF>
 
+class VymModel;
+
 class AnimPoint: public QPointF
 {
 public:
@@ -17,11 +20,11 @@ public:
     QPointF getStart();
     void setDest (const QPointF &);
     QPointF getDest();
-    void setTicks (const uint &t);
-    uint getTicks();
+    void setDuration (const int &ms);
+    int getDuration();
     void setAnimated(bool);
     bool isAnimated ();
-    bool animate();
+    bool animate(const int &ms);    //! Advance by elapsed time, false if finished
     void stop();
 
 private:
@@ -30,10 +33,33 @@ private:
     QPointF startPos;
     QPointF destPos;
     QPointF vector;
-    qreal n;
-    uint animTicks;
+    int elapsed;	// ms since start of animation
+    int duration;	// ms
     bool animated;
 
 };
 
+/*! \brief Drives all animated objects of a VymModel by elapsed time
+
+    The driver runs on the same unified timer as the QPropertyAnimations
+    in MapEditor, so all animations advance together once per frame. 
+    If frames are skipped under load, the next frame just advances
+    further. 
+*/
+
+class AnimationDriver: public QAbstractAnimation
+{
+public:
+    AnimationDriver (VymModel *m);
+    virtual int duration() const;
+
+protected:
+    virtual void updateCurrentTime (int currentTime);
+    virtual void updateState (QAbstractAnimation::State newState, QAbstractAnimation::State oldState);
+
+private:
+    VymModel *model;
+    int lastTime;
+};
+
 #endif
@@ -9,8 +9,6 @@
 #include "mainwindow.h"   
 #include "misc.h"
 
-extern FlagRow *standardFlagsMaster;
-extern FlagRow *systemFlagsMaster;
 extern bool debug;
 
 /////////////////////////////////////////////////////////////////
@@ -237,12 +235,12 @@ void BranchObj::positionBBox() // FIXME-3 consider dimensions of frame (thicknes
     bbox.moveTopLeft (ap);
     positionContents();   // this positions FIOs
 
-    //Update links to other branches
+    //Update links to other branches, if one of the ends moved
     XLinkObj *xlo;
     for (int i=0; i<treeItem->xlinkCount(); ++i)
     {
         xlo=treeItem->getXLinkObjNum(i);
-        if (xlo) xlo->updateXLink();
+        if (xlo) xlo->requestUpdate();
     }
 }
 
@@ -379,40 +377,10 @@ void BranchObj::updateData()
     QString s = treeItem->getHeadingText();
     if ( s!=heading->text()) heading->setText (s);
 
-    QStringList TIactiveFlags=treeItem->activeStandardFlagNames();
+    // Add missing and remove no longer active flags of TreeItem
+    standardFlags->updateFlags (treeItem->getStandardFlagRow() );
+    systemFlags->updateFlags (treeItem->getSystemFlagRow() );
 
-    // Add missing standard flags active in TreeItem
-    for (int i=0;i<=TIactiveFlags.size()-1;i++)
-    {
-        if (!standardFlags->isActive (TIactiveFlags.at(i) ))
-        {
-            Flag *f=standardFlagsMaster->getFlag(TIactiveFlags.at(i));
-            if (f) standardFlags->activate (f);
-        }
-    }
-    // Remove standard flags no longer active in TreeItem
-    QStringList BOactiveFlags=standardFlags->activeFlagNames();
-    for (int i=0;i<BOactiveFlags.size();++i)
-        if (!TIactiveFlags.contains (BOactiveFlags.at(i)))
-            standardFlags->deactivate (BOactiveFlags.at(i));
-
-    // Add missing system flags active in TreeItem
-    TIactiveFlags=treeItem->activeSystemFlagNames();
-    for (int i=0;i<TIactiveFlags.size();++i)
-    {
-        if (!systemFlags->isActive (TIactiveFlags.at(i) ))
-        {
-            Flag *f=systemFlagsMaster->getFlag(TIactiveFlags.at(i));
-            if (f) systemFlags->activate (f);
-        }
-    }
-    // Remove system flags no longer active in TreeItem
-    BOactiveFlags=systemFlags->activeFlagNames();
-    for (int i=0;i<BOactiveFlags.size();++i)
-    {
-        if (!TIactiveFlags.contains (BOactiveFlags.at(i)))
-            systemFlags->deactivate (BOactiveFlags.at(i));
-    }
     calcBBoxSize();
 }
 
@@ -721,17 +689,16 @@ void BranchObj::stopAnimation()
         move (anim);
 }
 
-bool BranchObj::animate()
+bool BranchObj::animate(const int &ms)
 {
-    anim.animate ();
-    if ( anim.isAnimated() )
-    {
-        if (useRelPos)
-            setRelPos (anim);
-        else
-            move (anim);
-        return true;
-    }
-    return false;
+    if ( !anim.isAnimated() ) return false;
+
+    // Move also when finished, then anim is at destination
+    bool running = anim.animate (ms);
+    if (useRelPos)
+        setRelPos (anim);
+    else
+        move (anim);
+    return running;
 }
 
@@ -52,7 +52,7 @@ public:
 
     virtual void setAnimation(const AnimPoint &ap);
     virtual void stopAnimation();
-    virtual bool animate();
+    virtual bool animate(const int &ms);
 
 protected:
     AnimPoint anim;
@@ -15,114 +15,26 @@ ExportASCII::ExportASCII()
 
 void ExportASCII::doExport()
 {
-    QFile file (filePath);
-    if ( !file.open( QIODevice::WriteOnly ) )
-    {
-        QMessageBox::critical (0, QObject::tr("Critical Export Error"), QObject::tr("Could not export as ASCII to %1").arg(filePath));
-        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
-        return;
-    }
+    if (!openOutput (filePath)) return;
 
-    QString out;
+    lastDepth = 0;
+    tasks.clear();
 
     // Main loop over all branches
-    QString s;
-    QString curIndent;
-    QString dashIndent;
-    int i;
-    BranchItem *cur=NULL;
-    BranchItem *prev=NULL;
-
-    int lastDepth=0;
-
-    QStringList tasks;
-
-    model->nextBranch (cur,prev);
-    while (cur)
-    {
-        if (cur->getType()==TreeItem::Branch || cur->getType()==TreeItem::MapCenter)
-        {
-            if (!cur->hasHiddenExportParent() )
-            {
-                //qDebug() << "ExportASCII::  "<<curIndent.toStdString()<<cur->getHeadingPlain().toStdString();
-
-                // Insert newline after previous list
-                if ( cur->depth() < lastDepth ) out +=  "\n";
-
-                // Make indentstring
-                curIndent="";
-                for (i=1;i<cur->depth()-1;i++) curIndent += indentPerDepth;
-
-                dashIndent="";
-                switch (cur->depth())
-                {
-                case 0:
-                    out +=  underline (cur->getHeadingPlain(),QString("="));
-                    out +=  "\n";
-                    break;
-                case 1:
-                    out +=  "\n";
-                    out +=  (underline (getSectionString(cur) + cur->getHeadingPlain(), QString("-") ) );
-                    out +=  "\n";
-                    break;
-                case 3:
-                    out +=  (curIndent + "- " + cur->getHeadingPlain());
-                    out +=  "\n";
-                    dashIndent="  ";
-                    break;
-                default:
-                    out +=  (curIndent + "- " + cur->getHeadingPlain());
-                    out +=  "\n";
-                    dashIndent="  ";
-                    break;
-                }
-
-                // If there is a task, save it for potential later display
-                if (listTasks && cur->getTask() )
-                {
-                    tasks.append( QString("[%1]: %2").arg(cur->getTask()->getStatusString()).arg(cur->getHeadingPlain() ) );
-                }
-
-                // If necessary, write URL
-                if (!cur->getURL().isEmpty())
-                    out +=  (curIndent + dashIndent + cur->getURL()) +"\n";
-
-                // If necessary, write vymlink
-                if (!cur->getVymLink().isEmpty())
-                    out +=  (curIndent + dashIndent + cur->getVymLink()) +" (vym mindmap)\n";
-
-                // If necessary, write note
-                if (!cur->isNoteEmpty())
-                {
-                    // curIndent +="  | ";
-                    // Only indent for bullet points
-                    if (cur->depth() > 2) curIndent +="  ";
-                    out +=  '\n' +  cur->getNoteASCII(curIndent, 80) ;
-                }
-                lastDepth = cur->depth();
-            }
-        }
-        model->nextBranch(cur,prev);
-    }
+    walkBranches();
 
     if (listTasks)
     {
-        out +=  "\n\nTasks\n-----\n\n";
+        stream <<  "\n\nTasks\n-----\n\n";
 
 
         foreach (QString t, tasks)
         {
-            out +=  " - " + t + "\n";
+            stream <<  " - " + t + "\n";
         }
     }
 
-    QTextStream ts( &file );
-    ts.setCodec("UTF-8");
-    ts << out;
-    file.close();
-
-    QClipboard *clipboard = QGuiApplication::clipboard();
-    clipboard->setText(out);
+    success = closeOutput();
     
     QString listTasksString = listTasks ? "true" : "false";
 
@@ -132,10 +44,67 @@ void ExportASCII::doExport()
     args["filePath"]  = filePath;
     args["listTasks"] = listTasksString;
 
-    success = true;
     completeExport( args );
 }
 
+bool ExportASCII::visitBranch (BranchItem *cur, const BranchState &state)
+{
+    //qDebug() << "ExportASCII::  "<<curIndent.toStdString()<<cur->getHeadingPlain().toStdString();
+    QString curIndent;
+    QString dashIndent;
+    int depth = state.depth;
+
+    // Insert newline after previous list
+    if ( depth < lastDepth ) stream <<  "\n";
+
+    // Make indentstring
+    for (int i=1;i<depth-1;i++) curIndent += indentPerDepth;
+
+    QString heading = cur->getHeadingPlain();
+    switch (depth)
+    {
+    case 0:
+        stream <<  underline (heading,QString("="));
+        stream <<  "\n";
+        break;
+    case 1:
+        stream <<  "\n";
+        stream <<  (underline (state.section + heading, QString("-") ) );
+        stream <<  "\n";
+        break;
+    default:
+        stream <<  (curIndent + "- " + heading);
+        stream <<  "\n";
+        dashIndent="  ";
+        break;
+    }
+
+    // If there is a task, save it for potential later display
+    if (listTasks && cur->getTask() )
+    {
+        tasks.append( QString("[%1]: %2").arg(cur->getTask()->getStatusString()).arg(heading ) );
+    }
+
+    // If necessary, write URL
+    if (!cur->getURL().isEmpty())
+        stream <<  (curIndent + dashIndent + cur->getURL()) +"\n";
+
+    // If necessary, write vymlink
+    if (!cur->getVymLink().isEmpty())
+        stream <<  (curIndent + dashIndent + cur->getVymLink()) +" (vym mindmap)\n";
+
+    // If necessary, write note
+    if (!cur->isNoteEmpty())
+    {
+        // curIndent +="  | ";
+        // Only indent for bullet points
+        if (depth > 2) curIndent +="  ";
+        stream <<  '\n' +  cur->getNoteASCII(curIndent, 80) ;
+    }
+    lastDepth = depth;
+    return true;
+}
+
 QString ExportASCII::underline (const QString &text, const QString &line)
 {
     QString r=text + "\n";
@@ -240,6 +240,105 @@ QString ExportBase::getSectionString(TreeItem *start)
         return r + " ";
 }
 
+void ExportBase::walkBranches (TreeItem *start)
+{
+    if (!start) start = model->getRootItem();
+    if (!start) return;
+
+    BranchState state;
+    state.depth = start->depth();
+    state.num = 0;
+    state.scrolled = false;
+    if (start->isBranchLikeType() )
+    {
+        // Starting below a branch, take its state from the tree once
+        state.num      = start->num();
+        state.section  = getSectionString (start);
+        state.select   = model->getSelectString (start);
+        state.scrolled = ((BranchItem*)start)->hasScrolledParent();
+    }
+    walkChildren (start, state);
+}
+
+void ExportBase::walkChildren (TreeItem *parent, const BranchState &parentState)
+{
+    BranchState state;
+    state.depth    = parentState.depth + 1;
+    state.scrolled = parentState.scrolled || 
+        (parent->isBranchLikeType() && ((BranchItem*)parent)->isScrolled() );
+
+    // Section string of parent without trailing blank
+    QString sectionPrefix = parentState.section;
+    sectionPrefix.chop (1);
+
+    bool listStarted = false;
+    int n = parent->branchCount();
+    for (int i = 0; i < n; i++)
+    {
+        BranchItem *bi = parent->getBranchNum (i);
+        if (bi->isHidden() || bi->hideInExport() ) continue;
+
+        state.num = i;
+        if (state.depth > 0)
+        {
+            state.section = sectionPrefix + QString::number (i + 1) + ". ";
+            state.select  = parentState.select + QString(",bo:%1").arg(i);
+        } else
+            state.select  = QString("mc:%1").arg(i);
+
+        if (!listStarted)
+        {
+            beginList (state);
+            listStarted = true;
+        }
+        if (visitBranch (bi, state) ) walkChildren (bi, state);
+        leaveBranch (bi, state);
+    }
+    if (listStarted) endList (state);
+}
+
+void ExportBase::beginList (const BranchState &)
+{
+}
+
+void ExportBase::endList (const BranchState &)
+{
+}
+
+bool ExportBase::visitBranch (BranchItem *, const BranchState &)
+{
+    return true;
+}
+
+void ExportBase::leaveBranch (BranchItem *, const BranchState &)
+{
+}
+
+bool ExportBase::openOutput (const QString &fn)
+{
+    outputFile.setFileName (fn);
+    if ( !outputFile.open( QIODevice::WriteOnly ) )
+    {
+        QMessageBox::critical (0, 
+            QObject::tr("Critical Export Error"), 
+            QObject::tr("Could not export as %1 to %2").arg(exportName).arg(fn));
+        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
+        return false;
+    }
+    stream.setDevice (&outputFile);
+    stream.setCodec ("UTF-8");
+    return true;
+}
+
+bool ExportBase::closeOutput ()
+{
+    stream.flush();
+    bool ok = stream.status() == QTextStream::Ok && outputFile.error() == QFile::NoError;
+    stream.setDevice (NULL);
+    outputFile.close();
+    return ok;
+}
+
 QString ExportBase::indent (const int &n, bool useBullet)
 {
     QString s;
@@ -2,8 +2,10 @@
 #define EXPORT_BASE_H
 
 #include <QDir>
+#include <QFile>
 #include <QMap>
 #include <QString>
+#include <QTextStream>
 #include <iostream>
 
 #include "settings.h"
@@ -46,6 +48,31 @@ protected:
     QString lastCommand;
     virtual QString getSectionString (TreeItem*);
 
+    /*! \brief State of a branch while walking the map
+
+	All values are derived from the parent during the walk, so 
+	exporters don't need to walk up the tree for every branch.
+    */
+    struct BranchState
+    {
+	int depth;	    //! 0 for mapcenters
+	int num;	    //! Position of branch within siblings
+	QString section;    //! Section number, e.g. "2.5.3. " like getSectionString()
+	QString select;	    //! Select string like VymModel::getSelectString()
+	bool scrolled;	    //! True, if any of the parents is scrolled
+    };
+
+    void walkBranches (TreeItem *start = NULL);	//! Pre-order walk below start, skips hidden branches
+    virtual void beginList (const BranchState &first); //! Before first visible branch of siblings
+    virtual void endList (const BranchState &last);    //! After last visible branch of siblings
+    virtual bool visitBranch (BranchItem *bi, const BranchState &state); //! Return false to skip children
+    virtual void leaveBranch (BranchItem *bi, const BranchState &state); //! After children have been visited
+
+    bool openOutput (const QString &fn);    //! Open file for streaming output
+    bool closeOutput ();
+    QFile outputFile;
+    QTextStream stream;	    //! Buffered output of export
+
     QString indent (const int &n, bool useBullet);
     QDir tmpDir;
     QString destination;    // Can be the filePath or URL. Used for display in "ExportLast"
@@ -61,6 +88,9 @@ protected:
     bool listTasks;         // Append task list
     bool cancelFlag;
     bool success;
+
+private:
+    void walkChildren (TreeItem *parent, const BranchState &parentState);
 };
 
 
@@ -15,59 +15,36 @@ ExportCSV::ExportCSV()
 
 void ExportCSV::doExport()
 {
-    QFile file (filePath);
-    if ( !file.open( QIODevice::WriteOnly ) )
-    {
-        QMessageBox::critical (0, QObject::tr("Critical Export Error"), QObject::tr("Could not export as CSV to %1").arg(filePath));
-        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
-        return;
-    }
-
-    QString out;
+    if (!openOutput (filePath)) return;
 
     // Write header
-    out += "\"Note\"\n";
+    stream << "\"Note\"\n";
 
     // Main loop over all branches
-    QString s;
-    QString curIndent("");
-    int i;
-    BranchItem *cur=NULL;
-    BranchItem *prev=NULL;
-    model->nextBranch (cur,prev);
-    while (cur)
-    {
-        if (!cur->hasHiddenExportParent() )
-        {
-            // If necessary, write note
-            if (!cur->isNoteEmpty())
-            {
-                s =cur->getNoteASCII();
-                s=s.replace ("\n","\n"+curIndent);
-                out += ("\""+s+"\",");
-            } else
-                out +="\"\",";
-
-            // Make indentstring
-            for (i=0;i<cur->depth();i++) curIndent+= "\"\",";
-
-            // Write heading
-            out += curIndent + "\"" + cur->getHeadingPlain() + "\"\n";
-        }
+    walkBranches();
 
-        model->nextBranch(cur,prev);
-        curIndent="";
-    }
-    QTextStream ts( &file );
-    ts.setCodec("UTF-8");
-    ts << out;
-    file.close();
-
-    QClipboard *clipboard = QGuiApplication::clipboard();
-    clipboard->setText(out);
+    success = closeOutput();
     
     destination = filePath;
 
-    success = true;
     completeExport();
 }
+
+bool ExportCSV::visitBranch (BranchItem *cur, const BranchState &state)
+{
+    // If necessary, write note
+    if (!cur->isNoteEmpty())
+    {
+        QString s = cur->getNoteASCII();
+        stream << ("\""+s+"\",");
+    } else
+        stream << "\"\",";
+
+    // Make indentstring
+    QString curIndent;
+    for (int i=0;i<state.depth;i++) curIndent+= "\"\",";
+
+    // Write heading
+    stream << curIndent + "\"" + cur->getHeadingPlain() + "\"\n";
+    return true;
+}
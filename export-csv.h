@@ -8,6 +8,8 @@ class ExportCSV:public ExportBase
 public:
     ExportCSV();
     void doExport();
+protected:
+    virtual bool visitBranch (BranchItem *cur, const BranchState &state);
 };
 
 #endif
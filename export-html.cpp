@@ -26,9 +26,10 @@ void ExportHTML::init()
     exportName="HTML";
     extension=".html";
     frameURLs=true;
+    tocPass=false;
 }
 
-QString ExportHTML::getBranchText(BranchItem *current)
+QString ExportHTML::getBranchText(BranchItem *current, const BranchState &state)
 {
     if (current)
     {
@@ -41,11 +42,11 @@ QString ExportHTML::getBranchText(BranchItem *current)
             vis = lmo->isVisibleObj();
         }
         QString col;
-        QString id = model->getSelectString(current);
+        QString id = state.select;
         if (dia.useTextColor)
             col = QString("style='color:%1'").arg(current->getHeadingColor().name());
         QString s = QString("<span class='vym-branch-%1' %2 id='%3'>")
-                .arg(current->depth())
+                .arg(state.depth)
                 .arg(col)
                 .arg(id);
         QString url = current->getURL();
@@ -77,7 +78,7 @@ QString ExportHTML::getBranchText(BranchItem *current)
 
         // Numbering
         QString number;
-        if (dia.useNumbering) number = getSectionString(current) + " ";
+        if (dia.useNumbering) number = state.section + " ";
         
         // URL
         if (!url.isEmpty())
@@ -175,99 +176,75 @@ QString ExportHTML::getBranchText(BranchItem *current)
     return QString();
 }
 
-QString ExportHTML::buildList (BranchItem *current)
+void ExportHTML::beginList (const BranchState &first)
 {
-    QString r;
+    if (tocPass) return;
 
-    uint i = 0;
-    uint visChilds = 0;
+    stream << "\n" + indent(first.depth, false);
+    if (first.depth > 1)
+        stream << "<ul " + QString("class=\"vym-list-ul-%1\"").arg(first.depth)  +">";
+}
 
-    BranchItem *bi = current->getFirstBranch();
+void ExportHTML::endList (const BranchState &last)
+{
+    if (tocPass) return;
 
-    QString ind = "\n" + indent(current->depth() + 1, false);
+    stream << "\n" + indent(last.depth, false);
+    if (last.depth > 1) stream << "</ul>";
+}
 
-    QString sectionBegin;
-    QString sectionEnd;
-    QString itemBegin;
-    QString itemEnd;
+bool ExportHTML::visitBranch (BranchItem *current, const BranchState &state)
+{
+    if (tocPass)
+    {
+        // Entry in table of contents, skip scrolled parts of map
+        if (state.scrolled) return false;
+        QString number;
+        if (dia.useNumbering) number = state.section;
+        stream << QString("<div class=\"vym-toc-branch-%1\">").arg(state.depth);
+        stream << QString("<a href=\"#%1\"> %2 %3</a></br>\n")
+                .arg(state.select)
+                .arg(number)
+                .arg(quotemeta( current->getHeadingPlain() ));
+        stream << "</div>";
+        return true;
+    }
 
-    switch (current->depth() + 1)
+    stream << "\n" + indent(state.depth, false);
+    switch (state.depth)
     {
     case 0:
-        sectionBegin = "";
-        sectionEnd   = "";
-        itemBegin    = "<h1>";
-        itemEnd      = "</h1>";
+        stream << "<h1>" << getBranchText (current, state) << "</h1>";
         break;
     case 1:
-        sectionBegin = "";
-        sectionEnd   = "";
-        itemBegin    = "<h2>";
-        itemEnd      = "</h2>";
+        stream << "<h2>" << getBranchText (current, state) << "</h2>";
         break;
     default:
-        sectionBegin = "<ul " + QString("class=\"vym-list-ul-%1\"").arg(current->depth() + 1)  +">";
-        sectionEnd   = "</ul>";
-        itemBegin    = "  <li>";
-        itemEnd      = "  </li>";
+        stream << "  <li>" << getBranchText (current, state);
         break;
     }
-    
-    if (bi && !bi->hasHiddenExportParent() && !bi->isHidden() )
-    {
-        r += ind + sectionBegin;
-        while (bi)
-        {
-            if (!bi->hasHiddenExportParent() && !bi->isHidden())
-            {
-                visChilds++;
-                r += ind + itemBegin;
-                r += getBranchText (bi);
-
-                if (itemBegin.startsWith("<h") )
-                    r += itemEnd + buildList (bi);
-                else
-                    r += buildList (bi) + itemEnd;
-            }
-            i++;
-            bi = current->getBranchNum(i);
-        }
-        r += ind + sectionEnd;
-    }
+    return true;
+}
 
-    return r;
+void ExportHTML::leaveBranch (BranchItem *, const BranchState &state)
+{
+    // List items are closed after children have been written
+    if (!tocPass && state.depth > 1) stream << "  </li>";
 }
 
-QString ExportHTML::createTOC()
+void ExportHTML::createTOC()
 {
-    QString toc;
-    QString number;
-    toc += "<table class=\"vym-toc\">\n";
-    toc += "<tr><td class=\"vym-toc-title\">\n";
-    toc += QObject::tr("Contents:","Used in HTML export");
-    toc += "\n";
-    toc += "</td></tr>\n";
-    toc += "<tr><td>\n";
-    BranchItem *cur  = NULL;
-    BranchItem *prev = NULL;
-    model->nextBranch(cur, prev);
-    while (cur)
-    {
-        if (!cur->hasHiddenExportParent() && !cur->hasScrolledParent() )
-        {
-            if (dia.useNumbering) number = getSectionString(cur);
-            toc += QString("<div class=\"vym-toc-branch-%1\">").arg(cur->depth());
-            toc += QString("<a href=\"#%1\"> %2 %3</a></br>\n")
-                    .arg(model->getSelectString(cur))
-                    .arg(number)
-                    .arg(quotemeta( cur->getHeadingPlain() ));
-            toc += "</div>";
-        }
-        model->nextBranch(cur,prev);
-    }
-    toc += "</td></tr>\n";
-    toc += "</table>\n";
-    return toc;
+    stream << "<table class=\"vym-toc\">\n";
+    stream << "<tr><td class=\"vym-toc-title\">\n";
+    stream << QObject::tr("Contents:","Used in HTML export");
+    stream << "\n";
+    stream << "</td></tr>\n";
+    stream << "<tr><td>\n";
+    tocPass = true;
+    walkBranches();
+    tocPass = false;
+    stream << "</td></tr>\n";
+    stream << "</table>\n";
 }
 
 void ExportHTML::doExport(bool useDialog) 
@@ -357,65 +334,56 @@ void ExportHTML::doExport(bool useDialog)
     }
 
     // Open file for writing
-    QFile file (filePath);
-    if ( !file.open( QIODevice::WriteOnly ) )
-    {
-        QMessageBox::critical (0,
-                               QObject::tr("Critical Export Error"),
-                               QObject::tr("Trying to save HTML file:") + "\n\n"+
-                               QObject::tr("Could not write %1").arg(filePath));
-        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
-        return;
-    }
-    QTextStream ts( &file );
-    ts.setCodec("UTF-8");
+    if (!openOutput (filePath)) return;
 
     // Hide stuff during export
     model->setExportMode (true);
 
     // Write header
-    ts << "<html>";
-    ts << "\n<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\"> ";
-    ts << "\n<meta name=\"generator=\" content=\" vym - view your mind - " + vymVersion + " - " + vymHome + "\">";
-    ts << "\n<meta name=\"author\" content=\"" + quotemeta(model->getAuthor()) + "\"> ";
-    ts << "\n<meta name=\"description\" content=\"" + quotemeta(model->getComment()) + "\"> ";
-    ts << "\n<link rel='stylesheet' id='css.stylesheet' href='" << basename(cssDst) << "' />\n";
+    stream << "<html>";
+    stream << "\n<meta http-equiv=\"content-type\" content=\"text/html; charset=UTF-8\"> ";
+    stream << "\n<meta name=\"generator=\" content=\" vym - view your mind - " + vymVersion + " - " + vymHome + "\">";
+    stream << "\n<meta name=\"author\" content=\"" + quotemeta(model->getAuthor()) + "\"> ";
+    stream << "\n<meta name=\"description\" content=\"" + quotemeta(model->getComment()) + "\"> ";
+    stream << "\n<link rel='stylesheet' id='css.stylesheet' href='" << basename(cssDst) << "' />\n";
     QString title=model->getTitle();
     if (title.isEmpty()) title=model->getMapName();
-    ts << "\n<head><title>" + quotemeta(title) + "</title></head>";
-    ts << "\n<body>\n";
+    stream << "\n<head><title>" + quotemeta(title) + "</title></head>";
+    stream << "\n<body>\n";
 
     // Include image
     // (be careful: this resets Export mode, so call before exporting branches)
     if (dia.includeMapImage)
     {
         QString mapName = getMapName();
-        ts << "<center><img src=\"" << mapName << ".png\"";
-        ts << "alt=\"" << QObject::tr("Image of map: %1.vym","Alt tag in HTML export").arg(mapName) << "\"";
-        ts << " usemap='#imagemap'></center>\n";
+        stream << "<center><img src=\"" << mapName << ".png\"";
+        stream << "alt=\"" << QObject::tr("Image of map: %1.vym","Alt tag in HTML export").arg(mapName) << "\"";
+        stream << " usemap='#imagemap'></center>\n";
         offset = model->exportImage (dirPath + "/" + mapName + ".png", false, "PNG");
     }
 
     // Include table of contents
-    if (dia.useTOC) ts << createTOC();
+    if (dia.useTOC) createTOC();
 
     // Main loop over all mapcenters
-    ts << buildList(model->getRootItem()) << "\n";
+    imageMap.clear();
+    walkBranches();
+    stream << "\n";
 
     // Imagemap
-    ts << "<map name='imagemap'>\n" + imageMap + "</map>\n";
+    stream << "<map name='imagemap'>\n" + imageMap + "</map>\n";
 
     // Write footer
-    ts << "<hr/>\n";
-    ts << "<table class=\"vym-footer\">   \n\
+    stream << "<hr/>\n";
+    stream << "<table class=\"vym-footer\">   \n\
         <tr> \n\
         <td class=\"vym-footerL\">" + filePath + "</td> \n\
             <td class=\"vym-footerC\">" + model->getDate() + "</td> \n\
             <td class=\"vym-footerR\"> <a href='" + vymHome + "'>vym " + vymVersion + "</a></td> \n\
             </tr> \n \
             </table>\n";
-            ts << "</body></html>";
-    file.close();
+            stream << "</body></html>";
+    success = closeOutput();
 
     if (!dia.postscript.isEmpty())
     {
@@ -425,8 +393,6 @@ void ExportHTML::doExport(bool useDialog)
 
     destination = filePath;
 
-    success = true;
-
     QMap <QString, QString> args;
     args["filePath"] = filePath;
     args["dirPath"]  = dirPath;
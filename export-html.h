@@ -10,11 +10,16 @@ public:
     ExportHTML();
     ExportHTML(VymModel *m);
     virtual void init();
-    virtual QString createTOC();
+    virtual void createTOC();
     virtual void doExport(bool useDialog=true);
+protected:
+    virtual void beginList (const BranchState &first);
+    virtual void endList (const BranchState &last);
+    virtual bool visitBranch (BranchItem *current, const BranchState &state);
+    virtual void leaveBranch (BranchItem *current, const BranchState &state);
 private:
-    QString getBranchText(BranchItem *);
-    QString buildList (BranchItem *);
+    QString getBranchText(BranchItem *, const BranchState &state);
+    bool tocPass;           // Walk branches for table of contents
     QString imageMap;
     QString cssSrc;
     QString cssDst;
@@ -18,57 +18,50 @@ ExportOO::~ExportOO()
 {
 }   
 
-QString ExportOO::buildList (TreeItem *current)
+void ExportOO::beginList (const BranchState &)
 {
-    QString r;
+    stream << "<text:list text:style-name=\"vym-list\">\n";
+}
 
-    uint i=0;
-    BranchItem *bi=current->getFirstBranch();
-    if (bi)
-    {
-        // Start list
-        r+="<text:list text:style-name=\"vym-list\">\n";
-        while (bi)
-        {
-            if (!bi->hasHiddenExportParent() )
-            {
-                r += "<text:list-item><text:p >";
-                r += quotemeta(bi->getHeadingPlain());
-                // If necessary, write note
-                if (! bi->isNoteEmpty())
-                    r += "<text:line-break/>" + bi->getNoteASCII();
-                r += "</text:p>";
-                r += buildList (bi);  // recursivly add deeper branches
-                r += "</text:list-item>\n";
-            }
-            i++;
-            bi = current->getBranchNum(i);
-        }
-        r += "</text:list>\n";
-    }
-    return r;
+void ExportOO::endList (const BranchState &)
+{
+    stream << "</text:list>\n";
 }
 
+bool ExportOO::visitBranch (BranchItem *bi, const BranchState &)
+{
+    stream << "<text:list-item><text:p >";
+    stream << quotemeta(bi->getHeadingPlain());
+    // If necessary, write note
+    if (! bi->isNoteEmpty())
+        stream << "<text:line-break/>" + bi->getNoteASCII();
+    stream << "</text:p>";
+    return true;    // recursivly add deeper branches
+}
 
-void ExportOO::exportPresentation()
+void ExportOO::leaveBranch (BranchItem *, const BranchState &)
 {
-    QString allPages;
+    stream << "</text:list-item>\n";
+}
 
-    BranchItem *firstMCO=(BranchItem*)(model->getRootItem()->getFirstBranch());
-    if (!firstMCO)
+void ExportOO::writePage (const QString &heading, BranchItem *listBI)
+{
+    // Add page with list of items
+    QString onePage = pageTemplate;
+    onePage.replace ("<!-- INSERT PAGE HEADING -->", quotemeta (heading) );
+    int i = onePage.indexOf ("<!-- INSERT LIST -->");
+    if (!listBI || i < 0) 
     {
-        QMessageBox::critical (0,QObject::tr("Critical Export Error"),QObject::tr("No objects in map!"));
+        stream << onePage;
         return;
     }
+    stream << onePage.left (i);
+    walkBranches (listBI);
+    stream << onePage.mid (i + QString("<!-- INSERT LIST -->").length() );
+}
 
-    // Insert new content
-    // FIXME add extra title in mapinfo for vym 1.13.x
-    content.replace ("<!-- INSERT TITLE -->",quotemeta(firstMCO->getHeadingPlain()));
-    content.replace ("<!-- INSERT AUTHOR -->",quotemeta(model->getAuthor()));
-
-    QString onePage;
-    QString list;
-    
+void ExportOO::writePages (BranchItem *firstMCO)
+{
     BranchItem *sectionBI;
     int i=0;
     BranchItem *pagesBI;
@@ -88,9 +81,9 @@ void ExportOO::exportPresentation()
         if (useSections)
         {
             // Add page with section title
-            onePage=sectionTemplate;
+            QString onePage=sectionTemplate;
             onePage.replace ("<!-- INSERT PAGE HEADING -->", quotemeta(sectionBI->getHeadingPlain() ) );
-            allPages+=onePage;
+            stream << onePage;
             pagesBI=sectionBI->getFirstBranch();
         } else
         {
@@ -104,11 +97,7 @@ void ExportOO::exportPresentation()
         while (pagesBI && !pagesBI->hasHiddenExportParent() )
         {
             // Add page with list of items
-            onePage=pageTemplate;
-            onePage.replace ("<!-- INSERT PAGE HEADING -->", quotemeta (pagesBI->getHeadingPlain() ) );
-            list=buildList (pagesBI);
-            onePage.replace ("<!-- INSERT LIST -->", list);
-            allPages+=onePage;
+            writePage (pagesBI->getHeadingPlain(), pagesBI);
             if (pagesBI!=sectionBI)
             {
                 j++;
@@ -122,23 +111,40 @@ void ExportOO::exportPresentation()
         else
             sectionBI=firstMCO->getBranchNum (i);
     }
-    
-    content.replace ("<!-- INSERT PAGES -->",allPages);
+}
 
-    // Write modified content
-    QFile f (contentFile);
-    if ( !f.open( QIODevice::WriteOnly ) )
+void ExportOO::exportPresentation()
+{
+    BranchItem *firstMCO=(BranchItem*)(model->getRootItem()->getFirstBranch());
+    if (!firstMCO)
+    {
+        QMessageBox::critical (0,QObject::tr("Critical Export Error"),QObject::tr("No objects in map!"));
+        return;
+    }
+
+    // Insert new content
+    // FIXME add extra title in mapinfo for vym 1.13.x
+    content.replace ("<!-- INSERT TITLE -->",quotemeta(firstMCO->getHeadingPlain()));
+    content.replace ("<!-- INSERT AUTHOR -->",quotemeta(model->getAuthor()));
+
+    // Write modified content, pages are streamed directly into file
+    if (!openOutput (contentFile)) return;
+    int pagesPos = content.indexOf ("<!-- INSERT PAGES -->");
+    if (pagesPos < 0)
+        stream << content;  // No place for pages in template
+    else
+    {
+        stream << content.left (pagesPos);
+        writePages (firstMCO);
+        stream << content.mid (pagesPos + QString("<!-- INSERT PAGES -->").length() );
+    }
+    if (!closeOutput())
     {
         QMessageBox::critical (0,QObject::tr("Critical Export Error"),QObject::tr("Could not write %1").arg(contentFile));
         mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
         return;
     }
 
-    QTextStream t( &f );
-    t.setCodec("UTF-8");
-    t << content;
-    f.close();
-
     // zip tmpdir to destination
     zipDir (tmpDir,filePath);
 
@@ -10,8 +10,14 @@ public:
     ~ExportOO();
     void exportPresentation();
     bool setConfigFile (const QString &);
+protected:
+    virtual void beginList (const BranchState &first);
+    virtual void endList (const BranchState &last);
+    virtual bool visitBranch (BranchItem *bi, const BranchState &state);
+    virtual void leaveBranch (BranchItem *bi, const BranchState &state);
 private:
-    QString buildList (TreeItem *);
+    void writePage (const QString &heading, BranchItem *listBI);
+    void writePages (BranchItem *firstMCO);
     bool useSections;
     QString configFile;
     QString configDir;
@@ -47,18 +47,10 @@ void ExportLaTeX::doExport()
     // or inported into a LaTex document
     // it will not add a preamble, or anything
     // that makes a full LaTex document.
-    QFile file (filePath);
-    if ( !file.open( QIODevice::WriteOnly ) ) {
-        QMessageBox::critical (
-                    0,
-                    QObject::tr("Critical Export Error"),
-                    QObject::tr("Could not export as LaTeX to %1").arg(filePath));
-        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
-        return;
-    }
+    if (!openOutput (filePath)) return;
 
     // Read default section names
-    QStringList sectionNames;
+    sectionNames.clear();
     sectionNames << ""
                  << "chapter"
                  << "section"
@@ -70,47 +62,31 @@ void ExportLaTeX::doExport()
         sectionNames.replace(i,settings.value(
                                  QString("/export/latex/sectionName-%1").arg(i),sectionNames.at(i)).toString() );
 
-    QString out;
-
     // Main loop over all branches
-    QString s;
-    BranchItem *cur=NULL;
-    BranchItem *prev=NULL;
-    model->nextBranch(cur,prev);
-    while (cur)
-    {
-        if (!cur->hasHiddenExportParent() )
-        {
-            int d=cur->depth();
-            s=escapeLaTeX (cur->getHeadingPlain() );
-            if ( sectionNames.at(d).isEmpty() || d>=sectionNames.count() )
-                out += s + "\n";
-            else
-            {
-                out += "\n";
-                out += "\\" + sectionNames.at(d) + "{" + s + "}";
-                out += "\n";
-            }
-            // If necessary, write note
-            if (!cur->isNoteEmpty()) {
-                out += (cur->getNoteASCII());
-                out += "\n";
-            }
-        }
-        model->nextBranch(cur,prev);
-    }
-    
-    QTextStream ts( &file );
-    ts.setCodec("UTF-8");
-    ts << out;
-    file.close();
-
-    QClipboard *clipboard = QGuiApplication::clipboard();
-    clipboard->setText(out);
+    walkBranches();
     
-    success = true;
+    success = closeOutput();
 
     destination = filePath;
     completeExport();
 }
 
+bool ExportLaTeX::visitBranch (BranchItem *cur, const BranchState &state)
+{
+    int d = state.depth;
+    QString s = escapeLaTeX (cur->getHeadingPlain() );
+    if ( d >= sectionNames.count() || sectionNames.at(d).isEmpty() )
+        stream << s + "\n";
+    else
+    {
+        stream << "\n";
+        stream << "\\" + sectionNames.at(d) + "{" + s + "}";
+        stream << "\n";
+    }
+    // If necessary, write note
+    if (!cur->isNoteEmpty()) {
+        stream << (cur->getNoteASCII());
+        stream << "\n";
+    }
+    return true;
+}
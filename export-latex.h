@@ -9,8 +9,11 @@ public:
     ExportLaTeX();
     QString escapeLaTeX (const QString &s);
     virtual void doExport();
+protected:
+    virtual bool visitBranch (BranchItem *cur, const BranchState &state);
 private:
     QHash <QString,QString> esc;
+    QStringList sectionNames;
 };  
 
 #endif
@@ -9,6 +9,10 @@ public:
     ExportMarkdown();
     virtual void doExport();
     virtual QString underline (const QString &text, const QString &line);
+protected:
+    virtual bool visitBranch (BranchItem *cur, const BranchState &state);
+    int lastDepth;
+    QStringList tasks;
 };
 
 #endif
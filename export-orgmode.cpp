@@ -16,43 +16,26 @@ void ExportOrgMode::doExport()
     // Exports a map to an org-mode file.
     // This file needs to be read
     // by EMACS into an org mode buffer
-    QFile file (filePath);
-    if ( !file.open( QIODevice::WriteOnly ) )
-    {
-        QMessageBox::critical (0, QObject::tr("Critical Export Error"), QObject::tr("Could not export as OrgMode to %1").arg(filePath));
-        mainWindow->statusMessage(QString(QObject::tr("Export failed.")));
-        return;
-    }
-    QTextStream ts( &file );
-    ts.setCodec("UTF-8");
+    if (!openOutput (filePath)) return;
 
     // Main loop over all branches
-    QString s;
-    int i;
-    BranchItem *cur=NULL;
-    BranchItem *prev=NULL;
-    model->nextBranch(cur,prev);
-    while (cur)
-    {
-        if (!cur->hasHiddenExportParent() )
-        {
-            for(i=0;i<=cur->depth();i++)
-                ts << ("*");
-            ts << (" " + cur->getHeadingPlain()+ "\n");
-            // If necessary, write note
-            if (!cur->isNoteEmpty())
-            {
-                ts << (cur->getNoteASCII());
-                ts << ("\n");
-            }
-        }
-        model->nextBranch(cur,prev);
-    }
-    file.close();
+    walkBranches();
 
-    success = true;
+    success = closeOutput();
 
     destination = filePath;
     completeExport();
 }
 
+bool ExportOrgMode::visitBranch (BranchItem *cur, const BranchState &state)
+{
+    stream << QString (state.depth + 1, '*');
+    stream << (" " + cur->getHeadingPlain()+ "\n");
+    // If necessary, write note
+    if (!cur->isNoteEmpty())
+    {
+        stream << (cur->getNoteASCII());
+        stream << ("\n");
+    }
+    return true;
+}
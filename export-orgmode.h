@@ -8,6 +8,8 @@ class ExportOrgMode:public ExportBase
 public:
     ExportOrgMode();
     virtual void doExport();
+protected:
+    virtual bool visitBranch (BranchItem *cur, const BranchState &state);
 };  
 
 #endif
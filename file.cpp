@@ -393,13 +393,8 @@ ErrorCode zipDir ( QDir zipInputDir, QString zipName)
     return err;	
 }
 
-File::ErrorCode unzipDir ( QDir zipOutputDir, QString zipName)
+static void startUnzip (VymProcess *zipProc, QDir zipOutputDir, const QString &zipName, QStringList &args)
 {
-    ErrorCode err=Success;
-
-    VymProcess *zipProc = new VymProcess ();
-    QStringList args;
-
 #if defined(Q_OS_WIN32)
     zipProc->setWorkingDirectory (QDir::toNativeSeparators(zipOutputDir.path() + "\\") );
     args << "-o" + zipOutputDir.path() << "x" << zipName.toUtf8() << "-scsUTF-8";
@@ -413,6 +408,16 @@ File::ErrorCode unzipDir ( QDir zipOutputDir, QString zipName)
 
     zipProc->start (unzipToolPath, args);
 #endif
+}
+
+File::ErrorCode unzipDir ( QDir zipOutputDir, QString zipName)
+{
+    ErrorCode err=Success;
+
+    VymProcess *zipProc = new VymProcess ();
+    QStringList args;
+    startUnzip (zipProc, zipOutputDir, zipName, args);
+
     if (!zipProc->waitForStarted() )
     {
         QMessageBox::critical( 0, QObject::tr( "Critical Error" ),
@@ -456,6 +461,19 @@ File::ErrorCode unzipDir ( QDir zipOutputDir, QString zipName)
     return err;
 }
 
+File::ErrorCode unzipDirQuiet ( QDir zipOutputDir, QString zipName)
+{
+    // Also used in worker threads: No dialogs, every problem is
+    // reported as Aborted. Callers may retry with unzipDir for details.
+    VymProcess zipProc;
+    QStringList args;
+    startUnzip (&zipProc, zipOutputDir, zipName, args);
+
+    if (!zipProc.waitForStarted() || !zipProc.waitForFinished (-1) ) return Aborted;
+    if (zipProc.exitStatus() != QProcess::NormalExit || zipProc.exitCode() != 0) return Aborted;
+    return Success;
+}
+
 bool loadStringFromDisk (const QString &fname, QString &s)
 {
     s="";
@@ -33,6 +33,7 @@ bool checkZipTool();
 bool checkUnzipTool();
 File::ErrorCode zipDir (QDir , QString);
 File::ErrorCode unzipDir (QDir , QString);
+File::ErrorCode unzipDirQuiet (QDir , QString);
 
 bool loadStringFromDisk (const QString &fn, QString &s);
 bool saveStringToDisk (const QString &fn, const QString &s);
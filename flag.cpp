@@ -5,6 +5,8 @@
 /////////////////////////////////////////////////////////////////
 // Flag
 /////////////////////////////////////////////////////////////////
+QHash <QString, QPixmap> Flag::pixmapCache;
+
 Flag::Flag()
 {
     //qDebug() << "Const Flag ()";
@@ -48,18 +50,21 @@ void Flag::copy (Flag* other)
     tooltip=other->tooltip;
     state=other->state;
     used=other->used;
+    path=other->path;
     pixmap=other->pixmap;
 }
 
 
 void Flag::load (const QString &fn)
 {
-    if (!pixmap.load(fn))
-	qDebug()<<"Flag::load ("<<fn<<") failed.";
+    // Decoding is deferred until getPixmap() is called
+    path=fn;
+    pixmap=QPixmap();
 }
 
 void Flag::load (const QPixmap &pm)
 {
+    path.clear();
     pixmap=pm;
 }
 
@@ -110,9 +115,30 @@ const QString Flag::getToolTip()
 
 QPixmap Flag::getPixmap()
 {
+    if (pixmap.isNull() && !path.isEmpty() )
+    {
+	if (pixmapCache.contains (path))
+	    pixmap=pixmapCache.value (path);
+	else
+	{
+	    if (!pixmap.load(path))
+		qDebug()<<"Flag::load ("<<path<<") failed.";
+	    pixmapCache.insert (path, pixmap);
+	}
+    }
     return pixmap;
 }
 
+void Flag::clearPixmapCache()
+{
+    pixmapCache.clear();
+}
+
+const QString Flag::getPath()
+{
+    return path;
+}
+
 void Flag::setAction (QAction *a)
 {
     action=a;
@@ -136,7 +162,7 @@ bool Flag::isUsed()
 void Flag::saveToDir (const QString &tmpdir, const QString &prefix)
 {
     QString fn=tmpdir + prefix + name + ".png";
-    pixmap.save (fn,"PNG");
+    getPixmap().save (fn,"PNG");
 }
 
 
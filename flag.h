@@ -3,6 +3,7 @@
 
 
 #include <QAction>
+#include <QHash>
 #include <QPixmap>
 
 #include "xmlobj.h"
@@ -10,7 +11,8 @@
 /*! \brief One flag belonging to a FlagRow.
 
     Each TreeItem in a VymModel has a set of standard flags and system
-    flags.
+    flags. Flags loaded from a file are decoded only when the pixmap
+    is needed for the first time.
 */
 
 
@@ -35,11 +37,13 @@ public:
     void setToolTip(const QString&);
     const QString getToolTip();
     QPixmap getPixmap();
+    const QString getPath();	//! Empty, if pixmap was not loaded from file
     void setAction (QAction *a);
     QAction* getAction ();
     void setUsed (bool);    //FIXME-3 needed?
     bool isUsed();
     void saveToDir (const QString&, const QString&);
+    static void clearPixmapCache();	//! Called before QApplication is destroyed
     
 protected:  
     QString name;
@@ -50,7 +54,10 @@ protected:
     bool state;
     bool used;
 private:
+    QString path;
     QPixmap pixmap;
+
+    static QHash <QString, QPixmap> pixmapCache;    //! Decoded pixmaps by path
 };
 
 #endif
@@ -24,34 +24,55 @@ void FlagRow::addFlag (Flag *flag)
     Flag *f=new Flag;
 ;
     f->copy (flag);
+    flagIDs.insert (f->getName(), flags.size() );
+    setActive (flags.size(), true);
     flags.append (f);
-    activeNames.append (flag->getName());
 }
 
 Flag* FlagRow::getFlag (const QString &name)
 {
-    int i=0;
-    while (i<=flags.size()-1)
-    {
-	if (flags.at(i)->getName()==name)
-	    return flags.at(i);
-	i++;	
-    }
+    return getFlag (flagIDs.value (name, -1) );
+}
+
+Flag* FlagRow::getFlag (int id)
+{
+    if (id >= 0 && id < flags.size() )
+	return flags.at(id);
     return NULL;
 }
 
+int FlagRow::getFlagID (const QString &name)
+{
+    if (masterRow) return masterRow->getFlagID (name);
+    return flagIDs.value (name, -1);
+}
+
 QStringList FlagRow::activeFlagNames()
 {
-    return activeNames;
+    // Translate IDs back to names, only needed for I/O
+    QStringList list;
+    FlagRow *row = masterRow ? masterRow : this;
+    for (int i=0; i<activeIDs.size(); ++i)
+    {
+	Flag *flag=row->getFlag (i);
+	if (activeIDs.testBit(i) && flag) list.append (flag->getName() );
+    }
+    return list;
 }
 
+QBitArray FlagRow::activeFlagIDs()
+{
+    return activeIDs;
+}
 
 bool FlagRow::isActive (const QString &name)	
 {
-    QString n;
-    foreach (n,activeNames)
-	if (n==name) return true;
-    return false;   
+    return isActive (getFlagID (name) );
+}
+
+bool FlagRow::isActive (int id)
+{
+    return id >= 0 && id < activeIDs.size() && activeIDs.testBit (id);
 }
 
 bool FlagRow::toggle (const QString &name, FlagRow *masterRow)
@@ -65,15 +86,18 @@ bool FlagRow::toggle (const QString &name, FlagRow *masterRow)
 	// Deactivate group
 	if (!masterRow) return false;
 
-	Flag *flag=masterRow->getFlag (name);
+	int id=masterRow->getFlagID (name);
+	Flag *flag=masterRow->getFlag (id);
 	if (!flag) return false;
 	QString mygroup=flag->getGroup();
+	if (mygroup.isEmpty() ) return true;
 
-	for (int i=0;i<activeNames.size();++i)
+	for (int i=0;i<activeIDs.size();++i)
 	{
-	    flag=masterRow->getFlag (activeNames.at(i) );
-	    if (name!=activeNames.at(i) && !mygroup.isEmpty() && mygroup==flag->getGroup())
-		deactivate (activeNames.at(i));
+	    if (i==id || !activeIDs.testBit(i) ) continue;
+	    flag=masterRow->getFlag (i);
+	    if (flag && mygroup==flag->getGroup())
+		setActive (i, false);
 	}
 	return true;
     }
@@ -81,12 +105,6 @@ bool FlagRow::toggle (const QString &name, FlagRow *masterRow)
 
 bool FlagRow::activate (const QString &name)
 {
-    if (isActive (name)) 
-    {
-	if (debug) qWarning ()<<QString("FlagRow::activate - %1 is already active").arg(name);
-	return false;
-    }
-
     if (!masterRow)
     {
 	qWarning()<<"FlagRow::activate - no masterRow to activate "<<name;
@@ -94,24 +112,30 @@ bool FlagRow::activate (const QString &name)
     }
 
     // Check, if flag exists after all...
-    Flag *flag=masterRow->getFlag (name);
-    if (!flag)
+    int id=masterRow->getFlagID (name);
+    if (id<0)
     {
 	qWarning()<<"FlagRow::activate - flag "<<name<<" does not exist here!";
 	return false;
     }
 
-    activeNames.append (name);
+    if (isActive (id)) 
+    {
+	if (debug) qWarning ()<<QString("FlagRow::activate - %1 is already active").arg(name);
+	return false;
+    }
+
+    setActive (id, true);
     return true;
 }
 
 
 bool FlagRow::deactivate (const QString &name)
 {
-    int n=activeNames.indexOf (name);
-    if (n>=0)
+    int id=getFlagID (name);
+    if (isActive (id) )
     {
-	activeNames.removeAt(n);
+	setActive (id, false);
 	return true;
     }
     if (debug) 
@@ -124,18 +148,19 @@ bool FlagRow::deactivateGroup (const QString &gname)
     if (!masterRow) return false;
     if (gname.isEmpty()) return false;
 
-    foreach (QString s, activeNames )
+    for (int i=0; i<activeIDs.size(); ++i)
     {
-	Flag *flag=masterRow->getFlag (s);
+	if (!activeIDs.testBit(i) ) continue;
+	Flag *flag=masterRow->getFlag (i);
 	if (flag && gname == flag->getGroup())
-	    deactivate (s);
+	    setActive (i, false);
     }
     return true;
 }
 
 void FlagRow::deactivateAll ()
 {
-    if (!toolBar) activeNames.clear();
+    if (!toolBar) activeIDs.clear();
 }
 
 void FlagRow::setEnabled (bool b)
@@ -156,14 +181,16 @@ QString FlagRow::saveToDir (const QString &tmpdir,const QString &prefix, bool wr
     
     if (!toolBar)
     {
-	if (!activeNames.isEmpty())
-	for (int i=0; i<activeNames.size(); ++i)
+	for (int i=0; i<activeIDs.size(); ++i)
 	{
+	    if (!activeIDs.testBit(i) ) continue;
+	    Flag *flag=masterRow->getFlag (i);
+
 	    // save flag to xml, if flag is set 
-	    s+=valueElement("standardflag",activeNames.at(i));
+	    s+=valueElement("standardflag",flag->getName() );
 
 	    // and tell parentRow, that this flag is used   
-	    masterRow->getFlag(activeNames.at(i))->setUsed(true);
+	    flag->setUsed(true);
 	}   
     } else
 	// Save icons to dir, if verbose is set (xml export)
@@ -190,19 +217,41 @@ void FlagRow::setMasterRow (FlagRow *row)
     masterRow=row; 
 }
 
+FlagRow* FlagRow::getMasterRow ()
+{
+    return masterRow; 
+}
+
 void FlagRow::updateToolBar (const QStringList &activeNames)
 {
     if (toolBar )
     {
 	for (int i=0;i<flags.size();++i)
 	    flags.at(i)->getAction()->setChecked (false);
-	for (int i=0;i<flags.size();++i)
+	foreach (QString name, activeNames)
 	{
-	    int n=activeNames.indexOf (flags.at(i)->getName());
-	    if (n>=0)
-		flags.at(i)->getAction()->setChecked (true);	
+	    Flag *flag=getFlag (name);
+	    if (flag) flag->getAction()->setChecked (true);	
 	}
     }
 }
 
-
+void FlagRow::setActive (int id, bool b)
+{
+    if (b)
+    {
+	if (id >= activeIDs.size() ) activeIDs.resize (id + 1);
+	activeIDs.setBit (id);
+    } else if (id < activeIDs.size() )
+    {
+	activeIDs.clearBit (id);
+
+	// Keep bitset minimal, so that rows can be compared directly
+	int n=activeIDs.size();
+	while (n>0 && !activeIDs.testBit (n-1) ) n--;
+	if (n==0)
+	    activeIDs.clear();
+	else
+	    activeIDs.resize (n);
+    }
+}
@@ -1,6 +1,8 @@
 #ifndef FLAGROW_H
 #define FLAGROW_H
 
+#include <QBitArray>
+#include <QHash>
 #include <QStringList>
 #include <QToolBar>
 
@@ -12,6 +14,11 @@
    A toolbar can be created from the flags in this row.
    The data needed for represention in a vym map 
    is stored in FlagRowObj.
+
+   Only the master rows own Flag objects. Each flag name is mapped 
+   to its position in the master row, which is used as ID.
+   All other rows just keep a bitset of active IDs, names are only
+   used when saving or loading.
  */
 
 class FlagRow:public XMLObj {
@@ -20,8 +27,12 @@ public:
     ~FlagRow ();
     void addFlag (Flag *flag);
     Flag *getFlag (const QString &name);
+    Flag *getFlag (int id);
+    int getFlagID (const QString &name);
     QStringList  activeFlagNames();
+    QBitArray activeFlagIDs();
     bool isActive(const QString &name);
+    bool isActive(int id);
 
     /*! \brief Toggle a Flag 
 	
@@ -38,14 +49,18 @@ public:
     void setName (const QString&);	    // prefix for exporting flags to dir
     void setToolBar   (QToolBar *tb);
     void setMasterRow (FlagRow *row);
+    FlagRow* getMasterRow ();
     void updateToolBar(const QStringList &activeNames);
 
 private:    
+    void setActive (int id, bool b);
+
     QToolBar *toolBar;
     FlagRow *masterRow;
     QList <Flag*> flags; 
-    QStringList activeNames;	//! Lists all names of currently active flags
-    QString rowName;		//! Name of this collection of flags
+    QHash <QString, int> flagIDs;   //! Maps names to position in flags
+    QBitArray activeIDs;	    //! Bitset of currently active flags
+    QString rowName;		    //! Name of this collection of flags
 };
 #endif
 
@@ -2,6 +2,7 @@
 #include <QToolBar>
 
 #include "flag.h"
+#include "flagrow.h"
 #include "flagrowobj.h"
 
 #include "geometry.h"
@@ -31,6 +32,7 @@ FlagRowObj::~FlagRowObj()
 void FlagRowObj::init ()
 {
     showFlags=true;
+    shownIDsValid=false;
 }
 
 void FlagRowObj::copy (FlagRowObj* other)
@@ -142,6 +144,7 @@ void FlagRowObj::activate (Flag *flag)
 	else
 	    fo->setVisibility (false);
 	calcBBoxSize();
+	shownIDsValid=false;
     }
 }
 
@@ -152,11 +155,39 @@ void FlagRowObj::deactivate (const QString &foname)
     {
 	flag.removeAll(fo);
 	delete (fo);
+	shownIDsValid=false;
     }	
     calcBBoxSize();
     positionBBox();
 }
 
+void FlagRowObj::updateFlags (FlagRow *row)
+{
+    QBitArray activeIDs=row->activeFlagIDs();
+    if (shownIDsValid && activeIDs==shownIDs) return;
+
+    FlagRow *master=row->getMasterRow();
+    if (!master) return;
+
+    // Remove flags no longer active in row
+    for (int i=flag.size()-1; i>=0; --i)
+	if (!row->isActive (flag.at(i)->getName() ))
+	    delete (flag.takeAt(i));
+
+    // Add missing flags
+    for (int i=0; i<activeIDs.size(); ++i)
+    {
+	if (!activeIDs.testBit(i) ) continue;
+	Flag *f=master->getFlag (i);
+	if (f && !findFlag (f->getName() )) activate (f);
+    }
+
+    shownIDs=activeIDs;
+    shownIDsValid=true;
+    calcBBoxSize();
+    positionBBox();
+}
+
 void FlagRowObj::setShowFlags (bool b)
 {
     showFlags=b;
@@ -1,12 +1,14 @@
 #ifndef FLAGROWOBJ_H
 #define FLAGROWOBJ_H
 
+#include <QBitArray>
 #include <QMainWindow>
 
 //#include "mapobj.h"
 #include "flagobj.h"
 
 class Flag;
+class FlagRow;
 
 /*! \brief A collection of flags (FlagObj) in a map. 
 
@@ -32,10 +34,13 @@ public:
     bool isActive(const QString&);
     void activate (Flag *flag);
     void deactivate(const QString&);
+    void updateFlags (FlagRow *row);	    // Sync with active flags of TreeItem
     void setShowFlags (bool);
     FlagObj* findFlag (const QString&);
 private:    
     QList <FlagObj*> flag; 
     bool showFlags;			    // FloatObjects want to hide their flags
+    QBitArray shownIDs;			    // IDs of flags synced by updateFlags
+    bool shownIDsValid;
 };
 #endif
@@ -62,6 +62,18 @@ void FloatImageObj::load (const QImage &img)
     positionBBox();
 }
 
+void FloatImageObj::load (const QString &key, const QByteArray &data, const QString &format, const QSize &size)
+{
+    // Pixmaps are taken from ImageCache when painting
+    icon->load(key, data, format, size);
+    if (!icon->parentItem() ) icon->setParentItem(this);  // Add to scene initially
+    bbox.setSize ( QSizeF(
+            icon->boundingRect().width(), 
+            icon->boundingRect().height()));
+    clickPoly=bbox;
+    positionBBox();
+}
+
 void FloatImageObj::setParObj (QGraphicsItem *p)
 {
     setParentItem (p);
@@ -18,6 +18,7 @@ public:
     virtual int z();
 
     virtual void load (const QImage &);
+    virtual void load (const QString &key, const QByteArray &data, const QString &format, const QSize &size);
     virtual void setParObj (QGraphicsItem*);
     virtual void setVisibility(bool);	    // set vis. for w
     virtual void moveCenter (double x,double y);
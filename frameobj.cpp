@@ -9,6 +9,10 @@
 /////////////////////////////////////////////////////////////////
 // FrameObj
 /////////////////////////////////////////////////////////////////
+QHash <QString, QPainterPath> FrameObj::outlineCache;
+int FrameObj::outlineCacheHits = 0;
+int FrameObj::outlineCacheMisses = 0;
+
 FrameObj::FrameObj(QGraphicsItem *parent) :MapObj(parent)
 {
     init ();
@@ -51,6 +55,7 @@ void FrameObj::clear()
     type=NoFrame;
     padding=0;	// No frame requires also no padding
     xsize=0;
+    frameSize=QSizeF();
 }
 
 void FrameObj::move(double x, double y)
@@ -90,99 +95,140 @@ void FrameObj::calcBBoxSize()
 void FrameObj::setRect(const QRectF &r)
 {
     bbox=r;
+
+    // Geometry is relative to the top left corner. If only the position
+    // changes, which is the case while moving a branch, just move the item
+    bool resized = (bbox.size() != frameSize);
+    frameSize = bbox.size();
+    QRectF geom (0, 0, bbox.width(), bbox.height() );
     switch (type)
 	{
 	case NoFrame:
 	    break;
 
 	case Rectangle:
-	    rectFrame->setRect (QRectF(bbox.x(),bbox.y(),bbox.width(),bbox.height() ));
+	    if (resized) rectFrame->setRect (geom);
+	    rectFrame->setPos (bbox.topLeft() );
 	    break;
 
 	case RoundedRectangle:
-	{
-	    QPointF tl = bbox.topLeft();
-	    QPointF tr = bbox.topRight();
-	    QPointF bl = bbox.bottomLeft();
-	    QPointF br = bbox.bottomRight();
-	    QPainterPath path;
-
-	    qreal n = 10;
-	    path.moveTo (tl.x() +n/2, tl.y());
-
-	    // Top path
-	    path.lineTo (tr.x()-n, tr.y());
-	    path.arcTo  (tr.x()-n, tr.y(), n, n,90,-90);
-	    path.lineTo (br.x()  , br.y()-n);
-	    path.arcTo  (br.x()-n, br.y()-n, n, n,0,-90);
-	    path.lineTo (bl.x()+n, br.y());
-	    path.arcTo  (bl.x()  , bl.y()-n, n, n,-90,-90);
-	    path.lineTo (tl.x()  , tl.y()+n);
-	    path.arcTo  (tl.x()  , tl.y(), n, n,180,-90);
-	    pathFrame->setPath(path);
-	}
+	    if (resized) pathFrame->setPath (getOutline (type, bbox.size() ));
+	    pathFrame->setPos (bbox.topLeft() );
 	    break;
+
 	case Ellipse:
-	    ellipseFrame->setRect (QRectF(bbox.x(),bbox.y(),bbox.width(),bbox.height() ));
+	    if (resized) ellipseFrame->setRect (geom);
+	    ellipseFrame->setPos (bbox.topLeft() );
             xsize = 20;//max(bbox.width(), bbox.height()) / 4;
 	    break;
 
 	case Cloud:
-	    QPointF tl = bbox.topLeft();
-	    QPointF tr = bbox.topRight();
-	    QPointF bl = bbox.bottomLeft();
-	    QPainterPath path;
-	    path.moveTo (tl);
-
-	    float w = bbox.width(); // width
-	    float h = bbox.height();// height
-	    int   n = w / 40;	    // number of intervalls
-	    float d = w / n;	    // width of interwall
-
-	    // Top path
-	    for (float i = 0; i < n; i++)
-	    {
-		path.cubicTo (
-		    tl.x() + i*d,     tl.y()- 100*roof ((i+0.5)/n) , 
-		    tl.x() + (i+1)*d, tl.y()- 100*roof ((i+0.5)/n) , 
-		    tl.x() + (i+1)*d + 20*roof ((i+1)/n), tl.y()- 50*roof((i+1)/n) );
-	    }
-	    // Right path
-	    n = h/20;
-	    d = h/n;
-	    for (float i = 0; i < n; i++)
-	    {
-		path.cubicTo (
-		    tr.x()+ 100*roof ((i+0.5)/n)        , tr.y() + i*d,
-		    tr.x()+ 100*roof ((i+0.5)/n)        , tr.y() + (i+1)*d,
-		    tr.x() + 60*roof ((i+1)/n)          , tr.y() + (i+1)*d );
-	    }
-	    n = w / 60;
-	    d = w / n;
-	    // Bottom path
-	    for (float i = n; i > 0; i--)
-	    {
-		path.cubicTo (
-		    bl.x() + i*d,  bl.y()+ 100*roof ((i-0.5)/n) , 
-		    bl.x() + (i-1)*d,      bl.y()+ 100*roof ((i-0.5)/n) , 
-		    bl.x() + (i-1)*d + 20*roof ((i-1)/n), bl.y()+ 50*roof((i-1)/n) );
-	    }
-	    // Left path
-	    n = h / 20;
-	    d = h / n;
-	    for (float i = n; i > 0; i--)
-	    {
-		path.cubicTo (
-		    tl.x()- 100*roof ((i-0.5)/n)        , tr.y() + i*d,
-		    tl.x()- 100*roof ((i-0.5)/n)        , tr.y() + (i-1)*d,
-		    tl.x()-  60*roof ((i-1)/n)          , tr.y() + (i-1)*d );
-	    }
-	    pathFrame->setPath(path);
+	    if (resized) pathFrame->setPath (getOutline (type, bbox.size() ));
+	    pathFrame->setPos (bbox.topLeft() );
             xsize = 50;
 	    break;
     }
 }
 
+QPainterPath FrameObj::getOutline (const FrameType &t, const QSizeF &size)
+{
+    // Paths are implicitly shared, so all frames 
+    // with same type and size use the same data
+    QString key = QString ("%1 %2 %3").arg(t).arg(size.width(), 0, 'f', 2).arg(size.height(), 0, 'f', 2);
+    if (outlineCache.contains (key) )
+    {
+	outlineCacheHits++;
+	return outlineCache.value (key);
+    }
+    outlineCacheMisses++;
+
+    QRectF r (0, 0, size.width(), size.height() );
+    QPainterPath path;
+    if (t == RoundedRectangle)
+    {
+	QPointF tl = r.topLeft();
+	QPointF tr = r.topRight();
+	QPointF bl = r.bottomLeft();
+	QPointF br = r.bottomRight();
+
+	qreal n = 10;
+	path.moveTo (tl.x() +n/2, tl.y());
+
+	// Top path
+	path.lineTo (tr.x()-n, tr.y());
+	path.arcTo  (tr.x()-n, tr.y(), n, n,90,-90);
+	path.lineTo (br.x()  , br.y()-n);
+	path.arcTo  (br.x()-n, br.y()-n, n, n,0,-90);
+	path.lineTo (bl.x()+n, br.y());
+	path.arcTo  (bl.x()  , bl.y()-n, n, n,-90,-90);
+	path.lineTo (tl.x()  , tl.y()+n);
+	path.arcTo  (tl.x()  , tl.y(), n, n,180,-90);
+    } else if (t == Cloud)
+    {
+	QPointF tl = r.topLeft();
+	QPointF tr = r.topRight();
+	QPointF bl = r.bottomLeft();
+	path.moveTo (tl);
+
+	float w = r.width(); // width
+	float h = r.height();// height
+	int   n = w / 40;	    // number of intervalls
+	float d = w / n;	    // width of interwall
+
+	// Top path
+	for (float i = 0; i < n; i++)
+	{
+	    path.cubicTo (
+		tl.x() + i*d,     tl.y()- 100*roof ((i+0.5)/n) , 
+		tl.x() + (i+1)*d, tl.y()- 100*roof ((i+0.5)/n) , 
+		tl.x() + (i+1)*d + 20*roof ((i+1)/n), tl.y()- 50*roof((i+1)/n) );
+	}
+	// Right path
+	n = h/20;
+	d = h/n;
+	for (float i = 0; i < n; i++)
+	{
+	    path.cubicTo (
+		tr.x()+ 100*roof ((i+0.5)/n)        , tr.y() + i*d,
+		tr.x()+ 100*roof ((i+0.5)/n)        , tr.y() + (i+1)*d,
+		tr.x() + 60*roof ((i+1)/n)          , tr.y() + (i+1)*d );
+	}
+	n = w / 60;
+	d = w / n;
+	// Bottom path
+	for (float i = n; i > 0; i--)
+	{
+	    path.cubicTo (
+		bl.x() + i*d,  bl.y()+ 100*roof ((i-0.5)/n) , 
+		bl.x() + (i-1)*d,      bl.y()+ 100*roof ((i-0.5)/n) , 
+		bl.x() + (i-1)*d + 20*roof ((i-1)/n), bl.y()+ 50*roof((i-1)/n) );
+	}
+	// Left path
+	n = h / 20;
+	d = h / n;
+	for (float i = n; i > 0; i--)
+	{
+	    path.cubicTo (
+		tl.x()- 100*roof ((i-0.5)/n)        , tr.y() + i*d,
+		tl.x()- 100*roof ((i-0.5)/n)        , tr.y() + (i-1)*d,
+		tl.x()-  60*roof ((i-1)/n)          , tr.y() + (i-1)*d );
+	}
+    }
+
+    // Paths still used by frames are kept alive by the frames
+    if (outlineCache.count() >= 1000) outlineCache.clear();
+    outlineCache.insert (key, path);
+    return path;
+}
+
+QString FrameObj::getOutlineCacheStats()
+{
+    return QString ("%1 outlines, %2 hits, %3 misses")
+	.arg(outlineCache.count())
+	.arg(outlineCacheHits)
+	.arg(outlineCacheMisses);
+}
+
 void FrameObj::setPadding (const int &i)
 {
     padding = i;
@@ -1,6 +1,9 @@
 #ifndef FRAMEOBJ_H
 #define FRAMEOBJ_H
 
+#include <QHash>
+#include <QPainterPath>
+
 #include "mapobj.h"
 
 
@@ -22,6 +25,8 @@ public:
     void positionBBox();	     
     void calcBBoxSize();	    
     void setRect (const QRectF &);   // set dimensions		
+    static QPainterPath getOutline (const FrameType &t, const QSizeF &size);
+    static QString getOutlineCacheStats();
     void setPadding(const int &);
     int getPadding();
     qreal getTotalPadding();         // padding + borderwidth + xsize (e.g. cloud)
@@ -55,6 +60,11 @@ private:
     QColor penColor;
     QColor brushColor;
     bool includeChildren;
+    QSizeF frameSize;	    //! Size of current outline, moving does not change it
+
+    static QHash <QString, QPainterPath> outlineCache;	//! Outlines of all frames, see getOutline
+    static int outlineCacheHits;
+    static int outlineCacheMisses;
 };
 #endif
 
@@ -0,0 +1,191 @@
+#include "headinglayout.h"
+
+#include <QAbstractTextDocumentLayout>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QRegularExpression>
+
+// Same margin as around the text of a QGraphicsTextItem
+static const qreal margin = 4;
+
+/////////////////////////////////////////////////////////////////
+// HeadingLayout
+/////////////////////////////////////////////////////////////////
+HeadingLayout::HeadingLayout (const QString &text, const QFont &f, int textwidth)
+{
+    font = f;
+    doc = NULL;
+    lineHeight = 0;
+
+    if (isRichText (text))
+    {
+	doc = new QTextDocument;
+	doc->setDefaultFont (font);
+	doc->setHtml (text);
+	size = doc->size();
+    } else
+    {
+	lineHeight = QFontMetricsF (font).height() + 2 * margin;
+	qreal w = 0;
+	foreach (QString s, wrapLines (text, textwidth))
+	{
+	    QStaticText st (s);
+	    st.setTextFormat (Qt::PlainText);
+	    st.setPerformanceHint (QStaticText::AggressiveCaching);
+	    st.prepare (QTransform(), font);
+	    if (w < st.size().width() ) w = st.size().width();
+	    lines.append (st);
+	}
+	size = QSizeF (w + 2 * margin, lineHeight * lines.count() );
+    }
+}
+
+HeadingLayout::~HeadingLayout()
+{
+    delete doc;
+}
+
+QSizeF HeadingLayout::getSize()
+{
+    return size;
+}
+
+void HeadingLayout::paint (QPainter *painter, const QColor &color)
+{
+    if (doc)
+    {
+	QAbstractTextDocumentLayout::PaintContext ctx;
+	ctx.palette.setColor (QPalette::Text, color);
+	doc->documentLayout()->draw (painter, ctx);
+    } else
+    {
+	painter->setFont (font);
+	painter->setPen (color);
+	for (int i = 0; i < lines.count(); ++i)
+	    painter->drawStaticText (QPointF (margin, margin + i * lineHeight), lines.at(i) );
+    }
+}
+
+bool HeadingLayout::isRichText (const QString &text)
+{
+    return text.startsWith("<html>") ||
+	text.startsWith("<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.0//EN\" \"http://www.w3.org/TR/REC-html40/strict.dtd\">");
+}
+
+QStringList HeadingLayout::wrapLines (const QString &text, int textwidth)
+{
+    // Manual linebreaks like <br/> always start a new line,
+    // otherwise words are wrapped to lines of textwidth characters
+    static const QRegularExpression re ("<br.*?/>");
+
+    QStringList result;
+    foreach (QString paragraph, text.split (re))
+    {
+	QString line;
+	foreach (QString word, paragraph.split (' '))
+	{
+	    if (line.isEmpty() )
+		line = word;
+	    else if (line.length() + 1 + word.length() <= textwidth)
+		line += " " + word;
+	    else
+	    {
+		result.append (line);
+		line = word;
+	    }
+	}
+	result.append (line);
+    }
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////
+// HeadingLayoutCache
+/////////////////////////////////////////////////////////////////
+HeadingLayoutCache::HeadingLayoutCache()
+{
+    pruneLimit = 1024;
+    hits = 0;
+    misses = 0;
+}
+
+QSharedPointer <HeadingLayout> HeadingLayoutCache::getLayout (const QString &text, const QFont &font, int textwidth)
+{
+    QString key = QString ("%1\n%2\n%3").arg(font.key()).arg(textwidth).arg(text);
+
+    QSharedPointer <HeadingLayout> layout = layouts.value (key).toStrongRef();
+    if (layout)
+    {
+	hits++;
+	return layout;
+    }
+
+    misses++;
+    layout = QSharedPointer <HeadingLayout> (new HeadingLayout (text, font, textwidth));
+    layouts.insert (key, layout);
+
+    if (layouts.count() > pruneLimit)
+    {
+	QHash <QString, QWeakPointer <HeadingLayout> >::iterator it = layouts.begin();
+	while (it != layouts.end() )
+	{
+	    if (it.value().isNull() )
+		it = layouts.erase (it);
+	    else
+		++it;
+	}
+	pruneLimit = qMax (1024, 2 * layouts.count() );
+    }
+    return layout;
+}
+
+int HeadingLayoutCache::getCount()
+{
+    return layouts.count();
+}
+
+int HeadingLayoutCache::getHits()
+{
+    return hits;
+}
+
+int HeadingLayoutCache::getMisses()
+{
+    return misses;
+}
+
+void HeadingLayoutCache::clear()
+{
+    layouts.clear();
+}
+
+/////////////////////////////////////////////////////////////////
+// HeadingTextItem
+/////////////////////////////////////////////////////////////////
+HeadingTextItem::HeadingTextItem (QGraphicsItem *parent) : QGraphicsItem (parent)
+{
+    color = Qt::black;
+}
+
+void HeadingTextItem::setLayout (QSharedPointer <HeadingLayout> l)
+{
+    prepareGeometryChange();
+    layout = l;
+    rect = QRectF (QPointF (0, 0), layout ? layout->getSize() : QSizeF() );
+}
+
+void HeadingTextItem::setColor (const QColor &c)
+{
+    color = c;
+    update();
+}
+
+QRectF HeadingTextItem::boundingRect() const
+{
+    return rect;
+}
+
+void HeadingTextItem::paint (QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
+{
+    if (layout) layout->paint (painter, color);
+}
@@ -0,0 +1,75 @@
+#ifndef HEADINGLAYOUT_H
+#define HEADINGLAYOUT_H
+
+#include <QFont>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QSharedPointer>
+#include <QStaticText>
+#include <QTextDocument>
+#include <QWeakPointer>
+
+/*! \brief Wrapped lines or rich text of a heading, ready for painting
+
+    Layouts are immutable and shared by all headings with the same
+    text, font and text width. The color is applied when painting.
+*/
+
+class HeadingLayout {
+public:
+    HeadingLayout (const QString &text, const QFont &font, int textwidth);
+    ~HeadingLayout();
+    QSizeF getSize();
+    void paint (QPainter *painter, const QColor &color);
+
+    static bool isRichText (const QString &text);
+    static QStringList wrapLines (const QString &text, int textwidth);
+
+private:
+    QFont font;
+    QList <QStaticText> lines;	//! Plain text, wrapped to textwidth
+    qreal lineHeight;
+    QTextDocument *doc;		//! Rich text
+    QSizeF size;
+};
+
+/*! \brief Layouts of headings currently used in all maps
+
+    Entries are kept as long as a heading uses them. Loading maps with
+    many identical headings or changing a heading back and forth
+    does not lay out text again.
+*/
+
+class HeadingLayoutCache {
+public:
+    HeadingLayoutCache();
+    QSharedPointer <HeadingLayout> getLayout (const QString &text, const QFont &font, int textwidth);
+    int getCount();
+    int getHits();
+    int getMisses();
+    void clear();
+
+private:
+    QHash <QString, QWeakPointer <HeadingLayout> > layouts;
+    int pruneLimit;	//! Remove unused entries when hash grows beyond this
+    int hits;
+    int misses;
+};
+
+/*! \brief Graphics item painting a shared HeadingLayout */
+
+class HeadingTextItem: public QGraphicsItem {
+public:
+    HeadingTextItem (QGraphicsItem *parent);
+    void setLayout (QSharedPointer <HeadingLayout> l);
+    void setColor (const QColor &c);
+    virtual QRectF boundingRect() const;
+    virtual void paint (QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+private:
+    QSharedPointer <HeadingLayout> layout;
+    QRectF rect;
+    QColor color;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef HEADINGOBJ_H
 #define HEADINGOBJ_H
 
+#include "headinglayout.h"
 #include "mapobj.h"
 
 /*! \brief The heading of an OrnamentedObj */
@@ -15,9 +16,6 @@ public:
     virtual void moveBy (double x,double y);    // move to relative Position
     virtual void positionBBox();
 	virtual void calcBBoxSize();
-private:
-//    QGraphicsSimpleTextItem* newLine(QString);		// generate new textline
-    QGraphicsTextItem* newLine(QString);		// generate new textline
 public:    
     virtual void setTransformOriginPoint (const QPointF &);
     virtual void setRotation (qreal const &a);
@@ -40,7 +38,7 @@ public:
 protected:
     QString heading;
     int textwidth;								// width for formatting text
-    QList <QGraphicsTextItem*> textline;
+    HeadingTextItem *textItem;					// paints layout shared via HeadingLayoutCache
     QColor color;
     QFont font;
 };
@@ -0,0 +1,111 @@
+#include "imagecache.h"
+
+#include <QDebug>
+
+extern bool debug;
+
+ImageCache::ImageCache()
+{
+    cache.setMaxCost (256 * 1024);
+}
+
+void ImageCache::setMaxSize (int kb)
+{
+    cache.setMaxCost (kb);
+}
+
+int ImageCache::getMaxSize()
+{
+    return cache.maxCost();
+}
+
+int ImageCache::getSize()
+{
+    return cache.totalCost();
+}
+
+int ImageCache::getCount()
+{
+    return cache.count();
+}
+
+void ImageCache::clear()
+{
+    cache.clear();
+    oversizeKey.clear();
+    oversize = Entry();
+}
+
+void ImageCache::insertImage (const QString &key, const QImage &img)
+{
+    if (key.isEmpty() || img.isNull() ) return;
+    Entry *e = new Entry;
+    e->image = img;
+    insert (key, e, cost (img.size(), img.depth() ));
+}
+
+QImage ImageCache::getImage (const QString &key, const QByteArray &data, const QString &format)
+{
+    Entry *e = find (key);
+    if (e) return e->image;
+
+    QImage img;
+    if (!img.loadFromData (data, qPrintable (format)) )
+    {
+	qWarning() << "ImageCache::getImage  failed to decode " << key;
+	return img;
+    }
+    if (debug) qDebug() << "ImageCache: decoded " << key << img.size();
+    insertImage (key, img);
+    return img;
+}
+
+QPixmap ImageCache::getPixmap (const QString &key, const QByteArray &data, const QString &format, const QSize &size)
+{
+    QString skey = sizeKey (key, size);
+    Entry *e = find (skey);
+    if (e) return e->pixmap;
+
+    // Scale from decoded image, which is kept for the next zoom level
+    QImage img = getImage (key, data, format);
+    if (img.isNull() ) return QPixmap();
+
+    e = new Entry;
+    if (img.size() == size)
+	e->pixmap = QPixmap::fromImage (img);
+    else
+	e->pixmap = QPixmap::fromImage (img.scaled (size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    QPixmap pm = e->pixmap;
+    insert (skey, e, cost (pm.size(), pm.depth() ));
+    return pm;
+}
+
+ImageCache::Entry* ImageCache::find (const QString &key)
+{
+    if (!oversizeKey.isEmpty() && key == oversizeKey) return &oversize;
+    return cache.object (key);
+}
+
+void ImageCache::insert (const QString &key, Entry *e, int c)
+{
+    // QCache would drop the entry right away and it would be
+    // decoded again for every paint
+    if (c > cache.maxCost() )
+    {
+	oversizeKey = key;
+	oversize = *e;
+	delete e;
+    } else
+	cache.insert (key, e, c);
+}
+
+QString ImageCache::sizeKey (const QString &key, const QSize &size)
+{
+    return QString ("%1@%2x%3").arg(key).arg(size.width()).arg(size.height());
+}
+
+int ImageCache::cost (const QSize &size, int depth)
+{
+    // Cost in kB, at least 1 to limit number of entries
+    return qMax (1, int ((qint64)size.width() * size.height() * depth / 8 / 1024));
+}
@@ -0,0 +1,48 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+
+/*! \brief Cache for decoded and scaled images of all maps
+
+    Images are kept encoded in ImageItem and only decoded when needed.
+    Decoded pixels and pixmaps scaled to the size currently needed for 
+    display are kept here and identified by the content hash of the
+    encoded data. If the memory budget is exceeded, the least recently 
+    used entries are dropped and later recreated from the encoded data.
+    A single entry larger than the whole budget is kept aside, until
+    the next one of that kind replaces it.
+*/
+
+class ImageCache {
+public:
+    ImageCache();
+    void setMaxSize (int kb);	//! Memory budget in kB
+    int getMaxSize();
+    int getSize();		//! Currently used memory in kB
+    int getCount();
+    void clear();
+
+    void insertImage (const QString &key, const QImage &img);
+    QImage getImage (const QString &key, const QByteArray &data, const QString &format);
+    QPixmap getPixmap (const QString &key, const QByteArray &data, const QString &format, const QSize &size);
+
+private:
+    struct Entry
+    {
+	QImage image;
+	QPixmap pixmap;
+    };
+    Entry* find (const QString &key);
+    void insert (const QString &key, Entry *e, int cost);
+    QString sizeKey (const QString &key, const QSize &size);
+    int cost (const QSize &size, int depth);
+
+    QCache <QString, Entry> cache;
+    QString oversizeKey;    //! Entry too large for cache
+    Entry oversize;
+};
+
+#endif
@@ -1,12 +1,19 @@
 #include "imageitem.h"
 
 #include "branchitem.h"
+#include "imagecache.h"
 #include "mapobj.h"	// z-values
 
+#include <QBuffer>
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QFile>
+#include <QImageReader>
 #include <QString>
 #include <iostream>
 
+extern ImageCache imageCache;
+
 bool isImage (const QString &fname)
 {
     QRegExp rx("(jpg|jpeg|png|xmp|gif|svg)$");
@@ -54,23 +61,80 @@ ImageItem::ImageType ImageItem::getImageType()
 
 void ImageItem::load(const QImage &img)
 {
-    originalImage=img;
-    if (mo) ((FloatImageObj*)mo)->load (originalImage);
+    // Encode once, the decoded pixels are only kept in the ImageCache
+    originalData.clear();
+    QBuffer buffer (&originalData);
+    buffer.open (QIODevice::WriteOnly);
+    img.save (&buffer, "PNG");
+    originalFormat = "png";
+    originalSize = img.size();
+    contentHash = QCryptographicHash::hash (originalData, QCryptographicHash::Sha1).toHex();
+    imageCache.insertImage (contentHash, img);
+    updateMO();
 }
 
 bool ImageItem::load(const QString &fname)
 {
-    bool ok = originalImage.load (fname);   
-    if (mo && ok)
+    // Keep the original bytes, so that saving does not need 
+    // to encode the image again. Decoding is done on demand.
+    QFile file (fname);
+    bool ok = file.open (QIODevice::ReadOnly);
+    QByteArray data;
+    QString format;
+    QSize size;
+    if (ok)
+    {
+	data = file.readAll();
+	QBuffer buffer (&data);
+	buffer.open (QIODevice::ReadOnly);
+	QImageReader reader (&buffer);
+	format = QString (reader.format()).toLower();
+	size = reader.size();
+	ok = !format.isEmpty();
+    }
+
+    if (ok)
     {
-	setOriginalFilename (fname);
-        setHeadingPlainText (originalFilename);
-	((FloatImageObj*)mo)->load (originalImage);
-    }	else
-	qWarning() << "ImageItem::load failed for " << fname;
+	QString hash = QCryptographicHash::hash (data, QCryptographicHash::Sha1).toHex();
+	if (!size.isValid() )
+	    // Format does not provide size without decoding
+	    size = imageCache.getImage (hash, data, format).size();
+	ok = size.isValid();
+	if (ok)
+	{
+	    originalData = data;
+	    originalFormat = format;
+	    originalSize = size;
+	    contentHash = hash;
+	    setOriginalFilename (fname);
+	    updateMO();
+	}
+    }	
+    if (!ok) qWarning() << "ImageItem::load failed for " << fname;
     return ok;	
 }
 
+QImage ImageItem::getImage()
+{
+    if (originalData.isEmpty() ) return QImage();
+    return imageCache.getImage (contentHash, originalData, originalFormat);
+}
+
+QString ImageItem::getContentHash()
+{
+    return contentHash;
+}
+
+void ImageItem::updateMO()
+{
+    if (mo && !originalData.isEmpty() ) 
+	((FloatImageObj*)mo)->load (
+	    contentHash,
+	    originalData, 
+	    originalFormat, 
+	    QSize (originalSize.width()*scaleX, originalSize.height()*scaleY));
+}
+
 FloatImageObj* ImageItem::createMapObj()
 {
     FloatImageObj *fio=new FloatImageObj ( ((MapItem*)parentItem)->getMO(),this);
@@ -80,6 +144,7 @@ FloatImageObj* ImageItem::createMapObj()
     initLMO();	// set rel/abs position in mapitem
     fio->setZValue(zValue);
     fio->setRelPos (pos);
+    updateMO();
     fio->updateVisibility();
     return fio;
 }
@@ -88,9 +153,7 @@ void ImageItem::setScale (qreal sx, qreal sy)
 {
     scaleX=sx;
     scaleY=sy;
-    int w=originalImage.width()*scaleX;
-    int h=originalImage.height()*scaleY;
-    if (mo) ((FloatImageObj*)mo)->load (originalImage.scaled (w,h));
+    updateMO();
 }
 
 qreal ImageItem::getScaleX ()
@@ -126,12 +189,20 @@ QString ImageItem::getOriginalFilename()
 
 bool ImageItem::save(const QString &fn, const QString &format)
 {
-    return originalImage.save (fn,qPrintable (format)); 
+    if (format.toLower() == originalFormat)
+    {
+	// Write original bytes, no need to encode again
+	QFile file (fn);
+	if (!file.open (QIODevice::WriteOnly)) return false;
+	return file.write (originalData) == originalData.size();
+    }
+    return getImage().save (fn,qPrintable (format)); 
 }
 
 QString ImageItem::saveToDir (const QString &tmpdir,const QString &prefix) 
 {
-    if (hidden) return "";
+    // Images, which failed to load, have nothing to save
+    if (hidden || originalData.isEmpty() ) return "";
 
     // Save uuid 
     QString idAttr=attribut("uuid",uuid.toString());
@@ -139,12 +210,18 @@ QString ImageItem::saveToDir (const QString &tmpdir,const QString &prefix)
     QString zAttr=attribut ("zValue",QString().setNum(zValue));
     QString url;
 
-    ulong n=reinterpret_cast <ulong> (this);
-
-    url="images/"+prefix+"image-" + QString().number(n,10) + ".png" ;
+    // Images are stored by content, identical images are written only once
+    url="images/"+prefix+"image-" + contentHash + "." + originalFormat;
 
-    // And really save the image
-    originalImage.save (tmpdir +"/"+ url, "PNG");
+    // And really save the image, if not done already
+    QFile file (tmpdir +"/"+ url);
+    if (!file.exists() )
+    {
+	if (file.open (QIODevice::WriteOnly))
+	    file.write (originalData);
+	else
+	    qWarning() << "ImageItem::saveToDir failed for " << file.fileName();
+    }
  
     QString nameAttr=attribut ("originalName",originalFilename);
 
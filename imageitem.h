@@ -32,10 +32,16 @@ public:
     virtual void load (const QImage &img);
     virtual bool load (const QString &fname);
     virtual FloatImageObj* createMapObj();	    //! Create classic object in GraphicsView
+    virtual QImage getImage();			    //! Decoded image from ImageCache
+    virtual QString getContentHash();		    //! Hash of encoded image data
 protected:  
+    void updateMO();
     qreal scaleX;
     qreal scaleY;
-    QImage  originalImage;
+    QSize originalSize;
+    QByteArray originalData;//! Encoded bytes as loaded from file
+    QString originalFormat; //! Format of originalData, e.g. "png" or "jpeg"
+    QString contentHash;    //! SHA1 of originalData, used as name when saving
     QString originalFilename;
     int zValue;
 
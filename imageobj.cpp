@@ -1,6 +1,12 @@
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
 #include "imageobj.h"
+#include "imagecache.h"
 #include "mapobj.h"
 
+extern ImageCache imageCache;
+
 /////////////////////////////////////////////////////////////////
 // ImageObj	
 /////////////////////////////////////////////////////////////////
@@ -23,6 +29,10 @@ void ImageObj::copy(ImageObj* other)
     prepareGeometryChange();
     setVisibility (other->isVisible() );
     setPixmap (other->QGraphicsPixmapItem::pixmap());	
+    cacheKey    = other->cacheKey;
+    cacheData   = other->cacheData;
+    cacheFormat = other->cacheFormat;
+    cacheSize   = other->cacheSize;
     setPos (other->pos());
 }
 
@@ -36,7 +46,10 @@ void ImageObj::setVisibility (bool v)
 
 void ImageObj::save(const QString &fn, const char *format)
 {
-    pixmap().save (fn,format,100);
+    if (cacheKey.isEmpty() )
+        pixmap().save (fn,format,100);
+    else
+        imageCache.getPixmap (cacheKey, cacheData, cacheFormat, cacheSize).save (fn,format,100);
 }
 
 bool ImageObj::load (const QString &fn)
@@ -45,6 +58,7 @@ bool ImageObj::load (const QString &fn)
     if (pixmap.load (fn))
     {
         prepareGeometryChange();
+        cacheKey.clear();
         setPixmap (pixmap);
         return true;
     }
@@ -54,8 +68,54 @@ bool ImageObj::load (const QString &fn)
 bool ImageObj::load (const QPixmap &pm)
 {
     prepareGeometryChange();
+    cacheKey.clear();
     setPixmap (pm);
     return true;
 }
 
+void ImageObj::load (const QString &key, const QByteArray &data, const QString &format, const QSize &size)
+{
+    prepareGeometryChange();
+    setPixmap (QPixmap());
+    cacheKey    = key;
+    cacheData   = data;
+    cacheFormat = format;
+    cacheSize   = size;
+    update();
+}
+
+QRectF ImageObj::boundingRect() const
+{
+    if (cacheKey.isEmpty() ) return QGraphicsPixmapItem::boundingRect();
+    return QRectF (offset(), cacheSize);
+}
+
+QPainterPath ImageObj::shape() const
+{
+    if (cacheKey.isEmpty() ) return QGraphicsPixmapItem::shape();
+    QPainterPath path;
+    path.addRect (boundingRect() );
+    return path;
+}
+
+void ImageObj::paint (QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (cacheKey.isEmpty() ) 
+    {
+        QGraphicsPixmapItem::paint (painter, option, widget);
+        return;
+    }
+
+    // When zoomed out, use a pixmap with lower resolution (power of 2)
+    qreal lod = option->levelOfDetailFromTransform (painter->worldTransform() );
+    qreal f = 1;
+    while (f / 2 >= lod && f > 1.0 / 32) f /= 2;
+    QSize size = (QSizeF (cacheSize) * f).toSize().expandedTo (QSize (1, 1));
+
+    QPixmap pm = imageCache.getPixmap (cacheKey, cacheData, cacheFormat, size);
+    if (pm.isNull() ) return;
+    painter->setRenderHint (QPainter::SmoothPixmapTransform, f < 1);
+    painter->drawPixmap (boundingRect(), pm, QRectF (pm.rect()) );
+}
+
 
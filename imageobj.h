@@ -5,6 +5,10 @@
 #include <QGraphicsPixmapItem>
 
 /*! \brief Base class for pixmaps.
+
+    Either the pixmap is set directly or the ImageObj only knows 
+    the encoded data and gets pixmaps with the resolution needed 
+    for the current zoom level from the ImageCache.
 */
 
 class ImageObj: public QGraphicsPixmapItem
@@ -17,5 +21,15 @@ public:
     void save (const QString &, const char *);
     bool load (const QString &);
     bool load (const QPixmap &);
+    void load (const QString &key, const QByteArray &data, const QString &format, const QSize &size);
+    virtual QRectF boundingRect() const;
+    virtual QPainterPath shape() const;
+    virtual void paint (QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+
+protected:
+    QString cacheKey;	    //! Key in ImageCache, empty if pixmap is set directly
+    QByteArray cacheData;   //! Encoded data shared with ImageItem
+    QString cacheFormat;
+    QSize cacheSize;	    //! Size of image on map 
 };
 #endif
@@ -90,3 +90,78 @@ bool ImportMM::transform()
 	return false;
     
 }
+
+/////////////////////////////////////////////////////////////////
+// ImportDirScan
+/////////////////////////////////////////////////////////////////
+ImportDirScan::ImportDirScan()
+{
+    maxDepth = -1;
+    maxSize = -1;
+}
+
+void ImportDirScan::setMaxDepth (int d)
+{
+    maxDepth = d;
+}
+
+void ImportDirScan::setFilters (const QStringList &l)
+{
+    filters = l;
+}
+
+void ImportDirScan::setMaxSize (qint64 s)
+{
+    maxSize = s;
+}
+
+ImportDirEntry ImportDirScan::scan (const QString &dir) const
+{
+    ImportDirEntry e;
+    e.path = dir;
+    e.name = QFileInfo (dir).fileName();
+    e.isDir = true;
+    scanInt (e, 0);
+    return e;
+}
+
+int ImportDirScan::count (const ImportDirEntry &e)
+{
+    int n = e.children.count();
+    foreach (const ImportDirEntry &c, e.children)
+	n += count (c);
+    return n;
+}
+
+void ImportDirScan::scanInt (ImportDirEntry &e, int depth) const
+{
+    QDir d (e.path);
+    d.setFilter (QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+    QFileInfoList list = d.entryInfoList();
+
+    // Directories first, like in the old recursive import
+    foreach (const QFileInfo &fi, list)
+    {
+	if (!fi.isDir() ) continue;
+	ImportDirEntry c;
+	c.name = fi.fileName();
+	c.path = fi.filePath();
+	c.isDir = true;
+	// Don't follow links to directories, they might point upwards
+	if ( (maxDepth < 0 || depth < maxDepth) && !fi.isSymLink() )
+	    scanInt (c, depth + 1);
+	e.children.append (c);
+    }
+
+    foreach (const QFileInfo &fi, list)
+    {
+	if (!fi.isFile() ) continue;
+	if (maxSize >= 0 && fi.size() > maxSize) continue;
+	if (!filters.isEmpty() && !QDir::match (filters, fi.fileName()) ) continue;
+	ImportDirEntry c;
+	c.name = fi.fileName();
+	c.path = fi.filePath();
+	c.isDir = false;
+	e.children.append (c);
+    }
+}
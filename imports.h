@@ -43,5 +43,40 @@ public:
 };  
 
 
+///////////////////////////////////////////////////////////////////////
+/*! \brief Directory tree read by ImportDirScan, without any model items */
+
+struct ImportDirEntry
+{
+    QString name;
+    QString path;
+    bool isDir;
+    QList <ImportDirEntry> children;
+};
+
+/*! \brief Read a directory structure for VymModel::importDir
+
+    scan() does not touch the model or any widgets, so it can run
+    in a worker thread. Subdirectories are listed before files.
+*/
+
+class ImportDirScan
+{
+public:
+    ImportDirScan();
+    void setMaxDepth (int d);		    //! -1: unlimited, 0: only entries of dir itself
+    void setFilters (const QStringList &l);   //! Wildcards for files, e.g. "*.vym"
+    void setMaxSize (qint64 s);		    //! Skip files larger than s bytes, -1: unlimited
+    ImportDirEntry scan (const QString &dir) const;
+    static int count (const ImportDirEntry &e);	//! Number of entries below e
+
+private:
+    void scanInt (ImportDirEntry &e, int depth) const;
+    int maxDepth;
+    QStringList filters;
+    qint64 maxSize;
+};
+
+
 
 #endif
@@ -0,0 +1,631 @@
+#include "liveshare.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QMessageBox>
+#include <QRegExp>
+#include <QtEndian>
+
+#include "command.h"
+#include "file.h"
+#include "vymmodel.h"
+
+extern bool debug;
+extern QString vymName;
+extern QList <Command*> modelCommands;
+
+// Clients with more data waiting to be written get a snapshot later instead
+static const qint64 maxBacklog = 4 * 1024 * 1024;
+
+// Larger frames are considered to be garbage
+static const quint32 maxFrameSize = 64 * 1024 * 1024;
+
+// Data is compressed in chunks, so that the size of the uncompressed
+// data can be checked before it is allocated
+static const int chunkSize = 32 * 1024;
+static const int maxDataSize = 256 * 1024 * 1024;
+
+// Model commands, which access local files or the network, or block the client
+static const QStringList localCommands = QStringList()
+    << "addMapInsert" << "addMapReplace" << "connectToServer" << "exportMap"
+    << "importDir" << "loadImage" << "loadNote" << "paste" << "redo"
+    << "saveImage" << "saveNote" << "shareMap" << "sleep" << "undo";
+
+static QByteArray compress (const QByteArray &data)
+{
+    QByteArray r;
+    QDataStream out (&r, QIODevice::WriteOnly);
+    for (int i = 0; i < data.size(); i += chunkSize)
+	out << qCompress (data.mid (i, chunkSize));
+    return r;
+}
+
+static bool uncompress (const QByteArray &data, QByteArray &result)
+{
+    result.clear();
+    QDataStream in (data);
+    while (!in.atEnd() )
+    {
+	QByteArray chunk;
+	in >> chunk;
+	if (in.status() != QDataStream::Ok || chunk.size() < 4 || chunk.size() > 2 * chunkSize)
+	    return false;
+
+	// qCompress stores the uncompressed size in the first 4 bytes
+	quint32 size = qFromBigEndian <quint32> ((const uchar*)chunk.constData());
+	if (size > (quint32)chunkSize || result.size() + size > (quint32)maxDataSize)
+	    return false;
+	QByteArray raw = qUncompress (chunk);
+	if (raw.size() != (int)size) return false;
+	result.append (raw);
+    }
+    return true;
+}
+
+static int skipSpace (const QString &s, int i)
+{
+    while (i < s.length() && s.at(i).isSpace() ) i++;
+    return i;
+}
+
+// Ops are executed as script on the client. Only accept a single call of
+// a model command, which just changes the map, with literals as arguments.
+static bool isMapCommand (const QString &command)
+{
+    QRegExp rx ("^\\s*([a-zA-Z]+)\\s*\\(");
+    if (rx.indexIn (command) != 0) return false;
+
+    QString name = rx.cap (1);
+    if (localCommands.contains (name)) return false;
+    Command *c = NULL;
+    foreach (Command *mc, modelCommands)
+	if (mc->getName() == name)
+	{
+	    c = mc;
+	    break;
+	}
+    if (!c) return false;
+
+    QRegExp literal ("-?[0-9]+(\\.[0-9]+)?|true|false");
+    int i = skipSpace (command, rx.matchedLength() );
+    int n = 0;
+    while (i < command.length() && command.at(i) != ')')
+    {
+	if (n > 0)
+	{
+	    if (command.at(i) != ',') return false;
+	    i = skipSpace (command, i + 1);
+	    if (i >= command.length() ) return false;
+	}
+
+	QChar q = command.at(i);
+	if (q == '"' || q == '\'')
+	{
+	    // String, backslash escapes the next character
+	    for (i++; i < command.length() && command.at(i) != q; i++)
+		if (command.at(i) == '\\') i++;
+	    if (i >= command.length() ) return false;
+	    i++;
+	} else if (literal.indexIn (command, i, QRegExp::CaretAtOffset) == i)
+	    i += literal.matchedLength();
+	else
+	    return false;
+	n++;
+	i = skipSpace (command, i);
+    }
+    if (i >= command.length() ) return false;
+
+    // Nothing but an optional semicolon after the call
+    i = skipSpace (command, i + 1);
+    if (i < command.length() && command.at(i) == ';') i = skipSpace (command, i + 1);
+    if (i != command.length() ) return false;
+
+    if (n > c->parCount() ) return false;
+    for (int j = n; j < c->parCount(); j++)
+	if (!c->isParOptional (j)) return false;
+    return true;
+}
+
+LiveShare::LiveShare (VymModel *m, QObject *parent) : QObject (parent)
+{
+    model = m;
+    tcpServer = NULL;
+    clientSocket = NULL;
+    snapshotAll = false;
+    synced = false;
+
+    seq = 0;
+    opsSent = 0;
+    opsReceived = 0;
+    bytesSent = 0;
+    bytesReceived = 0;
+    snapshotsSent = 0;
+    resyncs = 0;
+
+    flushTimer.setSingleShot (true);
+    flushTimer.setInterval (0);
+    connect (&flushTimer, SIGNAL (timeout()), this, SLOT (flush()));
+}
+
+LiveShare::~LiveShare()
+{
+    foreach (QTcpSocket *socket, clientList)
+    {
+	disconnect (socket, 0, this, 0);
+	socket->abort();
+    }
+    if (clientSocket)
+    {
+	disconnect (clientSocket, 0, this, 0);
+	clientSocket->abort();
+    }
+}
+
+bool LiveShare::listen (int port, const QHostAddress &address)
+{
+    tcpServer = new QTcpServer (this);
+    if (!tcpServer->listen (address, port)) return false;
+    connect (tcpServer, SIGNAL (newConnection()), this, SLOT (newClient()));
+    if (debug) qDebug() << "LiveShare: Server is running on port " << tcpServer->serverPort();
+    return true;
+}
+
+void LiveShare::connectToServer (const QString &server, int port)
+{
+    synced = false;
+    readBuffer.clear();
+    clientSocket = new QTcpSocket (this);
+    connect (clientSocket, SIGNAL (readyRead()), this, SLOT (readData()));
+    connect (clientSocket, SIGNAL (error(QAbstractSocket::SocketError)),
+	     this, SLOT (displayNetworkError(QAbstractSocket::SocketError)));
+    clientSocket->connectToHost (server, port);
+    if (debug) qDebug() << "LiveShare: connecting to " << server << " port " << port;
+}
+
+bool LiveShare::isServer()
+{
+    return tcpServer != NULL;
+}
+
+bool LiveShare::isClient()
+{
+    return clientSocket != NULL;
+}
+
+bool LiveShare::isSynced()
+{
+    return synced;
+}
+
+int LiveShare::serverPort()
+{
+    return tcpServer ? tcpServer->serverPort() : 0;
+}
+
+QString LiveShare::errorString()
+{
+    if (tcpServer) return tcpServer->errorString();
+    if (clientSocket) return clientSocket->errorString();
+    return QString();
+}
+
+void LiveShare::sendOp (const QString &selection, const QString &command)
+{
+    if (!tcpServer || clientList.isEmpty() ) return;
+
+    // Commands like addMapReplace refer to files in the local history,
+    // paste uses the local clipboard. Clients need a snapshot instead
+    if ((model && command.contains (model->tmpDirPath() )) || command.startsWith ("paste"))
+    {
+	requestSnapshot();
+	return;
+    }
+    pendingOps << selection << command;
+    flushTimer.start();
+}
+
+void LiveShare::requestSnapshot()
+{
+    snapshotAll = true;
+    flushTimer.start();
+}
+
+int LiveShare::clientCount()
+{
+    return clientList.count();
+}
+
+quint32 LiveShare::getSequence()
+{
+    return seq;
+}
+
+qint64 LiveShare::getOpsSent()
+{
+    return opsSent;
+}
+
+qint64 LiveShare::getOpsReceived()
+{
+    return opsReceived;
+}
+
+qint64 LiveShare::getBytesSent()
+{
+    return bytesSent;
+}
+
+qint64 LiveShare::getBytesReceived()
+{
+    return bytesReceived;
+}
+
+int LiveShare::getSnapshotsSent()
+{
+    return snapshotsSent;
+}
+
+int LiveShare::getResyncs()
+{
+    return resyncs;
+}
+
+void LiveShare::flush()
+{
+    flushTimer.stop();
+
+    if (!pendingOps.isEmpty() )
+    {
+	// Clients, which do not read fast enough, will catch up with a snapshot
+	QByteArray msg = opsPayload();
+	foreach (QTcpSocket *socket, clientList)
+	{
+	    if (snapshotClients.contains (socket)) continue;
+	    if (socket->bytesToWrite() > maxBacklog)
+		snapshotClients.insert (socket);
+	    else
+		writeFrame (socket, msg);
+	}
+    }
+
+    if (snapshotAll)
+    {
+	foreach (QTcpSocket *socket, clientList) snapshotClients.insert (socket);
+	snapshotAll = false;
+    }
+
+    // Create snapshot only once, even for multiple clients
+    QByteArray snapshot;
+    foreach (QTcpSocket *socket, snapshotClients)
+    {
+	if (socket->bytesToWrite() > maxBacklog) continue;  // wait for bytesWritten
+	if (snapshot.isEmpty() ) snapshot = snapshotPayload();
+	writeFrame (socket, snapshot);
+	snapshotClients.remove (socket);
+	snapshotsSent++;
+    }
+}
+
+void LiveShare::newClient()
+{
+    QTcpSocket *socket = tcpServer->nextPendingConnection();
+    connect (socket, SIGNAL (disconnected()), this, SLOT (clientDisconnected()));
+    connect (socket, SIGNAL (bytesWritten(qint64)), this, SLOT (clientBytesWritten()));
+    connect (socket, SIGNAL (readyRead()), this, SLOT (readData()));
+
+    if (debug) qDebug() << "LiveShare::newClient  at " << socket->peerAddress().toString();
+
+    clientList.append (socket);
+
+    // New clients start with a snapshot. Ops collected so far are already
+    // part of it.
+    snapshotClients.insert (socket);
+    flushTimer.start();
+}
+
+void LiveShare::clientDisconnected()
+{
+    QTcpSocket *socket = qobject_cast <QTcpSocket*> (sender());
+    if (!socket) return;
+    clientList.removeAll (socket);
+    clientBuffers.remove (socket);
+    snapshotClients.remove (socket);
+    socket->deleteLater();
+}
+
+void LiveShare::clientBytesWritten()
+{
+    QTcpSocket *socket = qobject_cast <QTcpSocket*> (sender());
+    if (socket && snapshotClients.contains (socket) && socket->bytesToWrite() <= maxBacklog)
+	flushTimer.start();
+}
+
+void LiveShare::readData()
+{
+    QTcpSocket *socket = qobject_cast <QTcpSocket*> (sender());
+    if (!socket) return;
+
+    if (socket == clientSocket)
+	readFrames (socket, readBuffer);
+    else
+	readFrames (socket, clientBuffers[socket]);
+}
+
+void LiveShare::displayNetworkError (QAbstractSocket::SocketError socketError)
+{
+    switch (socketError) {
+    case QAbstractSocket::RemoteHostClosedError:
+        break;
+    case QAbstractSocket::HostNotFoundError:
+        QMessageBox::information(NULL, vymName +" Network client",
+                                 "The host was not found. Please check the "
+                                    "host name and port settings.");
+        break;
+    case QAbstractSocket::ConnectionRefusedError:
+        QMessageBox::information(NULL, vymName + " Network client",
+                                 "The connection was refused by the peer. "
+                                    "Make sure the vym server is running, "
+                                    "and check that the host name and port "
+                                    "settings are correct.");
+        break;
+    default:
+        QMessageBox::information(NULL, vymName + " Network client",
+                                 QString("The following error occurred: %1.")
+                                 .arg(clientSocket->errorString()));
+    }
+}
+
+void LiveShare::writeFrame (QTcpSocket *socket, const QByteArray &payload)
+{
+    QByteArray header;
+    QDataStream out (&header, QIODevice::WriteOnly);
+    out << (quint32)payload.size();
+
+    socket->write (header);
+    socket->write (payload);
+    bytesSent += header.size() + payload.size();
+}
+
+QByteArray LiveShare::payload (MessageType type, quint32 s, const QByteArray &data)
+{
+    QByteArray msg;
+    QDataStream out (&msg, QIODevice::WriteOnly);
+    out.setVersion (QDataStream::Qt_5_0);
+    out << (quint8)type << s << data;
+    return msg;
+}
+
+QByteArray LiveShare::opsPayload()
+{
+    QByteArray data;
+    QDataStream out (&data, QIODevice::WriteOnly);
+    out.setVersion (QDataStream::Qt_5_0);
+    out << pendingOps;
+
+    int n = pendingOps.count() / 2;
+    QByteArray msg = payload (Ops, seq, compress (data));
+    if (debug) qDebug() << "LiveShare::opsPayload  seq=" << seq << " ops=" << n << " bytes=" << msg.size();
+
+    seq += n;
+    opsSent += n;
+    pendingOps.clear();
+    return msg;
+}
+
+QByteArray LiveShare::snapshotPayload()
+{
+    QString xml;
+    QMap <QString, QByteArray> files;
+
+    if (model)
+    {
+	// Save map with images to tmp dir and collect the files
+	bool ok;
+	QString dirPath = makeTmpDir (ok, model->tmpDirPath(), "liveshare");
+	if (ok)
+	{
+	    xml = model->saveToDir (dirPath, "", true, QPointF(), NULL);
+
+	    QDir dir (dirPath);
+	    QDirIterator it (dirPath, QDir::Files, QDirIterator::Subdirectories);
+	    while (it.hasNext() )
+	    {
+		QFile file (it.next() );
+		if (file.open (QIODevice::ReadOnly))
+		    files[dir.relativeFilePath (file.fileName())] = file.readAll();
+	    }
+	    removeDir (dir);
+	} else
+	    qWarning() << "LiveShare: Couldn't create temporary directory for snapshot";
+    }
+
+    QByteArray data;
+    QDataStream out (&data, QIODevice::WriteOnly);
+    out.setVersion (QDataStream::Qt_5_0);
+    out << xml << files;
+
+    return payload (Snapshot, seq, compress (data));
+}
+
+void LiveShare::readFrames (QTcpSocket *socket, QByteArray &buffer)
+{
+    QByteArray data = socket->readAll();
+    bytesReceived += data.size();
+    buffer.append (data);
+
+    while (buffer.size() >= (int)sizeof (quint32))
+    {
+	quint32 size;
+	QDataStream in (buffer);
+	in >> size;
+	if (size > maxFrameSize)
+	{
+	    qWarning() << "LiveShare: Invalid frame of" << size << "bytes, closing connection";
+	    buffer.clear();
+	    socket->abort();
+	    return;
+	}
+	if ((quint32)buffer.size() < sizeof (quint32) + size) return;  // wait for rest
+
+	QByteArray msg = buffer.mid (sizeof (quint32), size);
+	buffer.remove (0, sizeof (quint32) + size);
+
+	if (socket == clientSocket)
+	    handleClientMessage (msg);
+	else
+	    handleServerMessage (socket, msg);
+    }
+}
+
+void LiveShare::handleServerMessage (QTcpSocket *socket, const QByteArray &msg)
+{
+    QDataStream in (msg);
+    in.setVersion (QDataStream::Qt_5_0);
+    quint8 type;
+    quint32 s;
+    in >> type >> s;
+
+    if (type == Resync)
+    {
+	if (debug) qDebug() << "LiveShare: Client requests resync at seq=" << s;
+	resyncs++;
+	snapshotClients.insert (socket);
+	flushTimer.start();
+    } else
+	qWarning() << "LiveShare: Unknown message from client, type=" << type;
+}
+
+void LiveShare::handleClientMessage (const QByteArray &msg)
+{
+    QDataStream in (msg);
+    in.setVersion (QDataStream::Qt_5_0);
+    quint8 type;
+    quint32 s;
+    QByteArray compressed;
+    in >> type >> s >> compressed;
+
+    QByteArray data;
+    if (!uncompress (compressed, data))
+    {
+	qWarning() << "LiveShare: Invalid data from server, closing connection";
+	readBuffer.clear();
+	clientSocket->abort();
+	return;
+    }
+
+    switch (type)
+    {
+	case Ops:
+	    if (!synced) return;    // Ignore ops until snapshot arrives
+	    if (s > seq)
+	    {
+		// Missed some operations, ask for a snapshot
+		if (debug) qDebug() << "LiveShare: expected seq=" << seq << " got " << s << ", requesting resync";
+		resync();
+	    } else
+		applyOps (s, data);
+	    break;
+	case Snapshot:
+	    applySnapshot (s, data);
+	    break;
+	default:
+	    qWarning() << "LiveShare: Unknown message from server, type=" << type;
+    }
+}
+
+void LiveShare::applyOps (quint32 s, const QByteArray &data)
+{
+    QStringList ops;
+    QDataStream in (data);
+    in.setVersion (QDataStream::Qt_5_0);
+    in >> ops;
+
+    // Skip operations, which have already been applied
+    int n = ops.count() / 2;
+    int first = seq - s;
+    if (first >= n) return;
+
+    if (model) model->deferUpdates();
+    for (int i = first; i < n; i++)
+    {
+	if (model)
+	{
+	    QString command = ops.at(2 * i + 1);
+	    if (!isMapCommand (command))
+	    {
+		// Get the changes as snapshot instead
+		qWarning() << "LiveShare: Rejecting operation from server: " << command;
+		model->resumeUpdates();
+		resync();
+		return;
+	    }
+	    QString selection = ops.at(2 * i);
+	    if (!selection.isEmpty() ) model->select (selection);
+	    model->execute (QString ("model = vym.currentMap(); model.%1").arg (command));
+	}
+    }
+    if (model) model->resumeUpdates();
+
+    seq = s + n;
+    opsReceived += n - first;
+    emit (opsApplied (n - first));
+}
+
+void LiveShare::resync()
+{
+    resyncs++;
+    synced = false;
+    writeFrame (clientSocket, payload (Resync, seq, QByteArray()));
+}
+
+void LiveShare::applySnapshot (quint32 s, const QByteArray &data)
+{
+    QString xml;
+    QMap <QString, QByteArray> files;
+    QDataStream in (data);
+    in.setVersion (QDataStream::Qt_5_0);
+    in >> xml >> files;
+
+    if (model)
+    {
+	bool ok;
+	QString dirPath = makeTmpDir (ok, model->tmpDirPath(), "liveshare");
+	if (!ok)
+	{
+	    qWarning() << "LiveShare: Couldn't create temporary directory for snapshot";
+	    return;
+	}
+
+	QMapIterator <QString, QByteArray> it (files);
+	while (it.hasNext() )
+	{
+	    it.next();
+
+	    // Names come from the network, only allow files below dirPath
+	    QString name = QDir::cleanPath (it.key());
+	    if (name.isEmpty() || QDir::isAbsolutePath (name)
+		|| name.contains ('\\') || name.contains (':')
+		|| name.split ('/').contains (".."))
+	    {
+		qWarning() << "LiveShare: Ignoring file in snapshot: " << it.key();
+		continue;
+	    }
+	    QString fn = dirPath + "/" + name;
+	    makeSubDirs (QFileInfo (fn).path() );
+	    QFile file (fn);
+	    if (file.open (QIODevice::WriteOnly)) file.write (it.value() );
+	}
+	saveStringToDisk (dirPath + "/map.xml", xml);
+
+	model->clear();
+	model->loadMap (dirPath + "/map.xml", NewMap, VymMap);
+	removeDir (QDir (dirPath));
+    }
+
+    seq = s;
+    synced = true;
+    emit (snapshotApplied());
+}
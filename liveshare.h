@@ -0,0 +1,135 @@
+#ifndef LIVESHARE_H
+#define LIVESHARE_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+class VymModel;
+
+/*! \brief Live sharing of a map between a vym server and its clients
+
+    The server streams the redo commands from VymModel::saveState to all
+    connected clients, which replay them on their copy of the map.
+
+    Every message is framed by a quint32 length. Its payload starts with
+    the message type and a sequence number:
+
+    - Ops:	 Compressed list of (selection, command) pairs. The
+		 sequence number is the one of the first operation in
+		 the batch. Operations collected during one event loop
+		 iteration are sent as one batch.
+    - Snapshot:	 Compressed XML of the complete map with its images.
+		 Sent to new clients, on request and to clients which
+		 could not keep up. Its sequence number is the one of
+		 the next operation.
+    - Resync:	 Sent by a client, which missed operations. The server
+		 replies with a snapshot.
+
+    Data is compressed in chunks of limited size, so the receiver can
+    reject oversized data before uncompressing it.
+
+    Commands, which refer to local files like the undo history or the
+    clipboard, are replaced by a snapshot.
+
+    Commands are executed as scripts on the client. Only single calls of
+    model commands with literal arguments are accepted, which do not access
+    files or the network. Anything else is rejected and the client
+    requests a snapshot. File names in snapshots are restricted to the
+    temporary directory of the client.
+
+    The server only listens on localhost, unless another address is given.
+*/
+
+class LiveShare:public QObject {
+    Q_OBJECT
+
+public:
+    enum MessageType {
+	Ops	 = 1,	//!< Batch of operations
+	Snapshot = 2,	//!< Complete map
+	Resync	 = 3	//!< Client requests a snapshot
+    };
+
+    LiveShare (VymModel *m, QObject *parent = NULL);	//! Without model a client only counts operations
+    ~LiveShare();
+
+    bool listen (int port, const QHostAddress &address = QHostAddress::LocalHost);
+    void connectToServer (const QString &server, int port);
+    bool isServer();
+    bool isClient();
+    bool isSynced();		    //! Client has received a snapshot
+    int serverPort();
+    QString errorString();
+
+    void sendOp (const QString &selection, const QString &command);
+    void requestSnapshot();	    //! Send snapshot to all clients with next flush
+    int clientCount();
+
+    quint32 getSequence();	    //! Next sequence number sent or expected
+    qint64 getOpsSent();
+    qint64 getOpsReceived();
+    qint64 getBytesSent();
+    qint64 getBytesReceived();
+    int getSnapshotsSent();
+    int getResyncs();
+
+public slots:
+    void flush();
+
+signals:
+    void opsApplied (int n);
+    void snapshotApplied();
+
+private slots:
+    void newClient();
+    void clientDisconnected();
+    void clientBytesWritten();
+    void readData();
+    void displayNetworkError (QAbstractSocket::SocketError);
+
+private:
+    void writeFrame (QTcpSocket *socket, const QByteArray &payload);
+    QByteArray payload (MessageType type, quint32 seq, const QByteArray &data);
+    QByteArray opsPayload();
+    QByteArray snapshotPayload();
+    void readFrames (QTcpSocket *socket, QByteArray &buffer);
+    void handleServerMessage (QTcpSocket *socket, const QByteArray &msg);
+    void handleClientMessage (const QByteArray &msg);
+    void applyOps (quint32 seq, const QByteArray &data);
+    void resync();			//! Drop ops and request a snapshot
+    void applySnapshot (quint32 seq, const QByteArray &data);
+
+    VymModel *model;
+
+    // Server
+    QTcpServer *tcpServer;
+    QList <QTcpSocket*> clientList;
+    QMap <QTcpSocket*, QByteArray> clientBuffers;
+    QSet <QTcpSocket*> snapshotClients;	//! Clients waiting for a snapshot
+    QStringList pendingOps;		//! selection and command of unsent ops
+    bool snapshotAll;
+    QTimer flushTimer;
+
+    // Client
+    QTcpSocket *clientSocket;
+    QByteArray readBuffer;
+    bool synced;
+
+    quint32 seq;
+    qint64 opsSent;
+    qint64 opsReceived;
+    qint64 bytesSent;
+    qint64 bytesReceived;
+    int snapshotsSent;
+    int resyncs;
+};
+
+#endif
@@ -5,14 +5,20 @@
 #include <iostream>
 using namespace std;
 
+#include "bug-agent.h"
 #include "command.h"
 #include "findwidget.h"
+#include "file.h"
 #include "findresultwidget.h"
 #include "flagrow.h"
 #include "flagrowobj.h"
 #include "headingeditor.h"
+#include "headinglayout.h"
+#include "imagecache.h"
+#include "jira-agent.h"
 #include "macros.h"
 #include "mainwindow.h"
+#include "misc.h"
 #include "noteeditor.h"
 #include "options.h"
 #include "settings.h"
@@ -56,6 +62,8 @@ QTextStream vout(stdout);        // vymout - Testing for now. Flush after writin
 QStringList jiraPrefixList;     // List containing URLs of Jira systems
 bool jiraClientAvailable;	// collabzone specific currently
 bool bugzillaClientAvailable;	// openSUSE specific currently
+JiraAgent *jiraAgent;		// Shared by all maps, limits number of lookups
+BugAgent *bugAgent;
 
 TaskModel     *taskModel;
 TaskEditor    *taskEditor;
@@ -89,6 +97,7 @@ QString iconPath;               // Pointing to icons used for toolbars
 QString flagsPath;              // Pointing to flags
 
 bool debug;                     // global debugging flag
+bool batchMode = false;         // No GUI, e.g. for --batch, --convert or -q
 bool testmode;		        // Used to disable saving of autosave setting
 bool recoveryMode = false;      // Activated via command line switch and deactivated after initial loading of files
 QStringList ignoredLockedFiles;
@@ -96,6 +105,9 @@ QStringList ignoredLockedFiles;
 FlagRow *systemFlagsMaster; 
 FlagRow *standardFlagsMaster;	
 
+HeadingLayoutCache headingLayoutCache;  // Wrapped and laid out headings of all maps
+ImageCache imageCache;          // Decoded and scaled images of all maps
+
 Switchboard switchboard;
 
 Settings settings ("InSilmaril","vym"); // Organization, Application name
@@ -150,6 +162,14 @@ void msgHandler (QtMsgType type, const QMessageLogContext &context, const QStrin
 
 int main(int argc, char* argv[])
 {
+    startupStep ("Start");
+
+    // Converting maps needs no display, also not in the worker processes,
+    // which inherit the environment
+    for (int i = 1; i < argc; i++)
+        if (QByteArray (argv[i]) == "--convert" || QByteArray (argv[i]) == "-convert")
+            qputenv ("QT_QPA_PLATFORM", "offscreen");
+
     QApplication app(argc,argv);
 
     // Define some constants shared in various places
@@ -168,14 +188,18 @@ int main(int argc, char* argv[])
 
     // Reading and initializing options commandline options
     options.add ("batch", Option::Switch, "b", "batch");
+    options.add ("benchmark", Option::Switch, "benchmark", "benchmark");
     options.add ("commands", Option::Switch, "c", "commands");
     options.add ("commandslatex", Option::Switch, "cl", "commandslatex");
+    options.add ("convert", Option::String, "convert", "convert");
     options.add ("debug", Option::Switch, "d", "debug");
     options.add ("help", Option::Switch, "h", "help");
+    options.add ("jobs", Option::String, "jobs", "jobs");
     options.add ("load", Option::String, "L", "load");
     options.add ("local", Option::Switch, "l", "local");
     options.add ("locale", Option::String, "locale", "locale");
     options.add ("name", Option::String, "n", "name");
+    options.add ("outdir", Option::String, "outdir", "outdir");
     options.add ("quit", Option::Switch, "q", "quit");
     options.add ("run", Option::String, "R", "run");
     options.add ("recover", Option::Switch, "recover", "recover");
@@ -183,6 +207,7 @@ int main(int argc, char* argv[])
     options.add ("shortcuts", Option::Switch, "s", "shortcuts");
     options.add ("shortcutsLaTeX", Option::Switch, "sl", "shortcutsLaTeX");
     options.add ("testmode", Option::Switch, "t", "testmode");
+    options.add ("timing", Option::Switch, "T", "timing");
     options.add ("version", Option::Switch, "v","version");
     options.setHelpText (
                 "VYM - View Your Mind\n"
@@ -194,20 +219,26 @@ int main(int argc, char* argv[])
                 "Usage: vym [OPTION]... [FILE]... \n"
                 "Open FILEs with vym\n\n"
                 "-b           batch       batch mode: hide windows\n"
+                "--benchmark  benchmark   Run benchmarks on last loaded map, print results and quit\n"
                 "-c           commands	  List all available commands\n"
+                "--convert FORMAT convert Export FILEs as ascii, csv, html, latex, markdown,\n"
+                "                         orgmode or xml and quit\n"
                 "-d           debug       Show debugging output\n"
                 "-h           help        Show this help text\n"
+                "--jobs N     jobs        Number of parallel workers for --convert\n"
                 "-L           load        Load script\n"
                 "-l           local       Run with ressources in current directory\n"
                 "--locale     locale      Override system locale setting to select language\n"
                 "-n  STRING   name        Set name of instance for DBus access\n"
+                "--outdir DIR outdir      Output directory for --convert\n"
                 "-q           quit        Quit immediatly after start for benchmarking\n"
                 "-R  FILE     run         Run script\n"
                 "-r           restore     Restore last session\n"
-                "--recover    recover     Delete lockfiles during initial loading of files\n"
+                "--recover    recover     Delete lockfiles and replay journals during initial loading of files\n"
                 "-s           shortcuts   Show Keyboard shortcuts on start\n"
                 "--sl         LaTeX       Show Keyboard shortcuts in LaTeX format on start\n"
                 "-t           testmode    Test mode, e.g. no autosave and changing of its setting\n"
+                "-T           timing      Show time used for steps of startup\n"
                 "-v           version     Show vym version\n"
                 );
 
@@ -255,6 +286,7 @@ int main(int argc, char* argv[])
     debug=options.isOn ("debug");
     //debug=true;
     testmode=options.isOn ("testmode");
+    batchMode=options.isOn ("batch") || options.isOn ("convert") || options.isOn ("quit");
 
     QString pidString=QString ("%1").arg(getpid());
     if (debug) qDebug()<< "vym PID="<<pidString;
@@ -266,10 +298,13 @@ int main(int argc, char* argv[])
     {
         fprintf(stderr, "%s\n",
                 qPrintable(QDBusConnection::sessionBus().lastError().message()));
-        exit(1);
+        // Servers converting maps usually have no session bus
+        if (!options.isOn ("convert")) exit(1);
     }
 #endif
 
+    startupStep ("Options, settings and DBus");
+
     if (options.isOn ("name"))
         vymInstanceName=options.getArg ("name");
     else
@@ -411,6 +446,7 @@ int main(int argc, char* argv[])
 
     }
     app.installTranslator( &vymTranslator );
+    startupStep ("Translations");
 
     // Initializing the master rows of flags
     systemFlagsMaster=new FlagRow;
@@ -418,19 +454,29 @@ int main(int argc, char* argv[])
     standardFlagsMaster=new FlagRow;
     standardFlagsMaster->setName ("standardFlagsMaster");
 
-    // Initialize editors
-    noteEditor = new NoteEditor("noteeditor");
-    noteEditor->setWindowIcon (QPixmap (":/vym-editor.png"));
-    headingEditor = new HeadingEditor("headingeditor");
+    // Memory budget for decoded images in kB
+    imageCache.setMaxSize (settings.value ("/system/imageCacheSize", 256 * 1024).toInt() );
+
+    // Initialize editors, without GUI in batch mode they are not needed
+    if (!batchMode)
+    {
+        noteEditor = new NoteEditor("noteeditor");
+        noteEditor->setWindowIcon (QPixmap (":/vym-editor.png"));
+    } else
+        noteEditor = NULL;
+    headingEditor = NULL;   // Created by Main when shown first time
 
     // Check if there is a JiraClient       // FIXME-4 check for ruby
-    QFileInfo fi(vymBaseDir.path() + "/scripts/jigger");   
+    jiraAgent = new JiraAgent;
+    QFileInfo fi(jiraAgent->getScript() );   
     jiraClientAvailable = fi.exists();
     jiraPrefixList = settings.value("/system/jiraPrefixList").toStringList();   // FIXME-2 currently not used
 
     // Check if there is a BugzillaClient   // FIXME-4 check for ruby
-    fi.setFile( vymBaseDir.path() + "/scripts/bugger");   
+    bugAgent = new BugAgent;
+    fi.setFile( bugAgent->getScript() );   
     bugzillaClientAvailable = fi.exists();
+    startupStep ("Editors and agents");
 
     // Initialize mainwindow
     // Note: mainWindow pointer is set in constructor  // FIXME-3 check this...
@@ -439,13 +485,16 @@ int main(int argc, char* argv[])
 #else
     Main m;
 #endif
+    startupStep ("Main window created");
 
     // Check for zip tools 
     checkZipTool();
     checkUnzipTool();
 
 #if defined(Q_OS_WIN32)
-    if (!zipToolAvailable)
+    if (!zipToolAvailable && batchMode)
+        qWarning() << "Couldn't find tool to unzip data.";
+    else if (!zipToolAvailable)
     {
         QMessageBox::critical( 0, QObject::tr( "Critical Error" ),
                                QObject::tr("Couldn't find tool to unzip data. "
@@ -455,7 +504,9 @@ int main(int argc, char* argv[])
         m.settingsZipTool();
     }
 #else
-    if (!zipToolAvailable || !unzipToolAvailable)
+    if ((!zipToolAvailable || !unzipToolAvailable) && batchMode)
+        qWarning() << "Couldn't find tool to zip/unzip data.";
+    else if (!zipToolAvailable || !unzipToolAvailable)
     {
         QMessageBox::critical( 0, QObject::tr( "Critical Error" ),
                                QObject::tr("Couldn't find tool to zip/unzip data. "
@@ -467,6 +518,7 @@ int main(int argc, char* argv[])
 
     m.setWindowIcon (QPixmap (":/vym.png"));
     m.fileNew();
+    startupStep ("Default map");
 
     if (options.isOn ("commands"))
     {
@@ -489,20 +541,36 @@ int main(int argc, char* argv[])
         return 0;
     }
 
-    if (options.isOn ("batch"))
+    if (batchMode)
         m.hide();
     else
     {
         // Paint Mainwindow first time
         qApp->processEvents();
         m.show();
+        startupStep ("Showing main window");
+    }
+
+    // Convert maps given on command line and quit
+    if (options.isOn ("convert"))
+    {
+        int jobs = 1;
+        if (options.isOn ("jobs")) jobs = qMax (1, options.getArg ("jobs").toInt() );
+        return m.convertMaps (
+            options.getFileList(), 
+            options.getArg ("convert"), 
+            options.getArg ("outdir"), 
+            jobs);
     }
 
-    // Show release notes, if not already done
-    m.checkReleaseNotes();
+    if (!batchMode)
+    {
+        // Show release notes, if not already done
+        m.checkReleaseNotes();
 
-    // Check for updates
-    m.checkUpdates();
+        // Check for updates
+        m.checkUpdates();
+    }
 
     if (options.isOn("shortcuts")) switchboard.printASCII();    //FIXME-3 global switchboard and exit after listing
 
@@ -510,10 +578,15 @@ int main(int argc, char* argv[])
         recoveryMode = true;
 
     m.loadCmdLine();
+    startupStep ("Loading maps");
 
     // Restore last session
     if (options.isOn ("restore"))
+    {
         m.fileRestoreSession();
+        m.waitForMaps();
+        startupStep ("Restoring session");
+    }
 
     // By now all files should have been loaded
     // Reset the restore flag and display message if needed
@@ -526,7 +599,7 @@ int main(int argc, char* argv[])
     ignoredLockedFiles.clear();
 
     // Load script
-    if (options.isOn ("load"))
+    if (options.isOn ("load") && scriptEditor)
     {
         QString fn = options.getArg ("load");
         if (!scriptEditor->loadScript ( fn ) )
@@ -545,7 +618,16 @@ int main(int argc, char* argv[])
     {
         QString script;
         QString fn = options.getArg ("run");
-        if (!scriptEditor->loadScript ( fn ) )
+
+        // Without ScriptEditor in batch mode read script directly
+        bool ok;
+        if (scriptEditor)
+        {
+            ok = scriptEditor->loadScript ( fn );
+            script = scriptEditor->getScriptFile();
+        } else
+            ok = loadStringFromDisk (fn, script);
+        if (!ok)
         {
             QString error (QObject::tr("Error"));
             QString msg (QObject::tr("Couldn't open \"%1\"\n.").arg(fn));
@@ -554,12 +636,19 @@ int main(int argc, char* argv[])
             else QMessageBox::warning(0, error, msg);
             return 0;
         }
-        m.runScript (scriptEditor->getScriptFile() );
+        m.runScript (script);
+        startupStep ("Running script");
     }
+
+    if (options.isOn ("timing"))
+        foreach (QString s, startupReport())
+            cout << qPrintable (s) << endl;
     
     // For benchmarking we may want to quit instead of entering event loop
     if (options.isOn ("quit")) return 0;
 
+    if (options.isOn ("benchmark")) return m.runBenchmarks();
+
     // Enable some last minute cleanup
     QObject::connect( &app, SIGNAL(lastWindowClosed()), &app, SLOT(quit()) );
 
@@ -11,10 +11,12 @@ using namespace std;
 
 #include <QColorDialog>
 #include <QDockWidget>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFontDialog>
 #include <QInputDialog>
 #include <QMenuBar>
+#include <QPointer>
 #include <QScriptEngine>
 #include <QStatusBar>
 #include <QTextStream>
@@ -29,13 +31,18 @@ using namespace std;
 #include "findresultwidget.h"
 #include "findresultmodel.h"
 #include "flagrow.h"
+#include "frameobj.h"
 #include "headingeditor.h"
+#include "headinglayout.h"
 #include "historywindow.h"
+#include "imagecache.h"
 #include "imports.h"
+#include "jira-agent.h"
 #include "lineeditdialog.h"
 #include "macros.h"
 #include "mapeditor.h"
 #include "misc.h"
+#include "mysortfilterproxymodel.h"
 #include "options.h"
 #include "vymprocess.h"
 #include "scripteditor.h"
@@ -52,6 +59,7 @@ using namespace std;
 #include "userdialog.h"
 #include "warningdialog.h"
 #include "xlinkitem.h"
+#include "xlinkobj.h"
 #include "zip-settings-dialog.h"
 
 QPrinter *printer = NULL; 
@@ -78,6 +86,8 @@ extern uint  clipboardItemCount;
 extern int statusbarTime;
 extern FlagRow *standardFlagsMaster;	
 extern FlagRow *systemFlagsMaster;
+extern HeadingLayoutCache headingLayoutCache;
+extern ImageCache imageCache;
 extern QString vymName;
 extern QString vymVersion;
 extern QString vymPlatform;
@@ -86,6 +96,7 @@ extern QString vymBuildDate;
 extern QString localeName;
 extern bool debug;
 extern bool testmode;
+extern bool batchMode;
 extern QTextStream vout;
 extern QStringList jiraPrefixList;
 extern bool jiraClientAvailable;
@@ -173,6 +184,7 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
 
     // Define commands in API (used globally)
     setupAPI();
+    startupStep ("  Commands");
 
     // Initialize some settings, which are platform dependant
     QString p,s;
@@ -224,6 +236,11 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
 
     layout->addWidget (tabWidget);
 
+    // Maps loaded in background, e.g. when restoring a session
+    mapLoader = new MapLoader (this);
+    connect (mapLoader, SIGNAL (mapReady (VymModel*, const QString&, const QString&)),
+             this, SLOT (attachLoadedMap (VymModel*, const QString&, const QString&)));
+
     switchboard.addGroup("MainWindow",tr("Main window","Shortcut group"));
     switchboard.addGroup("MapEditor",tr("Map Editors","Shortcut group"));
     switchboard.addGroup("TextEditor",tr("Text Editors","Shortcut group"));
@@ -239,26 +256,35 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
     setupSettingsActions();
     setupContextMenus();
     setupMacros();
+    startupStep ("  Actions and menus");
     setupFlagActions();
+    startupStep ("  Flags");
     setupToolbars();
+    startupStep ("  Toolbars");
 
     // Dock widgets ///////////////////////////////////////////////
+    // In batch mode note, script and task editors are not created
     QDockWidget *dw;
-    dw = new QDockWidget ();
-    dw->setWidget (noteEditor);
-    dw->setObjectName ("NoteEditor");
-    dw->setWindowTitle(noteEditor->getEditorTitle() );
-    dw->hide();
-    noteEditorDW=dw;
-    addDockWidget (Qt::LeftDockWidgetArea,dw);
+    noteEditorDW = NULL;
+    if (noteEditor)
+    {
+        dw = new QDockWidget ();
+        dw->setWidget (noteEditor);
+        dw->setObjectName ("NoteEditor");
+        dw->setWindowTitle(noteEditor->getEditorTitle() );
+        dw->hide();
+        noteEditorDW=dw;
+        addDockWidget (Qt::LeftDockWidgetArea,dw);
+    }
 
+    // Some docks are only created empty here, their contents on first use
     dw = new QDockWidget ();
-    dw->setWidget (headingEditor);
     dw->setObjectName ("HeadingEditor");
-    dw->setWindowTitle(headingEditor->getEditorTitle() );
+    dw->setWindowTitle (tr("Heading Editor","HeadingEditor"));
     dw->hide();
     headingEditorDW=dw;
     addDockWidget (Qt::BottomDockWidgetArea,dw);
+    connect (dw, SIGNAL (visibilityChanged(bool) ), this, SLOT (createDockContents(bool)));
 
     findResultWidget=new FindResultWidget ();
     dw= new QDockWidget (tr ("Search results list","FindResultWidget"));
@@ -273,12 +299,16 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
 	findResultWidget, SIGNAL (findPressed (QString, bool) ),
 	this, SLOT (editFindNext(QString, bool) ) );
 
-    scriptEditor = new ScriptEditor(this);
-    dw= new QDockWidget (tr ("Script Editor","ScriptEditor"));
-    dw->setWidget (scriptEditor);
-    dw->setObjectName ("ScriptEditor");
-    dw->hide();	
-    addDockWidget (Qt::LeftDockWidgetArea,dw);
+    scriptEditor = NULL;
+    if (!batchMode)
+    {
+        scriptEditor = new ScriptEditor(this);
+        dw= new QDockWidget (tr ("Script Editor","ScriptEditor"));
+        dw->setWidget (scriptEditor);
+        dw->setObjectName ("ScriptEditor");
+        dw->hide();	
+        addDockWidget (Qt::LeftDockWidgetArea,dw);
+    }
 
     scriptOutput = new ScriptOutput( this );
     dw = new QDockWidget (tr("Script output window"));
@@ -287,29 +317,36 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
     dw->hide();
     addDockWidget (Qt::BottomDockWidgetArea,dw);
 
-    branchPropertyEditor = new BranchPropertyEditor();
+    branchPropertyEditor = NULL;
     dw = new QDockWidget (tr("Property Editor","PropertyEditor"));
-    dw->setWidget (branchPropertyEditor);
     dw->setObjectName ("PropertyEditor");
     dw->hide();
+    propertyEditorDW=dw;
     addDockWidget (Qt::LeftDockWidgetArea,dw);
+    connect (dw, SIGNAL (visibilityChanged(bool) ), this, SLOT (createDockContents(bool)));
 
-    historyWindow=new HistoryWindow();
+    historyWindow = NULL;
     dw = new QDockWidget (tr("History window","HistoryWidget"));
-    dw->setWidget (historyWindow);
     dw->setObjectName ("HistoryWidget");
     dw->hide();
+    historyWindowDW=dw;
     addDockWidget (Qt::RightDockWidgetArea,dw);
+    connect (dw, SIGNAL (visibilityChanged(bool) ), this, SLOT (createDockContents(bool)));
     connect (dw, SIGNAL (visibilityChanged(bool ) ), this, SLOT (updateActions()));
 
     // Connect NoteEditor, so that we can update flags if text changes
-    connect (noteEditor, SIGNAL (textHasChanged() ), this, SLOT (updateNoteFlag()));
-    connect (noteEditor, SIGNAL (windowClosed() ), this, SLOT (updateActions()));
+    if (noteEditor)
+    {
+        connect (noteEditor, SIGNAL (textHasChanged() ), this, SLOT (updateNoteFlag()));
+        connect (noteEditor, SIGNAL (windowClosed() ), this, SLOT (updateActions()));
+    }
 
-    // Connect heading editor
-    connect (headingEditor, SIGNAL (textHasChanged() ), this, SLOT (updateHeading()));
+    startupStep ("  Docks");
 
-    connect( scriptEditor, SIGNAL( runScript ( QString ) ),  this, SLOT( runScript ( QString ) ) );
+    if (scriptEditor)
+        connect( scriptEditor, SIGNAL( runScript ( QString ) ),  this, SLOT( runScript ( QString ) ) );
+    setupScriptEngine();
+    startupStep ("  Script engine");
 
     // Switch back  to MapEditor using Esc  or end presentation mode
     QAction* a = new QAction(this);
@@ -321,13 +358,17 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
     connect (a , SIGNAL (triggered() ), this, SLOT (escapePressed()));
     
     // Create TaskEditor after setting up above actions, allow cloning 
-    taskEditor = new TaskEditor ();
-    dw= new QDockWidget (tr ("Task list","TaskEditor"));
-    dw->setWidget (taskEditor);
-    dw->setObjectName ("TaskEditor");
-    dw->hide();
-    addDockWidget (Qt::TopDockWidgetArea,dw);
-    connect (dw, SIGNAL (visibilityChanged(bool ) ), this, SLOT (updateActions()));
+    taskEditor = NULL;
+    if (!batchMode)
+    {
+        taskEditor = new TaskEditor ();
+        dw= new QDockWidget (tr ("Task list","TaskEditor"));
+        dw->setWidget (taskEditor);
+        dw->setObjectName ("TaskEditor");
+        dw->hide();
+        addDockWidget (Qt::TopDockWidgetArea,dw);
+        connect (dw, SIGNAL (visibilityChanged(bool ) ), this, SLOT (updateActions()));
+    }
     //FIXME -0 connect (taskEditor, SIGNAL (focusReleased() ), this, SLOT (setFocusMapEditor()));
 
     if (options.isOn("shortcutsLaTeX")) switchboard.printLaTeX();
@@ -347,7 +388,12 @@ Main::Main(QWidget* parent, Qt::WindowFlags f) : QMainWindow(parent,f)
     //progressDialog.setWindowModality (Qt::WindowModal);   // That forces mainwindo to update and slows down
     progressDialog.setCancelButton (NULL);
 
-    restoreState (settings.value("/mainwindow/state",0).toByteArray());
+    // In batch mode docks stay hidden and are never created
+    if (!batchMode)
+    {
+        restoreState (settings.value("/mainwindow/state",0).toByteArray());
+        startupStep ("  Restoring window state");
+    }
 
     // Enable testmenu
     //settings.setValue( "mainwindow/showTestMenu", true);
@@ -383,7 +429,7 @@ Main::~Main()
 	settings.setValue ("/mainwindow/view/AntiAlias",actionViewToggleAntiAlias->isChecked());
 	settings.setValue ("/mainwindow/view/SmoothPixmapTransform",actionViewToggleSmoothPixmapTransform->isChecked());
 	settings.setValue( "/system/autosave/use",actionSettingsToggleAutosave->isChecked() );
-	settings.setValue ("/system/autosave/ms", settings.value("/system/autosave/ms",60000)); 
+	settings.setValue ("/system/autosave/ms", settings.value("/system/autosave/ms",900000)); 
 	settings.setValue ("/mainwindow/autoLayout/use",actionSettingsToggleAutoLayout->isChecked() );
 	settings.setValue( "/mapeditor/editmode/autoSelectNewBranch",actionSettingsAutoSelectNewBranch->isChecked() );
 	settings.setValue( "/system/writeBackupFile",actionSettingsWriteBackupFile->isChecked() );
@@ -407,25 +453,165 @@ Main::~Main()
     delete historyWindow;
     delete branchPropertyEditor;
 
+    // Global caches hold pixmaps and fonts, which must not outlive QApplication
+    imageCache.clear();
+    headingLayoutCache.clear();
+    Flag::clearPixmapCache();
+
     // Remove temporary directory
     removeDir (QDir(tmpVymDir));
 }
 
 void Main::loadCmdLine()
 {
-    QStringList flist = options.getFileList();
-    QStringList::Iterator it = flist.begin();
+    // main() expects maps to be loaded afterwards
+    fileLoadMaps (options.getFileList() );
+    waitForMaps();
+}
+
+int Main::convertMaps (const QStringList &files, const QString &format, const QString &outDir, int jobs)
+{
+    // Used for "--convert": Load each map, export it and close it again
+    // without any user interaction. Timings are reported on stdout.
+    QMap <QString, QString> suffixes;
+    suffixes["ascii"]    = ".txt";
+    suffixes["csv"]      = ".csv";
+    suffixes["html"]     = ".html";
+    suffixes["latex"]    = ".tex";
+    suffixes["markdown"] = ".md";
+    suffixes["orgmode"]  = ".org";
+    suffixes["xml"]      = ".xml";
 
-    initProgressCounter (flist.count());
-    while (it != flist.end() )
+    QString f = format.toLower();
+    if (!suffixes.contains (f))
     {
-	FileType type = getMapType (*it);
-	fileLoad (*it, NewMap,type);
-	*it++;
-    }	
-    removeProgressCounter();
-}
+        qWarning() << "Main::convertMaps  unknown format: " << format;
+        cout << "Available formats: " << qPrintable (QStringList (suffixes.keys()).join(", ")) << endl;
+        return 1;
+    }
 
+    // Maps with the same name would overwrite each other in outDir
+    QMap <QString, QString> destinations;
+    QStringList todo;
+    int failed = 0;
+    foreach (QString fn, files)
+    {
+        QFileInfo fi (fn);
+        QString dir = outDir.isEmpty() ? fi.absolutePath() : QDir (outDir).absolutePath();
+        QString dest = dir + "/" + fi.completeBaseName() + suffixes.value(f);
+        if (destinations.contains (dest))
+        {
+            cout << qPrintable (fn) << "\tsame output file as " << qPrintable (destinations.value (dest)) << endl;
+            failed++;
+            continue;
+        }
+        destinations[dest] = fn;
+        todo << fn;
+    }
+
+    if (jobs > 1 && todo.count() > 1)
+    {
+        // The model still depends on the GUI thread, so parallel work 
+        // is distributed to worker instances of vym
+        jobs = qMin (jobs, todo.count() );
+        QList <QStringList> chunks;
+        for (int i = 0; i < jobs; i++) chunks << QStringList();
+        for (int i = 0; i < todo.count(); i++) chunks[i % jobs] << todo.at(i);
+
+        QList <QProcess*> workers;
+        foreach (QStringList chunk, chunks)
+        {
+            QStringList args;
+            args << "-b" << "--convert" << format << "--jobs" << "1";
+            if (!outDir.isEmpty() ) args << "--outdir" << outDir;
+            if (options.isOn ("debug") ) args << "-d";
+            if (options.isOn ("local") ) args << "-l";
+            if (options.isOn ("testmode") ) args << "-t";
+            if (options.isOn ("locale") ) args << "--locale" << options.getArg ("locale");
+            args << chunk;
+
+            QProcess *p = new QProcess (this);
+            p->setProcessChannelMode (QProcess::ForwardedChannels);
+            p->start (QCoreApplication::applicationFilePath(), args);
+            workers << p;
+        }
+
+        foreach (QProcess *p, workers)
+        {
+            p->waitForFinished (-1);
+            if (p->exitStatus() != QProcess::NormalExit || p->exitCode() != 0) failed++;
+            delete p;
+        }
+        return failed > 0 ? 1 : 0;
+    }
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+    foreach (QString fn, todo)
+    {
+        QFileInfo fi (fn);
+        if (!fi.exists() )
+        {
+            cout << qPrintable (fn) << "\tmissing" << endl;
+            failed++;
+            continue;
+        }
+
+        QString dir = outDir.isEmpty() ? fi.absolutePath() : QDir (outDir).absolutePath();
+        QString dest = dir + "/" + fi.completeBaseName() + suffixes.value(f);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // Not using fileLoad, which might ask questions or lock the map.
+        // Loading only needs the scene, but no view, tab or tree editor
+        VymModel *m = new VymModel;
+        m->setInteractive (false);
+        MapEditor *me = new MapEditor (m);
+        m->setSelectionModel (new QItemSelectionModel (m));
+        m->setFilePath (fi.absoluteFilePath() );
+        if (m->loadMap (fi.absoluteFilePath(), NewMap, getMapType (fn) ) != File::Success)
+        {
+            cout << qPrintable (fn) << "\tload failed" << endl;
+            delete me;
+            delete m;
+            failed++;
+            continue;
+        }
+        qint64 loadTime = timer.restart();
+
+        QFile::remove (dest);
+        if (f == "ascii")
+            m->exportASCII (false, dest, false);
+        else if (f == "csv")
+            m->exportCSV (dest, false);
+        else if (f == "html")
+            m->exportHTML (dir, dest, false);
+        else if (f == "latex")
+            m->exportLaTeX (dest, false);
+        else if (f == "markdown")
+            m->exportMarkdown (dest, false);
+        else if (f == "orgmode")
+            m->exportOrgMode (dest, false);
+        else if (f == "xml")
+            m->exportXML (dir, dest, false);
+        qint64 exportTime = timer.elapsed();
+
+        bool ok = QFile (dest).exists();
+        if (!ok) failed++;
+        cout << qPrintable (fn) 
+             << "\tload " << loadTime << " ms" 
+             << "\texport " << exportTime << " ms" 
+             << "\t" << (ok ? "ok" : "export failed") << endl;
+
+        delete me;
+        delete m;
+    }
+    cout << "Converted " << files.count() - failed << " of " << files.count() 
+         << " maps in " << totalTimer.elapsed() << " ms" << endl;
+
+    return failed > 0 ? 1 : 0;
+}
 
 void Main::statusMessage(const QString &s)
 {
@@ -553,6 +739,11 @@ void Main::setupAPI()
     c->addPar (Command::Color,true, "New color");
     modelCommands.append(c);
 
+    c = new Command ("connectToServer", Command::Any);
+    c->addPar (Command::String,false, "Server sharing a map");
+    c->addPar (Command::Int,false, "Port of server");
+    modelCommands.append(c);
+
     c = new Command ("copy", Command::BranchOrImage);
     modelCommands.append(c);
 
@@ -567,6 +758,10 @@ void Main::setupAPI()
     c->addPar (Command::String,false,"Format (AO, ASCII, CONFLUENCE, CSV, HTML, Image, Impress, Last, LaTeX, Markdown, OrgMode, PDF, SVG, XML)");
     modelCommands.append(c);
 
+    c = new Command ("findWords", Command::Any);
+    c->addPar (Command::String,false,"Words, which all have to be part of heading or note");
+    modelCommands.append(c);
+
     c = new Command ("getDestPath", Command::Any);
     modelCommands.append(c);
 
@@ -600,6 +795,9 @@ void Main::setupAPI()
     c = new Command ("getSelectionString", Command::TreeItem);
     modelCommands.append(c);
 
+    c = new Command ("getShareSequence", Command::Any);
+    modelCommands.append(c);
+
     c = new Command ("getTaskPriorityDelta", Command::Branch); 
     modelCommands.append(c);
 
@@ -645,6 +843,9 @@ void Main::setupAPI()
 
     c = new Command ("importDir", Command::Branch);
     c->addPar (Command::String,false,"Directory name to import");
+    c->addPar (Command::Int,true,"Maximum depth of subdirectories, -1 for unlimited");
+    c->addPar (Command::String,true,"Import only files matching these wildcards, e.g. \"*.vym *.txt\"");
+    c->addPar (Command::Int,true,"Skip files larger than this number of bytes, -1 for unlimited");
     modelCommands.append(c);
 
     c = new Command ("isScrolled", Command::Branch); 
@@ -899,6 +1100,11 @@ void Main::setupAPI()
     c->addPar (Command::Int,false,"Width of xlink");
     modelCommands.append(c);
 
+    c = new Command ("shareMap", Command::Any); 
+    c->addPar (Command::Int,true,"Port, 0 for any free port");
+    c->addPar (Command::String,true,"Address to listen on, default is localhost only");
+    modelCommands.append(c);
+
     c = new Command ("sleep", Command::Any); 
     c->addPar (Command::Int,false,"Sleep (seconds)");
     modelCommands.append(c);
@@ -2555,7 +2761,11 @@ void Main::setupFlag (Flag *flag, QToolBar *tb, const QString &name, const QStri
     QAction *a;
     if (tb)
     {
-        a=new QAction (flag->getPixmap(),name,this);
+        // Let the icon decode the file, when the toolbar is shown
+        if (flag->getPath().isEmpty() )
+            a=new QAction (flag->getPixmap(),name,this);
+        else
+            a=new QAction (QIcon (flag->getPath()),name,this);
         // StandardFlag
         flag->setAction (a);
         a->setVisible (flag->isVisible());
@@ -2638,6 +2848,10 @@ void Main::setupSettingsActions()
     connect( a, SIGNAL( triggered() ), this, SLOT( settingsUndoLevels() ) );
     settingsMenu->addAction (a);
 
+    a = new QAction( tr( "Set memory used for images","Settings action")+"...", this);
+    connect( a, SIGNAL( triggered() ), this, SLOT( settingsImageCacheSize() ) );
+    settingsMenu->addAction (a);
+
     settingsMenu->addSeparator();
 
     a = new QAction( tr( "Autosave","Settings action"), this);
@@ -3216,7 +3430,9 @@ void Main::updateTabName( VymModel *vm)
     for (int i = 0; i < tabWidget->count(); i++)
         if ( view(i)->getModel() == vm )
         {
-            if ( vm->isReadOnly() )
+            if ( mapLoader->isLoading (vm) )
+                tabWidget->setTabText( i, QFileInfo (mapLoader->getFilePath (vm)).fileName() + " " + tr("(loading)") );
+            else if ( vm->isReadOnly() )
                 tabWidget->setTabText( i, vm->getFileName() + " " + tr("(readonly)") );
             else
                 tabWidget->setTabText( i, vm->getFileName() );
@@ -3227,12 +3443,16 @@ void Main::updateTabName( VymModel *vm)
 void Main::editorChanged()
 {
     VymModel *vm=currentModel();
+
+    // Map in current tab is loaded next
+    mapLoader->setPriority (vm);
+
     if (vm) 
     {	
 	updateNoteEditor (vm->getSelectedIndex() );
 	updateQueries (vm);
 
-	taskEditor->setMapName (vm->getMapName() );
+	if (taskEditor) taskEditor->setMapName (vm->getMapName() );
     }	
 
     // Update actions to in menus and toolbars according to editor
@@ -3333,10 +3553,14 @@ File::ErrorCode Main::fileLoad(QString fn, const LoadMode &lmode, const FileType
     if ( !fn.isEmpty() )
     {
 	vm = currentModel();
+
+	// Maps still being loaded in background are only placeholders
+	if ( lmode!=NewMap && vm && mapLoader->isLoading (vm) ) return File::Aborted;
+
 	// Check first, if mapeditor exists
 	// If it is not default AND we want a new map, 
 	// create a new mapeditor in a new tab
-	if ( lmode==NewMap && (!vm || !vm->isDefault() )  )
+	if ( lmode==NewMap && (!vm || !vm->isDefault() || mapLoader->isLoading (vm) )  )
 	{
 	    vm=new VymModel;
 	    VymView *vv=new VymView (vm);
@@ -3450,12 +3674,17 @@ void Main::fileLoad(const LoadMode &lmode)
 
     if (!fns.isEmpty() )
     {
-        initProgressCounter (fns.count() );
 	lastMapDir.setPath(fns.first().left(fns.first().lastIndexOf ("/")) );
-	foreach (QString fn, fns)
-	    fileLoad(fn, lmode, getMapType (fn) );		   
+        if (lmode == NewMap)
+            fileLoadMaps (fns);
+        else
+        {
+            initProgressCounter (fns.count() );
+            foreach (QString fn, fns)
+                fileLoad(fn, lmode, getMapType (fn) );		   
+            removeProgressCounter();
+        }
     }
-    removeProgressCounter();
 
     fileSaveSession();
 }
@@ -3475,19 +3704,92 @@ void Main::fileSaveSession()
     settings.setValue("/mainwindow/sessionFileList", flist);
 }
 
-void Main::fileRestoreSession()
+void Main::fileLoadMaps(const QStringList &fns)
+{
+    // Maps get a tab immediately and are unzipped in background. 
+    // Building the models is done one by one, current tab first.
+    foreach (QString fn, fns)
+    {
+        fn = QDir (fn).absolutePath();
+
+        // Missing or already opened maps need some interaction 
+        bool opened = false;
+        for (int i = 0; i < tabWidget->count(); i++)
+        {
+            VymModel *m = view(i)->getModel();
+            if (m->getFilePath() == fn || mapLoader->getFilePath (m) == fn) opened = true;
+        }
+        if (opened || !QFile (fn).exists() )
+        {
+            fileLoad (fn, NewMap, getMapType (fn) );
+            continue;
+        }
+
+        bool ok;
+        QString tmpDir = makeTmpDir (ok, tmpVymDir, "load");
+        if (!ok)
+        {
+            fileLoad (fn, NewMap, getMapType (fn) );
+            continue;
+        }
+
+        // Placeholder until map is loaded. File path is only set
+        // in attachLoadedMap, so the placeholder can't be saved over the map
+        VymModel *vm = currentModel();
+        if (!vm || !vm->isDefault() || mapLoader->isLoading (vm) )
+        {
+            vm = new VymModel;
+            VymView *vv = new VymView (vm);
+            tabWidget->addTab (vv, fn);
+            vv->initFocus();
+        }
+        mapLoader->addMap (vm, fn, tmpDir);
+        vm->setReadOnly (true);
+    }
+}
+
+void Main::waitForMaps()
 {
-    QStringList flist= settings.value("/mainwindow/sessionFileList").toStringList();
-    QStringList::Iterator it=flist.begin();
+    if (mapLoader->isIdle() ) return;
 
-    initProgressCounter (flist.count());
-    while (it !=flist.end() )
+    QEventLoop loop;
+    connect (mapLoader, SIGNAL (finished()), &loop, SLOT (quit()));
+    loop.exec (QEventLoop::ExcludeUserInputEvents);
+}
+
+void Main::attachLoadedMap(VymModel *vm, const QString &fn, const QString &mapFile)
+{
+    statusBar()->showMessage( "Loading " + fn, statusbarTime );
+
+    // Placeholder was readonly, loadMap might set it again for locked maps.
+    // Path is needed by loadMap for lockfile and journal
+    vm->setReadOnly (false);
+    vm->setFilePath (fn);
+    vm->saveStateBeforeLoad (NewMap, fn);
+    File::ErrorCode err = vm->loadMap (mapFile, NewMap, getMapType (fn) );
+
+    int i = 0;
+    while (i < tabWidget->count() && view(i)->getModel() != vm) i++;
+
+    if (err == File::Aborted) 
+    {
+        if (i < tabWidget->count() ) fileCloseMap (i, true);
+        statusBar()->showMessage( "Could not load " + fn, statusbarTime );
+    } else 
     {
-        FileType type=getMapType (*it);
-        fileLoad (*it, NewMap,type);
-        *it++;
+        vm->setFilePath (fn);
+        updateTabName( vm );
+        actionFilePrint->setEnabled (true);
+        if (vm == currentModel() ) editorChanged();
+        vm->emitShowSelection();
+        addRecentMap( fn );
+        statusBar()->showMessage( "Loaded " + fn, statusbarTime );
     }
-    removeProgressCounter();
+}
+
+void Main::fileRestoreSession()
+{
+    fileLoadMaps (settings.value("/mainwindow/sessionFileList").toStringList() );
 }
 
 void Main::fileLoadRecent()
@@ -3522,7 +3824,7 @@ void Main::fileSave(VymModel *m, const SaveMode &savemode)
 {
     if (!m) return;
 
-    if (m->isReadOnly() ) return;
+    if (m->isReadOnly() || mapLoader->isLoading (m) ) return;
 
     if ( m->getFilePath().isEmpty() )
     {
@@ -3557,7 +3859,7 @@ void Main::fileSave(VymModel *m)
 
 void Main::fileSaveAs(const SaveMode& savemode)
 {
-    if (currentMapEditor())
+    if (currentMapEditor() && !mapLoader->isLoading (currentModel()) )
     {
         QString filter;
         if (savemode == CompleteMap)
@@ -3897,7 +4199,7 @@ void Main::fileExportLast()
     if (m) m->exportLast();
 }
 
-bool Main::fileCloseMap(int i)
+bool Main::fileCloseMap(int i, bool discardChanges)
 {
     VymModel *m;
     VymView *vv;
@@ -3908,7 +4210,7 @@ bool Main::fileCloseMap(int i)
 
     if (m)
     {
-        if (m->hasChanged())
+        if (m->hasChanged() && !discardChanges)
         {
             QMessageBox mb( vymName,
                             tr("The map %1 has been modified but not saved yet. Do you want to").arg(m->getFileName()),
@@ -5235,6 +5537,20 @@ void Main::settingsUndoLevels()
    }	
 }
 
+void Main::settingsImageCacheSize()	    
+{
+    bool ok;
+    int i = QInputDialog::getInt(
+	this, 
+	"QInputDialog::getInt()",
+	tr("Memory used for images (MB):"), imageCache.getMaxSize() / 1024, 16, 65536, 16, &ok);
+    if (ok)
+    {
+	settings.setValue ("/system/imageCacheSize", i * 1024);
+	imageCache.setMaxSize (i * 1024);
+    }	
+}
+
 bool Main::useAutosave()
 {
     return actionSettingsToggleAutosave->isChecked();
@@ -5251,7 +5567,7 @@ void Main::settingsAutosaveTime()
     int i = QInputDialog::getInt(
 	this, 
 	vymName,
-	tr("Number of seconds before autosave:"), settings.value("/system/autosave/ms").toInt() / 1000, 10, 60000, 1, &ok);
+	tr("Number of seconds before autosave:"), settings.value("/system/autosave/ms",900000).toInt() / 1000, 10, 60000, 1, &ok);
     if (ok)
 	settings.setValue ("/system/autosave/ms",i * 1000);
 }
@@ -5309,6 +5625,8 @@ void Main::settingsToggleDownloads()
 
 void Main::windowToggleNoteEditor()
 {
+    if (!noteEditor) return;
+
     if (noteEditor->parentWidget()->isVisible() )
         noteEditor->parentWidget()->hide();
     else
@@ -5326,6 +5644,8 @@ void Main::windowToggleTreeEditor()
 
 void Main::windowToggleTaskEditor()
 {
+    if (!taskEditor) return;
+
     if (taskEditor->parentWidget()->isVisible() )
     {
 	taskEditor->parentWidget()->hide();
@@ -5345,6 +5665,8 @@ void Main::windowToggleSlideEditor()
 
 void Main::windowToggleScriptEditor()
 {
+    if (!scriptEditor) return;
+
     if (scriptEditor->parentWidget()->isVisible() )
     {
         scriptEditor->parentWidget()->hide();
@@ -5371,19 +5693,18 @@ void Main::windowToggleScriptOutput()
 
 void Main::windowToggleHistory()
 {
-    if (historyWindow->parentWidget()->isVisible())
-	historyWindow->parentWidget()->hide();
+    if (historyWindowDW->isVisible())
+	historyWindowDW->hide();
     else    
-	historyWindow->parentWidget()->show();
+	historyWindowDW->show();
 }
 
 void Main::windowToggleProperty()
 {
-    if (branchPropertyEditor->parentWidget()->isVisible())
-	branchPropertyEditor->parentWidget()->hide();
+    if (propertyEditorDW->isVisible())
+	propertyEditorDW->hide();
     else    
-	branchPropertyEditor->parentWidget()->show();
-    branchPropertyEditor->setModel (currentModel() );
+	propertyEditorDW->show();
 }
 
 void Main::windowShowHeadingEditor()
@@ -5393,12 +5714,44 @@ void Main::windowShowHeadingEditor()
 
 void Main::windowToggleHeadingEditor()
 {
-    if (headingEditor->parentWidget()->isVisible() )
-        headingEditor->parentWidget()->hide();
+    if (headingEditorDW->isVisible() )
+        headingEditorDW->hide();
     else
     {
-        headingEditor->parentWidget()->show();
-        headingEditor->setFocus();
+        headingEditorDW->show();
+        if (headingEditor) headingEditor->setFocus();
+    }
+}
+
+void Main::createDockContents (bool visible)
+{
+    // Create editors of docks, when they are shown first time
+    if (!visible) return;
+
+    VymModel *m = currentModel();
+    if (sender() == headingEditorDW && !headingEditor)
+    {
+        headingEditor = new HeadingEditor("headingeditor");
+        headingEditorDW->setWidget (headingEditor);
+        headingEditorDW->setWindowTitle (headingEditor->getEditorTitle() );
+        connect (headingEditor, SIGNAL (textHasChanged() ), this, SLOT (updateHeading()));
+
+        TreeItem *ti = m ? m->getSelectedItem() : NULL;
+        if (ti) headingEditor->setVymText (ti->getHeading() );
+    } else if (sender() == propertyEditorDW && !branchPropertyEditor)
+    {
+        branchPropertyEditor = new BranchPropertyEditor();
+        propertyEditorDW->setWidget (branchPropertyEditor);
+        branchPropertyEditor->setModel (m);
+    } else if (sender() == historyWindowDW && !historyWindow)
+    {
+        historyWindow = new HistoryWindow();
+        historyWindowDW->setWidget (historyWindow);
+        if (m) 
+        {
+            historyWindow->setWindowTitle (vymName + " - " +tr("History for %1","Window Caption").arg(m->getFileName()));
+            m->scheduleUpdate (VymModel::UpdateHistory);
+        }
     }
 }
 
@@ -5443,7 +5796,7 @@ void Main::clearScriptOutput()
 
 void Main::updateHistory(SimpleSettings &undoSet)
 {
-    historyWindow->update (undoSet);
+    if (historyWindow) historyWindow->update (undoSet);
 }
 
 void Main::updateHeading()
@@ -5469,7 +5822,7 @@ void Main::updateNoteEditor(QModelIndex index ) //FIXME-4 maybe change to TreeIt
         << "  item="<<ti->getHeading()<<" ("<<ti<<")";
     qDebug()<< "RT="<<ti->getNote().isRichText();
     */
-        if (ti)
+        if (ti && noteEditor)
             noteEditor->setNote (ti->getNote() );
         updateDockWidgetTitles( ti->getModel());
     }
@@ -5479,7 +5832,7 @@ void Main::selectInNoteEditor(QString s,int i)
 {
     // TreeItem is already selected at this time, therefor
     // the note is already in the editor
-    noteEditor->findText (s,0,i);
+    if (noteEditor) noteEditor->findText (s,0,i);
 }
 
 void Main::setFocusMapEditor()
@@ -5490,7 +5843,7 @@ void Main::setFocusMapEditor()
 
 void Main::changeSelection (VymModel *model, const QItemSelection &newsel, const QItemSelection &)
 {
-    branchPropertyEditor->setModel (model ); 
+    if (branchPropertyEditor) branchPropertyEditor->setModel (model ); 
 
     if (model && model == currentModel() )
     {
@@ -5499,11 +5852,14 @@ void Main::changeSelection (VymModel *model, const QItemSelection &newsel, const
         {
             ti = model->getItem(newsel.indexes().first());
 
-            // Update note editor
-            if (!ti->hasEmptyNote() )
-                noteEditor->setNote(ti->getNote() );
-            else
-                noteEditor->setNote(VymNote() );
+            // Update note editor, text is only parsed while editor is visible
+            if (noteEditor)
+            {
+                if (!ti->hasEmptyNote() )
+                    noteEditor->setNote(ti->getNote() );
+                else
+                    noteEditor->setNote(VymNote() );
+            }
             // Show URL and link in statusbar
             QString status;
             QString s = ti->getURL();
@@ -5512,28 +5868,31 @@ void Main::changeSelection (VymModel *model, const QItemSelection &newsel, const
             if (!s.isEmpty() ) status += "Link: " + s;
             if (!status.isEmpty() ) statusMessage (status);
 
-            headingEditor->setVymText (ti->getHeading() );
+            if (headingEditor) headingEditor->setVymText (ti->getHeading() );
 
             // Select in TaskEditor, if necessary
             Task *t = NULL;
             if (ti->isBranchLikeType() )
                 t = ((BranchItem*)ti)->getTask();
 
-            if (t)
-                taskEditor->select (t);
-            else
-                taskEditor->clearSelection();
-        } else
+            if (taskEditor)
+            {
+                if (t)
+                    taskEditor->select (t);
+                else
+                    taskEditor->clearSelection();
+            }
+        } else if (noteEditor)
             noteEditor->setInactive();
 
-        updateActions();
+        model->updateActions();
     }
 }
 
 void Main::updateDockWidgetTitles( VymModel *model)
 {
     QString s;
-    if (model && !model->isRepositionBlocked() ) 
+    if (model && !model->isRepositionBlocked() && noteEditor) 
     {
 	BranchItem *bi = model->getSelectedBranch();
         if (bi) s = bi->getHeadingPlain();
@@ -5546,11 +5905,11 @@ void Main::updateDockWidgetTitles( VymModel *model)
 void Main::updateActions()
 {
     // updateActions is also called when satellites are closed	
-    actionViewToggleNoteEditor->setChecked (noteEditor->parentWidget()->isVisible());
-    actionViewToggleTaskEditor->setChecked (taskEditor->parentWidget()->isVisible());
-    actionViewToggleHistoryWindow->setChecked (historyWindow->parentWidget()->isVisible());
-    actionViewTogglePropertyEditor->setChecked (branchPropertyEditor->parentWidget()->isVisible());
-    actionViewToggleScriptEditor->setChecked (scriptEditor->parentWidget()->isVisible());
+    actionViewToggleNoteEditor->setChecked (noteEditor && noteEditor->parentWidget()->isVisible());
+    actionViewToggleTaskEditor->setChecked (taskEditor && taskEditor->parentWidget()->isVisible());
+    actionViewToggleHistoryWindow->setChecked (historyWindowDW->isVisible());
+    actionViewTogglePropertyEditor->setChecked (propertyEditorDW->isVisible());
+    actionViewToggleScriptEditor->setChecked (scriptEditor && scriptEditor->parentWidget()->isVisible());
 
     VymView *vv=currentView();
     if (vv)
@@ -5653,7 +6012,7 @@ void Main::updateActions()
 	    actionRedo->setEnabled( false);
 
 	// History window
-	historyWindow->setWindowTitle (vymName + " - " +tr("History for %1","Window Caption").arg(m->getFileName()));
+	if (historyWindow) historyWindow->setWindowTitle (vymName + " - " +tr("History for %1","Window Caption").arg(m->getFileName()));
 
 	// Expanding/collapsing
 	actionExpandAll->setEnabled (true);
@@ -5900,8 +6259,10 @@ QScriptValue scriptStatusMessage( QScriptContext * context, QScriptEngine *)
     return QScriptValue();
 }
 
-QVariant Main::runScript (const QString &script)
+void Main::setupScriptEngine()
 {
+    // Global functions and objects are created only once and then 
+    // kept in scriptEngine for all scripts
     scriptEngine.globalObject().setProperty( "print", scriptEngine.newFunction( scriptPrint ) );
     scriptEngine.globalObject().setProperty( "abort", scriptEngine.newFunction( scriptAbort ) );
     scriptEngine.globalObject().setProperty( "statusMessage", scriptEngine.newFunction( scriptStatusMessage ) );
@@ -5911,17 +6272,72 @@ QVariant Main::runScript (const QString &script)
     //scriptEngine.globalObject().setProperty("model", val1);
 
     // Create Wrapper object for vym itself (mainwindow)
-    VymWrapper vymWrapper;
     QScriptValue val2 = scriptEngine.newQObject( &vymWrapper );
     scriptEngine.globalObject().setProperty("vym", val2);
 
     // Create wrapper object for selection
-    Selection selection;
     QScriptValue val3 = scriptEngine.newQObject( &selection );
     scriptEngine.globalObject().setProperty("selection", val3);
 
-    // Run script
-    QScriptValue result = scriptEngine.evaluate(script);
+    scriptPrograms.setMaxCost (200);
+    scriptModel = NULL;
+}
+
+QVariant Main::runScript (const QString &script, VymModel *m)
+{
+    // Run script, layout and other updates of current map are done once afterwards
+    VymModel *scriptModelOrg = scriptModel;
+    if (m) scriptModel = m;
+    QPointer <VymModel> model = scriptModel ? scriptModel : currentModel();
+    if (model) model->deferUpdates();
+    bool ok;
+    QVariant result = evaluateScript (script, ok);
+    if (model) model->resumeUpdates();
+    scriptModel = scriptModelOrg;
+
+    if (!ok) return QVariant("");
+    return result;
+}
+
+QVariantList Main::runScriptBatch (const QStringList &scripts, VymModel *m, QList <int> &errorLevels)
+{
+    // Like runScript, but layout is done once after all scripts.
+    // Scripts are run in order, also after one of them failed.
+    // errorLevel is 0 for success, 1 if script execution failed.
+    QVariantList results;
+    errorLevels.clear();
+
+    VymModel *scriptModelOrg = scriptModel;
+    if (m) scriptModel = m;
+    QPointer <VymModel> model = scriptModel ? scriptModel : currentModel();
+    if (model) model->deferUpdates();
+    foreach (QString script, scripts)
+    {
+        bool ok;
+        results.append (evaluateScript (script, ok));
+        errorLevels.append (ok ? 0 : 1);
+    }
+    if (model) model->resumeUpdates();
+    scriptModel = scriptModelOrg;
+
+    return results;
+}
+
+QVariant Main::evaluateScript (const QString &script, bool &ok)
+{
+    // Compile each script only once. Repeated commands e.g. from
+    // macros, undo/redo or DBus are taken from the cache
+    QScriptProgram program;
+    QScriptProgram *cached = scriptPrograms.object (script);
+    if (cached)
+        program = *cached;
+    else
+    {
+        program = QScriptProgram (script);
+        scriptPrograms.insert (script, new QScriptProgram (program) );
+    }
+
+    QScriptValue result = scriptEngine.evaluate(program);
 
     if (debug)
     {
@@ -5932,23 +6348,24 @@ QVariant Main::runScript (const QString &script)
         qDebug() << "     script: " << script;
     }
 
-    if (scriptEngine.hasUncaughtException()) {
+    ok = !scriptEngine.hasUncaughtException();
+    if (!ok) {
         // Warnings, in case that output window is not visible...
         statusMessage("Script execution failed");
         qWarning() << "Script execution failed";
 
         int line = scriptEngine.uncaughtExceptionLineNumber();
-        scriptOutput->append( QString("uncaught exception at line %1: %2").arg(line).arg(result.toString()));
-    } else
-        return scriptEngine.globalObject().property("lastResult").toVariant();
-
-    return QVariant(""); 
+        QString err = QString("uncaught exception at line %1: %2").arg(line).arg(result.toString());
+        scriptOutput->append( err );
+        return QVariant (err);
+    } 
+    return scriptEngine.globalObject().property("lastResult").toVariant();
 }
 
 QObject* Main::getCurrentModelWrapper() 
 {
     // Called from VymWrapper to find out current model in a script
-    VymModel *m = currentModel();
+    VymModel *m = scriptModel ? scriptModel : currentModel();
     if (m) 
         return m->getWrapper();
     else
@@ -6044,10 +6461,298 @@ void Main::toggleHideExport()
 
 void Main::testCommand()
 {
-    if (!currentMapEditor()) return;
+    if (!currentMapEditor() || !scriptEditor) return;
     scriptEditor->show();
 }
 
+static void printBenchmark (const QString &title, const QStringList &report)
+{
+    cout << qPrintable (title) << ":" << endl;
+    foreach (QString line, report)
+        cout << "  " << qPrintable (line) << endl;
+}
+
+int Main::runBenchmarks()
+{
+    // Used for "--benchmark": Run all benchmarks on the current map,
+    // print results and statistics of caches on stdout
+    VymModel *m = currentModel();
+    if (!m)
+    {
+        cout << "No map loaded for benchmarks" << endl;
+        return 1;
+    }
+
+    printBenchmark ("Scripting", benchmarkScripting (m));
+    printBenchmark ("Saving", benchmarkSaving (m));
+    printBenchmark ("Heading layout", benchmarkHeadings());
+    printBenchmark ("Navigation", benchmarkNavigation (m));
+    printBenchmark ("Tree filter", benchmarkFilter (m));
+
+    QStringList stats;
+    stats << QString("Image cache: %1 kB used of %2 kB, %3 entries")
+        .arg(imageCache.getSize())
+        .arg(imageCache.getMaxSize())
+        .arg(imageCache.getCount());
+    stats << QString("Heading layouts: %1 cached, %2 hits, %3 misses")
+        .arg(headingLayoutCache.getCount())
+        .arg(headingLayoutCache.getHits())
+        .arg(headingLayoutCache.getMisses());
+    stats << QString("Frame outlines: %1").arg(FrameObj::getOutlineCacheStats() );
+    stats << QString("XLink updates: %1").arg(XLinkObj::getUpdateStats() );
+    stats << "Updates of map:";
+    stats << m->getUpdateStats().split ("\n", QString::SkipEmptyParts);
+    printBenchmark ("Statistics", stats);
+
+    // Creates a map of its own
+    printBenchmark ("Ticket lookups", benchmarkTickets());
+    return 0;
+}
+
+QStringList Main::benchmarkScripting (VymModel *m)
+{
+    const int n = 1000;
+    QString command = "vym.currentMap().getHeadingPlainText();";
+    QElapsedTimer timer;
+    QStringList report;
+
+    // Main::runScript is used by "-R" and AdaptorVym::execute
+    timer.start();
+    for (int i = 0; i < n; i++) runScript (command);
+    report << QString("runScript:          %1 commands/s").arg(n * 1000.0 / qMax(timer.elapsed(), qint64(1)), 0, 'f', 0);
+
+    // VymModel::execute is used by AdaptorModel::execute, undo and redo 
+    timer.start();
+    for (int i = 0; i < n; i++) m->execute (command);
+    report << QString("VymModel::execute:  %1 commands/s").arg(n * 1000.0 / qMax(timer.elapsed(), qint64(1)), 0, 'f', 0);
+
+    // Macros are defined once and then called like in callMacro
+    runScript ( QString("function benchmark_macro() { %1 }").arg(command) );
+    timer.start();
+    for (int i = 0; i < n; i++) m->execute ("benchmark_macro();");
+    report << QString("Macro:              %1 commands/s").arg(n * 1000.0 / qMax(timer.elapsed(), qint64(1)), 0, 'f', 0);
+
+    // Unique commands can't be taken from cache of compiled scripts
+    timer.start();
+    for (int i = 0; i < n; i++) runScript (QString("%1 // %2").arg(command).arg(i));
+    report << QString("Uncached commands:  %1 commands/s").arg(n * 1000.0 / qMax(timer.elapsed(), qint64(1)), 0, 'f', 0);
+
+    return report;
+}
+
+QStringList Main::benchmarkSaving (VymModel *m)
+{
+    QStringList report;
+    bool ok;
+    QString tmpDir = makeTmpDir (ok, m->tmpDirPath(), "benchmark");
+    if (!ok) return report;
+
+    const int n = 10;
+    QElapsedTimer timer;
+
+    // Like a zipped save: Each save uses a fresh directory
+    timer.start();
+    for (int i = 0; i < n; i++)
+    {
+        QString dir = tmpDir + QString("/save-%1/").arg(i);
+        makeSubDirs (dir);
+        saveStringToDisk (dir + "map.xml", m->saveToDir (dir, "", true, QPointF(), NULL) );
+    }
+    report << QString("Save to new directory:      %1 ms/save").arg(timer.elapsed() / (qreal)n, 0, 'f', 1);
+
+    // Like saving unzipped or autosave: Images are already in directory
+    QString dir = tmpDir + "/save-0/";
+    timer.start();
+    for (int i = 0; i < n; i++)
+        saveStringToDisk (dir + "map.xml", m->saveToDir (dir, "", true, QPointF(), NULL) );
+    report << QString("Save to existing directory: %1 ms/save").arg(timer.elapsed() / (qreal)n, 0, 'f', 1);
+
+    int images = 0;
+    BranchItem *cur  = NULL;
+    BranchItem *prev = NULL;
+    m->nextBranch(cur, prev);
+    while (cur) 
+    {
+        images += cur->imageCount();
+        m->nextBranch(cur, prev);
+    }
+    report << QString("Images: %1 in map, %2 files written")
+        .arg(images)
+        .arg(QDir (dir + "images").entryList (QDir::Files).count() );
+
+    removeDir (QDir (tmpDir));
+    return report;
+}
+
+QStringList Main::benchmarkHeadings()
+{
+    // Like loading a map with 50k headings, many of them identical
+    const int n = 50000;
+    QStringList texts;
+    for (int i = 0; i < n; i++)
+        texts << QString("Heading number %1 with some more words to wrap").arg(i % 1000);
+    QFont font;
+
+    QElapsedTimer timer;
+    QStringList report;
+
+    timer.start();
+    foreach (QString t, texts)
+        delete new HeadingLayout (t, font, 40);
+    report << QString("Layout without cache: %1 ms for %2 headings").arg(timer.elapsed()).arg(n);
+
+    HeadingLayoutCache cache;
+    QList <QSharedPointer <HeadingLayout> > layouts;
+    timer.start();
+    foreach (QString t, texts)
+        layouts << cache.getLayout (t, font, 40);
+    report << QString("Layout with cache:    %1 ms for %2 headings, %3 layouts")
+        .arg(timer.elapsed()).arg(n).arg(cache.getMisses());
+
+    return report;
+}
+
+QStringList Main::benchmarkNavigation (VymModel *m)
+{
+    // Like moving through the map with cursor keys: Select every 
+    // branch and update editors. Notes are only parsed if the note 
+    // editor is visible, the second pass uses the document cache
+    QList <BranchItem*> branches;
+    int notes = 0;
+    int noteSize = 0;
+    BranchItem *cur  = NULL;
+    BranchItem *prev = NULL;
+    m->nextBranch(cur, prev);
+    while (cur) 
+    {
+        branches << cur;
+        if (!cur->hasEmptyNote() && cur->getNote().isRichText() )
+        {
+            notes++;
+            noteSize += cur->getNote().getText().length();
+        }
+        m->nextBranch(cur, prev);
+    }
+    QElapsedTimer timer;
+    QStringList report;
+    if (branches.isEmpty() ) return report;
+
+    report << QString("Branches: %1, rich text notes: %2 with %3 kB")
+        .arg(branches.count()).arg(notes).arg(noteSize / 1024);
+    report << QString("Note editor visible: %1")
+        .arg(noteEditor && noteEditor->isVisible() ? "yes" : "no");
+
+    QString sel = m->getSelectString();
+    for (int pass = 1; pass <= 2; pass++)
+    {
+        timer.start();
+        foreach (BranchItem *bi, branches)
+        {
+            m->select (bi);
+            m->flushUpdates();
+        }
+        report << QString("Pass %1: %2 ms/selection")
+            .arg(pass)
+            .arg(timer.elapsed() / (qreal)branches.count(), 0, 'f', 2);
+    }
+    m->select (sel);
+    return report;
+}
+
+QStringList Main::benchmarkTickets()
+{
+    QStringList report;
+
+    // Local stub instead of jigger, answers after a short delay
+    QString stub = tmpVymDir + "/ticket-stub";
+    QFile file (stub);
+    if (!file.open (QIODevice::WriteOnly | QIODevice::Text) ) return report;
+    QTextStream ts (&file);
+    ts << "#!/bin/sh\n";
+    ts << "sleep 0.2\n";
+    ts << "for id in \"$@\"; do\n";
+    ts << "  echo \"$id:short_desc:\\\"Stub ticket $id\\\"\"\n";
+    ts << "  echo \"$id:status:\\\"Open\\\"\"\n";
+    ts << "done\n";
+    file.close();
+    file.setPermissions (QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    // New map with a subtree of tickets, some of them more than once
+    fileNew();
+    VymModel *m = currentModel();
+    if (!m) return report;
+    const int n = 300;
+    QList <BranchItem*> branches;
+    m->deferUpdates();
+    for (int i = 0; i < n; i++)
+    {
+        BranchItem *bi = m->addNewBranch (m->getSelectedBranch() );
+        if (!bi) return report;
+        m->setHeadingPlainText (QString ("BENCH-%1").arg(i % 250), bi);
+        branches << bi;
+    }
+    m->resumeUpdates();
+
+    JiraAgent agent;
+    agent.setScript (stub);
+
+    QElapsedTimer timer;
+    for (int pass = 1; pass <= 2; pass++)
+    {
+        timer.start();
+        foreach (BranchItem *bi, branches)
+            agent.request (bi, bi->getHeadingPlain().section (' ', 0, 0));
+        qApp->processEvents();
+        while (!agent.isIdle() && timer.elapsed() < 60000)
+            qApp->processEvents (QEventLoop::AllEvents, 50);
+
+        report << QString("Pass %1: %2 ms for %3 branches").arg(pass).arg(timer.elapsed()).arg(n);
+        report << QString("  processes: %1, tickets received: %2, cache hits: %3, update batches: %4")
+            .arg(agent.getProcessesStarted())
+            .arg(agent.getTicketsReceived())
+            .arg(agent.getCacheHits())
+            .arg(agent.getUpdateBatches());
+    }
+
+    return report;
+}
+
+QStringList Main::benchmarkFilter (VymModel *m)
+{
+    // Like typing the first word of the selected heading into a filter,
+    // one query per character
+    BranchItem *selbi = m->getSelectedBranch();
+    QStringList words = VymModel::splitWords (selbi ? selbi->getHeadingPlain() : QString() );
+    QString word = words.isEmpty() ? QString ("a") : words.first();
+
+    QElapsedTimer timer;
+    QStringList report;
+    int found = 0;
+
+    timer.start();
+    for (int i = 1; i <= word.length(); i++)
+        found = m->findRegExp (QRegExp (QRegExp::escape (word.left(i)), Qt::CaseInsensitive)).count();
+    report << QString("Scan:  %1 ms for %2 queries, %3 matches").arg(timer.elapsed()).arg(word.length()).arg(found);
+
+    for (int pass = 1; pass <= 2; pass++)
+    {
+        timer.start();
+        for (int i = 1; i <= word.length(); i++)
+            found = m->findWords (word.left(i)).count();
+        report << QString("Index: %1 ms for %2 queries, %3 matches (pass %4)")
+            .arg(timer.elapsed()).arg(word.length()).arg(found).arg(pass);
+    }
+
+    MySortFilterProxyModel proxy;
+    proxy.setModel (m);
+    timer.start();
+    for (int i = 1; i <= word.length(); i++)
+        proxy.setFilterText (word.left(i));
+    report << QString("Proxy: %1 ms for %2 queries, %3 matches").arg(timer.elapsed()).arg(word.length()).arg(proxy.matchCount());
+
+    return report;
+}
+
 void Main::helpDoc()
 {
     QString locale = QLocale::system().name();
@@ -6203,10 +6908,17 @@ void Main::callMacro ()
             i = i - 12;
         }
 
-        s += QString("macro_%1f%2();").arg(shift).arg(i);
-
         VymModel *m = currentModel();
-        if (m) m->execute(s);
+        if (m) 
+        {
+            // Evaluate macro definitions only, if they have changed
+            if (s != loadedMacros)
+            {
+                runScript (s);
+                if (!scriptEngine.hasUncaughtException() ) loadedMacros = s;
+            }
+            m->execute( QString("macro_%1f%2();").arg(shift).arg(i) );
+        }
     }	
 }
 
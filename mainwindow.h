@@ -1,11 +1,13 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QCache>
 #include <QMainWindow>
 #include <QPrinter>
 #include <QProgressDialog>
 #include <QScriptContext>
 #include <QScriptEngine>
+#include <QScriptProgram>
 #include <QScriptValue>
 #include <QTextStream>
 
@@ -15,6 +17,7 @@
 #include "file.h"
 #include "historywindow.h"
 #include "mapeditor.h"
+#include "maploader.h"
 #include "scripting.h"
 #include "texteditor.h"
 #include "vymview.h"
@@ -35,6 +38,8 @@ public:
     Main(QWidget* parent=0, Qt::WindowFlags f=0);
     ~Main();
     void loadCmdLine();
+    int convertMaps (const QStringList &files, const QString &format, const QString &outDir, int jobs = 1);
+    int runBenchmarks();
 
 private:
     QProgressDialog progressDialog;
@@ -106,7 +111,10 @@ private slots:
 public slots:    
     File::ErrorCode fileLoad(QString ,const LoadMode &, const FileType &ftype);
     void fileLoad(const LoadMode &);
+    void fileLoadMaps(const QStringList &);	//! Load multiple maps in background
+    void waitForMaps();				//! Wait for maps from fileLoadMaps, ignores user input
 private slots:
+    void attachLoadedMap(VymModel *vm, const QString &fn, const QString &mapFile);
     void fileLoad();
     void fileSaveSession();
 public slots:    
@@ -141,7 +149,7 @@ private slots:
     void fileExportTaskjuggler();
     void fileExportImpress();
     void fileExportLast();
-    bool fileCloseMap(int i = -1);  // Optionally pass number of tab
+    bool fileCloseMap(int i = -1, bool discardChanges = false);  // Optionally pass number of tab
     void filePrint();
     bool fileExitVYM();
 
@@ -279,6 +287,7 @@ public slots:
     void settingsZipTool();
     void settingsMacroPath();
     void settingsUndoLevels();
+    void settingsImageCacheSize();
 
 public:
     bool useAutosave();
@@ -322,11 +331,13 @@ public slots:
     ModMode getModMode();
     bool autoEditNewBranch();
     bool autoSelectNewBranch();
-    QVariant runScript(const QString &);
+    QVariant runScript(const QString &, VymModel *m = NULL);	//! Optionally m is used as vym.currentMap()
+    QVariantList runScriptBatch(const QStringList &scripts, VymModel *m, QList <int> &errorLevels); //! One layout for all scripts
     QObject* getCurrentModelWrapper();
     bool gotoWindow (const int &n);
 
 private slots:
+    void createDockContents (bool visible);	//! Editors in docks are created on first use
     void windowNextEditor();
     void windowPreviousEditor();
     void nextSlide();
@@ -362,23 +373,39 @@ public slots:
     void togglePresentationMode();
 
 private:
+    QStringList benchmarkScripting (VymModel *m);	//! Benchmarks for "--benchmark" return their results
+    QStringList benchmarkSaving (VymModel *m);
+    QStringList benchmarkHeadings();
+    QStringList benchmarkNavigation (VymModel *m);
+    QStringList benchmarkTickets();
+    QStringList benchmarkFilter (VymModel *m);
     QString shortcutScope;          //! For listing shortcuts
     QTabWidget *tabWidget;
+    MapLoader *mapLoader;
     qint64 *browserPID;
 
     QStringList imageTypes;
 
+    void setupScriptEngine();
     QScriptEngine scriptEngine;
+    VymWrapper vymWrapper;			    //! Global "vym" object in scripts
+    Selection selection;			    //! Global "selection" object in scripts
+    QVariant evaluateScript (const QString &script, bool &ok);	//! Result or error message
+    QCache <QString, QScriptProgram> scriptPrograms;	//! Compiled scripts, e.g. from undo or DBus
+    QString loadedMacros;			    //! Macro definitions already evaluated in scriptEngine
+    VymModel *scriptModel;			    //! Model of currently running script, if not the current one
 
     QString prevSelection;
 
-    HistoryWindow *historyWindow;
+    HistoryWindow *historyWindow;	    //! NULL until shown first time
+    QDockWidget *historyWindowDW;
 
     QDockWidget *headingEditorDW;
     QDockWidget *noteEditorDW;
     QDockWidget *scriptEditorDW;
 
-    BranchPropertyEditor *branchPropertyEditor;
+    BranchPropertyEditor *branchPropertyEditor; //! NULL until shown first time
+    QDockWidget *propertyEditorDW;
 
 public:
     QList <QAction*> mapEditorActions;      //! allows mapEditor to clone actions and shortcuts
@@ -0,0 +1,160 @@
+#include "maploader.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QThread>
+#include <QtConcurrent>
+
+#include "file.h"
+#include "vymmodel.h"
+
+extern bool debug;
+
+MapLoader::MapLoader (QObject *parent) : QObject (parent)
+{
+    running = 0;
+    maxThreads = qMax (1, QThread::idealThreadCount() );
+
+    nextTimer.setSingleShot (true);
+    nextTimer.setInterval (0);
+    connect (&nextTimer, SIGNAL (timeout()), this, SLOT (processNext()));
+}
+
+MapLoader::~MapLoader()
+{
+    foreach (Job *job, jobs)
+    {
+	if (job->watcher)
+	{
+	    job->watcher->waitForFinished();
+	    delete job->watcher;
+	}
+	removeDir (QDir (job->tmpDir));
+	delete job;
+    }
+}
+
+void MapLoader::addMap (VymModel *m, const QString &fn, const QString &tmpDir)
+{
+    Job *job = new Job;
+    job->model = m;
+    job->fn = fn;
+    job->tmpDir = tmpDir;
+    job->watcher = NULL;
+    jobs.append (job);
+
+    startPrepares();
+}
+
+void MapLoader::setPriority (VymModel *m)
+{
+    priorityModel = m;
+}
+
+bool MapLoader::isLoading (VymModel *m)
+{
+    foreach (Job *job, jobs)
+	if (job->model == m) return true;
+    return false;
+}
+
+QString MapLoader::getFilePath (VymModel *m)
+{
+    foreach (Job *job, jobs)
+	if (job->model == m) return job->fn;
+    return QString();
+}
+
+bool MapLoader::isIdle()
+{
+    return jobs.isEmpty();
+}
+
+void MapLoader::prepareFinished()
+{
+    running--;
+    startPrepares();
+    nextTimer.start();
+}
+
+void MapLoader::processNext()
+{
+    Job *job = nextJob (true);
+    if (!job) return;
+
+    jobs.removeAll (job);
+
+    // Build model in GUI thread, unless the map has been closed meanwhile
+    if (job->model)
+    {
+	QString mapFile = job->watcher->result();
+	if (mapFile.isEmpty() ) mapFile = job->fn;
+	emit (mapReady (job->model, job->fn, mapFile));
+    }
+
+    delete job->watcher;
+    removeDir (QDir (job->tmpDir));
+    delete job;
+
+    // Allow repaints and input before next map
+    if (nextJob (true)) nextTimer.start();
+
+    if (jobs.isEmpty() ) emit (finished());
+}
+
+QString MapLoader::prepare (const QString &fn, const QString &tmpDir)
+{
+    // Runs in worker thread
+    if (fn.endsWith (".xml") || fn.endsWith (".mm")) return fn;
+
+    if (unzipDirQuiet (QDir (tmpDir), fn) != File::Success) return QString();
+
+    // Look for mapname.xml or a single other .xml like VymModel::loadMap
+    QString xmlfile = tmpDir + "/" + QFileInfo (fn).completeBaseName() + ".xml";
+    if (QFile (xmlfile).exists() ) return xmlfile;
+
+    QStringList flist = QDir (tmpDir).entryList (QStringList() << "*.xml");
+    if (flist.count() == 1) return tmpDir + "/" + flist.first();
+
+    return QString();
+}
+
+void MapLoader::startPrepares()
+{
+    while (running < maxThreads)
+    {
+	Job *job = nextJob (false);
+	if (!job) return;
+
+	if (debug) qDebug() << "MapLoader: unzipping " << job->fn;
+	job->watcher = new QFutureWatcher <QString> (this);
+	connect (job->watcher, SIGNAL (finished()), this, SLOT (prepareFinished()));
+	job->watcher->setFuture (QtConcurrent::run (&MapLoader::prepare, job->fn, job->tmpDir));
+	running++;
+    }
+}
+
+MapLoader::Job* MapLoader::nextJob (bool started)
+{
+    // Return job which can be unzipped (started == false) or
+    // which is unzipped and can be loaded (started == true)
+    Job *first = NULL;
+    foreach (Job *job, jobs)
+    {
+	bool ok = started ?
+	    job->watcher && job->watcher->isFinished() :
+	    !job->watcher;
+	if (!ok) continue;
+	if (priorityModel && job->model == priorityModel) return job;
+	if (!first) first = job;
+    }
+
+    // Wait for the map with priority, if it is not unzipped yet
+    if (started && priorityModel)
+    {
+	foreach (Job *job, jobs)
+	    if (job->model == priorityModel && job->watcher && !job->watcher->isFinished() )
+		return NULL;
+    }
+    return first;
+}
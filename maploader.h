@@ -0,0 +1,64 @@
+#ifndef MAPLOADER_H
+#define MAPLOADER_H
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class VymModel;
+
+/*! \brief Load multiple maps, e.g. when restoring a session
+
+    Unzipping the maps is done on worker threads. Building the model
+    itself still has to be done in the GUI thread, so maps are passed
+    on one by one with mapReady() as soon as they are unzipped.
+    The map set with setPriority() is unzipped and passed on first.
+
+    Models are only placeholders until mapReady(). Their file path is
+    not set before, so they can't overwrite the map by saving.
+*/
+
+class MapLoader:public QObject {
+    Q_OBJECT
+
+public:
+    MapLoader (QObject *parent = NULL);
+    ~MapLoader();
+    void addMap (VymModel *m, const QString &fn, const QString &tmpDir);
+    void setPriority (VymModel *m);
+    bool isLoading (VymModel *m);
+    QString getFilePath (VymModel *m);	//! Map loaded into m, empty if none
+    bool isIdle();
+
+signals:
+    //! mapFile is the unzipped map or fn, if unzipping failed or was not necessary
+    void mapReady (VymModel *m, const QString &fn, const QString &mapFile);
+    void finished();
+
+private slots:
+    void prepareFinished();
+    void processNext();
+
+private:
+    struct Job
+    {
+	QPointer <VymModel> model;
+	QString fn;
+	QString tmpDir;
+	QFutureWatcher <QString> *watcher;  //! NULL until unzipping is started
+    };
+
+    static QString prepare (const QString &fn, const QString &tmpDir);
+    void startPrepares();
+    Job* nextJob (bool started);
+
+    QList <Job*> jobs;
+    QPointer <VymModel> priorityModel;
+    QTimer nextTimer;
+    int running;
+    int maxThreads;
+};
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <QDebug>
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QString>
 
 extern QString vymVersion;
@@ -294,3 +295,20 @@ bool versionLowerOrEqual (const QString &v, const QString &vstatic)
     if (vs3 < v3) return false;
     return true;    
 }
+
+static QElapsedTimer startupTimer;
+static qint64 startupLast = 0;
+static QStringList startupSteps;
+
+void startupStep (const QString &step)
+{
+    if (!startupTimer.isValid() ) startupTimer.start();
+    qint64 now = startupTimer.elapsed();
+    startupSteps << QString ("%1 ms  %2").arg(now - startupLast, 6).arg(step);
+    startupLast = now;
+}
+
+QStringList startupReport ()
+{
+    return startupSteps + (QStringList() << QString ("%1 ms  Total").arg(startupLast, 6));
+}
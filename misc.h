@@ -2,6 +2,7 @@
 #define MISC_H
 
 #include <Qt>
+#include <QStringList>
 #include <iostream>
 using namespace std;
 
@@ -40,4 +41,7 @@ bool versionLowerThanVym(const QString &);
 bool versionLowerOrEqualThanVym(const QString &);
 bool versionLowerOrEqual(const QString &, const QString &);
 
+void startupStep (const QString &step);	//! Remember time used since previous step
+QStringList startupReport ();		//! Steps of startup, shown with "vym --timing"
+
 #endif
@@ -1,37 +1,90 @@
-//#include <QtGui>
-
 #include "mysortfilterproxymodel.h"
 
+#include "treeitem.h"
+#include "vymmodel.h"
+
 MySortFilterProxyModel::MySortFilterProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
 {
+    model = NULL;
+    useRegExp = false;
+
+    // Collect changes of the map, e.g. while a script is running
+    updateTimer.setSingleShot (true);
+    updateTimer.setInterval (0);
+    connect (&updateTimer, SIGNAL (timeout()), this, SLOT (updateMatches()));
 }
-//! [0]
 
-/*
-//! [1]
-void MySortFilterProxyModel::setFilterMinimumDate(const QDate &date)
+void MySortFilterProxyModel::setModel (VymModel *m)
 {
-    minDate = date;
-    invalidateFilter();
+    if (model) disconnect (model, 0, this, SLOT (scheduleUpdate()));
+    model = m;
+    setSourceModel (model);
+    if (model)
+    {
+	connect (model, SIGNAL (dataChanged (const QModelIndex &, const QModelIndex &)),
+	    this, SLOT (scheduleUpdate()));
+	connect (model, SIGNAL (rowsInserted (const QModelIndex &, int, int)),
+	    this, SLOT (scheduleUpdate()));
+	connect (model, SIGNAL (rowsRemoved (const QModelIndex &, int, int)),
+	    this, SLOT (scheduleUpdate()));
+	connect (model, SIGNAL (layoutChanged()), this, SLOT (scheduleUpdate()));
+	connect (model, SIGNAL (modelReset()), this, SLOT (scheduleUpdate()));
+    }
+    updateMatches();
+}
+
+void MySortFilterProxyModel::setFilterText (const QString &s, bool regExp)
+{
+    filterText = s;
+    useRegExp = regExp;
+    updateMatches();
+}
+
+void MySortFilterProxyModel::clearFilter()
+{
+    setFilterText (QString() );
 }
-//! [1]
 
-//! [2]
-void MySortFilterProxyModel::setFilterMaximumDate(const QDate &date)
+int MySortFilterProxyModel::matchCount()
 {
-    maxDate = date;
+    return matches.count();
+}
+
+void MySortFilterProxyModel::updateMatches()
+{
+    updateTimer.stop();
+    matches.clear();
+    accepted.clear();
+
+    if (model && !filterText.isEmpty() )
+    {
+	if (useRegExp)
+	    matches = model->findRegExp (QRegExp (filterText, Qt::CaseInsensitive));
+	else
+	    matches = model->findWords (filterText);
+
+	// Each ancestor is added only once, stop at the first one already there
+	foreach (TreeItem *ti, matches)
+	    while (ti && !accepted.contains (ti) )
+	    {
+		accepted.insert (ti);
+		ti = ti->parent();
+	    }
+    }
     invalidateFilter();
 }
-*/
 
-bool MySortFilterProxyModel::filterAcceptsRow(int sourceRow,	// FIXME-3 find a way to show _all_ rows which match, independent of parent
+void MySortFilterProxyModel::scheduleUpdate()
+{
+    if (!filterText.isEmpty() ) updateTimer.start();
+}
+
+bool MySortFilterProxyModel::filterAcceptsRow(int sourceRow,
         const QModelIndex &sourceParent) const
 {
-    QModelIndex index0 = sourceModel()->index(sourceRow, 0, sourceParent);
-    QModelIndex index1 = sourceModel()->index(sourceRow, 1, sourceParent);
+    if (filterText.isEmpty() ) return true;
 
-    return (sourceModel()->data(index0).toString().contains(filterRegExp())
-            || sourceModel()->data(index1).toString().contains(filterRegExp()));
+    QModelIndex ix = sourceModel()->index(sourceRow, 0, sourceParent);
+    return accepted.contains (static_cast <TreeItem*> (ix.internalPointer()) );
 }
-
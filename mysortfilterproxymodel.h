@@ -1,35 +1,52 @@
 #ifndef MYSORTFILTERPROXYMODEL_H
 #define MYSORTFILTERPROXYMODEL_H
 
-//#include <QDate>
+#include <QRegExp>
+#include <QSet>
 #include <QSortFilterProxyModel>
+#include <QTimer>
+
+class TreeItem;
+class VymModel;
+
+/*! \brief Filter for the tree of a VymModel
+
+    Rows are accepted, if heading or note of the item match the filter
+    or if one of its children matches. So matches are shown independent
+    of their parents.
+
+    Plain text is looked up in the word index of VymModel, regular
+    expressions need a scan of the whole map. In both cases matches and
+    their ancestors are computed once when the filter or the map changes,
+    filterAcceptsRow then only looks up the item.
+*/
 
-//! [0]
 class MySortFilterProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 
 public:
     MySortFilterProxyModel(QObject *parent = 0);
-/*
+    void setModel (VymModel *m);
+    //! Words like in VymModel::findWords or a regular expression
+    void setFilterText (const QString &s, bool regExp = false);
+    void clearFilter();
+    int matchCount();
 
-    QDate filterMinimumDate() const { return minDate; }
-    void setFilterMinimumDate(const QDate &date);
-
-    QDate filterMaximumDate() const { return maxDate; }
-    void setFilterMaximumDate(const QDate &date);
 protected:
-*/
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
-    /*
-    bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
 
-private:
-    bool dateInRange(const QDate &date) const;
+private slots:
+    void updateMatches();
+    void scheduleUpdate();
 
-    QDate minDate;
-    QDate maxDate;
-*/
+private:
+    VymModel *model;
+    QString filterText;
+    bool useRegExp;
+    QSet <TreeItem*> matches;
+    QSet <TreeItem*> accepted;			    //! matches and their ancestors
+    QTimer updateTimer;
 };
 
 #endif
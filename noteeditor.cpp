@@ -23,6 +23,7 @@ NoteEditor::~NoteEditor() {}
 
 VymNote NoteEditor::getNote()
 {
+    flushPendingText();
     VymNote note;
     if (actionFormatRichText->isChecked() )
         note.setRichText( getText());
@@ -34,6 +35,11 @@ VymNote NoteEditor::getNote()
 }
 
 void NoteEditor::setNote (const VymNote &note)  
+{
+    setVymText (note);
+}
+
+void NoteEditor::applyVymText (const VymText &note)  
 {
     if (note.isRichText ())
         setRichText(note.getText());
@@ -14,6 +14,9 @@ public:
 
     VymNote getNote();
     void setNote(const VymNote &note);
+
+protected:
+    virtual void applyVymText (const VymText &vt);
 };
 
 #endif
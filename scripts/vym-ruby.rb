@@ -141,6 +141,14 @@ class VymMap
         end
       end
   end # Initialize
+
+  # Run commands with one DBus call. Map is layouted once and
+  # all changes are a single undo step.
+  # Returns results and error levels (0 = ok) of all commands
+  def execute_batch (commands)
+    ret = @map.executeBatch( commands )
+    return ret[0], ret[1]
+  end
 end # VymMap
 
 class VymManager
@@ -1,3 +1,4 @@
+#include <QRegExp>
 #include <QStringList>
 
 #include "slideitem.h"
@@ -18,18 +19,26 @@ SlideItem::SlideItem(const QVector<QVariant> &data, SlideItem *parent, SlideMode
     zoomFactor=-1;
     duration=2000;
     easingCurve.setType (QEasingCurve::OutQuint);
+    target=false;
+    targetZoom=1;
+    targetAngle=0;
+    targetGeneration=0;
+    targetPosValid=false;
 
     if (sm)
 	model=sm;
     else
 	model=parent->getModel();
 
+    if (parentItem) model->registerSlide (this);
+
     if (data.isEmpty()) itemData.append(QVariant("empty"));
 }
 
 SlideItem::~SlideItem()
 {
     qDeleteAll(childItems);
+    if (parentItem) model->unregisterSlide (this);
 }
 
 SlideModel* SlideItem::getModel()
@@ -188,6 +197,7 @@ int SlideItem::getTreeItemID()
 void SlideItem::setInScript (const QString &s)
 {
     inScript=s;
+    parseInScript();
 }
 
 QString SlideItem::getInScript()
@@ -245,6 +255,84 @@ QEasingCurve SlideItem::getEasingCurve()
     return easingCurve;
 }
 
+bool SlideItem::hasTarget()
+{
+    return target;
+}
+
+qreal SlideItem::getTargetZoom()
+{
+    return targetZoom;
+}
+
+qreal SlideItem::getTargetAngle()
+{
+    return targetAngle;
+}
+
+QUuid SlideItem::getTargetUuid()
+{
+    return targetUuid;
+}
+
+void SlideItem::setTargetPos (const QPointF &p, uint generation)
+{
+    targetPos=p;
+    targetGeneration=generation;
+    targetPosValid=true;
+}
+
+bool SlideItem::getTargetPos (QPointF &p, uint generation)
+{
+    if (!targetPosValid || targetGeneration!=generation) return false;
+    p=targetPos;
+    return true;
+}
+
+void SlideItem::parseInScript()
+{
+    // Scripts created by macros/slideeditor-snapshot.vys only set zoom,
+    // rotation and the center of the view. Those are stored here, so that 
+    // showing the slide needs no script engine. Everything else is 
+    // still executed as script.
+    static QRegExp reMap   ("map\\s*=\\s*vym\\.currentMap\\s*\\(\\s*\\)\\s*;?");
+    static QRegExp reZoom  ("map\\.setMapZoom\\s*\\(\\s*([-+0-9.eE]+)\\s*\\)\\s*;?");
+    static QRegExp reAngle ("map\\.setMapRotation\\s*\\(\\s*([-+0-9.eE]+)\\s*\\)\\s*;?");
+    static QRegExp reCenter("map\\.centerOnID\\s*\\(\\s*\"([^\"]+)\"\\s*\\)\\s*;?");
+
+    target=false;
+    targetPosValid=false;
+
+    bool hasMap=false, hasZoom=false, hasAngle=false, hasCenter=false;
+    bool ok;
+    foreach (QString line, inScript.split ("\n"))
+    {
+	line=line.trimmed();
+	if (line.isEmpty() || line.startsWith ("//") ) continue;
+
+	if (!hasMap && reMap.exactMatch (line))
+	    hasMap=true;
+	else if (hasMap && !hasZoom && reZoom.exactMatch (line))
+	{
+	    targetZoom=reZoom.cap(1).toDouble (&ok);
+	    if (!ok) return;
+	    hasZoom=true;
+	} else if (hasMap && !hasAngle && reAngle.exactMatch (line))
+	{
+	    targetAngle=reAngle.cap(1).toDouble (&ok);
+	    if (!ok) return;
+	    hasAngle=true;
+	} else if (hasMap && !hasCenter && reCenter.exactMatch (line))
+	{
+	    targetUuid=QUuid (reCenter.cap(1));
+	    if (targetUuid.isNull() ) return;
+	    hasCenter=true;
+	} else
+	    return;
+    }
+    target=hasZoom && hasAngle && hasCenter;
+}
+
 QString SlideItem::saveToDir()
 {
     QString att_ins, att_outs;
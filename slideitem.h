@@ -3,6 +3,8 @@
 
 #include <QEasingCurve>
 #include <QList>
+#include <QPointF>
+#include <QUuid>
 #include <QVariant>
 #include <QVector>
 
@@ -50,7 +52,17 @@ public:
     QEasingCurve getEasingCurve();
     QString saveToDir();
 
+    //! True, if inScript only sets zoom, rotation and center like a snapshot
+    bool hasTarget();
+    qreal getTargetZoom();
+    qreal getTargetAngle();
+    QUuid getTargetUuid();
+    void setTargetPos (const QPointF &p, uint generation);
+    bool getTargetPos (QPointF &p, uint generation);	//! False, if not resolved for this layout
+
 private:
+    void parseInScript();
+
     SlideModel *model;
     QList<SlideItem*> childItems;
     QVector<QVariant> itemData;
@@ -62,6 +74,14 @@ private:
     QString inScript;
     QString outScript;
 
+    bool target;		//! Resolved from inScript, see parseInScript
+    qreal targetZoom;
+    qreal targetAngle;
+    QUuid targetUuid;
+    QPointF targetPos;
+    uint targetGeneration;	//! Layout generation of VymModel, when targetPos was set
+    bool targetPosValid;
+
     int treeItemID;
     qreal zoomFactor;
     qreal rotationAngle;
@@ -276,10 +276,17 @@ SlideItem* SlideModel::getSlide (int n)
 
 SlideItem* SlideModel::findSlideID (uint n)
 {
-    for (int i=0; i<rootItem->childCount(); i++)
-	if (rootItem->child(i)->getID()==n)
-	    return rootItem->child(i);
-    return NULL;	    
+    return slideIDs.value (n, NULL);
+}
+
+void SlideModel::registerSlide (SlideItem *si)
+{
+    slideIDs.insert (si->getID(), si);
+}
+
+void SlideModel::unregisterSlide (SlideItem *si)
+{
+    slideIDs.remove (si->getID());
 }
 
 QString SlideModel::saveToDir()
@@ -2,6 +2,7 @@
 #define SLIDEMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QModelIndex>
 #include <QTextDocument>
 #include <QVariant>
@@ -58,6 +59,8 @@ public:
     SlideItem* getItem (const QModelIndex &index) const;
     SlideItem* getSlide (int n); 
     SlideItem* findSlideID (uint n);
+    void registerSlide (SlideItem *si);	    //! Called by SlideItem
+    void unregisterSlide (SlideItem *si);
     QString saveToDir ();
 
     void setSearchString( const QString &s);
@@ -77,6 +80,7 @@ private:
 
 private:
     SlideItem *rootItem;
+    QHash <uint, SlideItem*> slideIDs;	    //! Lookup for findSlideID
 
     QString searchString;
     QTextDocument::FindFlags searchFlags;
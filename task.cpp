@@ -15,6 +15,10 @@ Task::Task(TaskModel *tm)
     branch = NULL;
     prio   = 0;
     prio_delta = 0;
+    prio_branch = 0;
+    prio_branch_valid = false;
+    filter_key = 0;
+    filter_key_valid = false;
     model  = tm;
     date_creation = QDateTime::currentDateTime();
 }
@@ -63,6 +67,7 @@ void Task::setStatus(Status s)
 {
     if (s == status) return;
     status = s;
+    filter_key_valid = false;
     if (branch) branch->updateTaskFlag();
 }
 
@@ -130,6 +135,8 @@ void Task::setAwake(Task::Awake a)
     if (awake != a )
     {
         awake = a;
+        filter_key_valid = false;
+        if (model) model->scheduleWakeUp (this);
         if (branch) branch->updateTaskFlag();
     }
 }
@@ -256,6 +263,7 @@ bool Task::setDateSleep(const QDateTime &d)
 
     date_sleep = d;
     updateAwake();
+    if (model) model->scheduleWakeUp (this);
     return true;
 }
 
@@ -295,10 +303,32 @@ int Task::getPriorityDelta()
     return prio_delta;
 }
 
+void Task::setBranchPriority (int p)
+{
+    prio_branch = p;
+    prio_branch_valid = true;
+}
+
+int Task::getBranchPriority()
+{
+    return prio_branch;
+}
+
+bool Task::hasValidBranchPriority()
+{
+    return prio_branch_valid;
+}
+
+void Task::invalidateBranchPriority()
+{
+    prio_branch_valid = false;
+}
+
 void Task::setBranch (BranchItem *bi)
 {
     branch  = bi;
     mapName = bi->getModel()->getMapName();
+    filter_key_valid = false;
 }
 
 BranchItem* Task::getBranch ()
@@ -322,6 +352,43 @@ QString Task::getMapName ()
     return mapName;
 }
 
+quint32 Task::getFilterKey()
+{
+    if (filter_key_valid) return filter_key;
+
+    switch (status)
+    {
+	case NotStarted: filter_key = KeyNotStarted; break;
+	case WIP: filter_key = KeyWIP; break;
+	case Finished: filter_key = KeyFinished; break;
+    }
+
+    switch (awake)
+    {
+	case Sleeping: filter_key |= KeySleeping; break;
+	case Morning: filter_key |= KeyMorning; break;
+	case WideAwake: filter_key |= KeyWideAwake; break;
+    }
+
+    if (branch)
+    {
+        if (branch->hasActiveStandardFlag ("arrow-up") )  filter_key |= KeyArrowUp;
+        if (branch->hasActiveStandardFlag ("2arrow-up") ) filter_key |= Key2ArrowUp;
+        if (branch->hasActiveStandardFlag ("stopsign") )  filter_key |= KeyStopsign;
+    }
+
+    if (model)
+        filter_key |= ((quint32) model->getMapID (mapName)) << KeyMapShift;
+
+    filter_key_valid = true;
+    return filter_key;
+}
+
+void Task::invalidateFilterKey()
+{
+    filter_key_valid = false;
+}
+
 QString Task::saveToDir()
 {
     QString sleepAttr;
@@ -16,6 +16,21 @@ public:
     enum Status {NotStarted,WIP,Finished};
     enum Awake {Sleeping,Morning,WideAwake};
 
+    /*! Bits of the compact key used to filter tasks in TaskFilterModel.
+        The upper 16 bits hold the map ID, see TaskModel::getMapID */
+    enum FilterKey {
+        KeyNotStarted = 0x0001,
+        KeyWIP        = 0x0002,
+        KeyFinished   = 0x0004,
+        KeySleeping   = 0x0008,
+        KeyMorning    = 0x0010,
+        KeyWideAwake  = 0x0020,
+        KeyArrowUp    = 0x0040,
+        Key2ArrowUp   = 0x0080,
+        KeyStopsign   = 0x0100
+    };
+    static const int KeyMapShift = 16;
+
     Task(TaskModel* tm);
     ~Task();
     void setModel (TaskModel* tm);
@@ -51,9 +66,15 @@ public:
     QString getName();
     void setPriorityDelta( const int &n);
     int getPriorityDelta();
+    void setBranchPriority (int p); //! Cached part of priority derived from branch color and flags
+    int getBranchPriority();
+    bool hasValidBranchPriority();
+    void invalidateBranchPriority();
     void setBranch (BranchItem *bi);
     BranchItem* getBranch();
     QString getMapName();
+    quint32 getFilterKey();
+    void invalidateFilterKey();
     QString saveToDir();
 
 private:
@@ -62,6 +83,10 @@ private:
     Awake awake;
     int prio;
     int prio_delta;
+    int prio_branch;
+    bool prio_branch_valid;
+    quint32 filter_key;
+    bool filter_key_valid;
     BranchItem *branch;
     QString mapName;
     QDateTime date_creation;
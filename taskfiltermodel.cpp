@@ -7,6 +7,17 @@
 
 extern TaskModel *taskModel;
 
+TaskFilterModel::TaskFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    useFilter    = false;
+    mapFilterID  = -1;
+    filterNew    = false;
+    filterFlags1 = false;
+    filterFlags2 = false;
+    filterFlags3 = false;
+}
+
 void TaskFilterModel::setFilter (bool b)
 {
     useFilter = b;
@@ -14,7 +25,10 @@ void TaskFilterModel::setFilter (bool b)
 
 void TaskFilterModel::setMapFilter (const QString &s)	
 {
-    mapFilter = s;
+    if (s.isEmpty() )
+        mapFilterID = -1;
+    else
+        mapFilterID = taskModel->getMapID (s);
 }
 
 void TaskFilterModel::setFilterNew (bool b)
@@ -40,42 +54,38 @@ void TaskFilterModel::setFilterFlags3 (bool b)
 bool TaskFilterModel::filterAcceptsRow(int sourceRow, 
          const QModelIndex &sourceParent) const
 {
-    QModelIndex ix = sourceModel()->index(sourceRow, 0, sourceParent);
+    Q_UNUSED(sourceParent);
+
+    // All checks only use the precomputed key of the task
+    Task *task = taskModel->getTask (sourceRow);
+    if (!task) return false;
+    quint32 key = task->getFilterKey();
 
     // Filter by mapname
-    QString mapname = taskModel->getTask(ix)->getMapName();
-    if (mapname.isEmpty()) mapname = "justSomePseudoMapNameForFiltering";
-    if ( !mapFilter.isEmpty() && mapname != mapFilter )
+    if ( mapFilterID >= 0 && (int)(key >> Task::KeyMapShift) != mapFilterID )
         return false;
 
     // Filter new tasks
-    if (filterNew && taskModel->getTask(ix)->getAwake() != Task::Morning)
+    if (filterNew && !(key & Task::KeyMorning) )
         return false;
 
     // Filter active tasks
-    if (useFilter && ((taskModel->getTask(ix)->getSecsSleep() > 0) || (taskModel->getTask(ix)->getStatus() == Task::Finished) ) )
+    if (useFilter && (key & (Task::KeySleeping | Task::KeyFinished) ) )
         return false;
 
     // Filter arrow flags
+    const quint32 arrows = Task::KeyArrowUp | Task::Key2ArrowUp;
     if (filterFlags1 && filterFlags2)
-    {
-        if ( taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("arrow-up") ||
-             taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("2arrow-up") )
-            return true;
-        else
-            return false;
-    }
-
-    if (filterFlags1 && !taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("arrow-up") )
+        return (key & arrows) != 0;
+
+    if (filterFlags1 && !(key & Task::KeyArrowUp) )
         return false;
 
-    if (filterFlags2 && !taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("2arrow-up") )
+    if (filterFlags2 && !(key & Task::Key2ArrowUp) )
         return false;
 
     // Filter flags: Flags, which have neither arrow-up nor 2arrow-up  
-    if (filterFlags3 && (taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("arrow-up") 
-                     ||  taskModel->getTask(ix)->getBranch()->hasActiveStandardFlag("2arrow-up") ) )
+    if (filterFlags3 && (key & arrows) )
         return false;
     return true;
 }
-
@@ -6,6 +6,7 @@
 class TaskFilterModel:public QSortFilterProxyModel
 {
 public:
+    TaskFilterModel(QObject *parent=0);
     void setFilter (bool b);
     void setFilterNew (bool b);
     void setMapFilter (const QString &s);
@@ -16,7 +17,7 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const;
 private:
     bool useFilter;
-    QString mapFilter;
+    int mapFilterID;    //! Interned map name, -1 if not filtering by map
     bool filterNew;
     bool filterFlags1;
     bool filterFlags2;
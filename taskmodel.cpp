@@ -1,6 +1,7 @@
 #include "taskmodel.h"
 
 #include <QDebug>
+#include <QTimer>
 
 #include "branchitem.h"
 #include "branchobj.h"
@@ -11,6 +12,10 @@ TaskModel::TaskModel(QObject *parent)
     : QAbstractTableModel(parent)
 {
     showParentsLevel = 0;
+
+    wakeUpTimer = new QTimer (this);
+    wakeUpTimer->setSingleShot (true);
+    connect (wakeUpTimer, SIGNAL (timeout()), this, SLOT (wakeUpTasks()));
 }
 
 QModelIndex TaskModel::index (Task* t) const
@@ -107,22 +112,22 @@ QVariant TaskModel::data(const QModelIndex &index, int role) const
         return QIcon(":/flag-" + t->getIconString() + ".png");
     } else if (role == Qt::DecorationRole && index.column() == 7)
     {
-        BranchItem *bi = t->getBranch();
-	if (bi->hasActiveStandardFlag ("stopsign") )
+        quint32 key = t->getFilterKey();
+	if (key & Task::KeyStopsign)
         {
-            if (bi->hasActiveStandardFlag ("2arrow-up") ) 
+            if (key & Task::Key2ArrowUp) 
                 return QIcon(":/flag-stopsign-2arrow-up.png");
             else 
-                if (bi->hasActiveStandardFlag ("arrow-up") ) 
+                if (key & Task::KeyArrowUp) 
                     return QIcon(":/flag-stopsign-arrow-up.png");
                 else
                     return QIcon(":/flag-stopsign.png");
         } else
         {
-            if (bi->hasActiveStandardFlag ("2arrow-up") ) 
+            if (key & Task::Key2ArrowUp) 
                 return QIcon(":/flag-2arrow-up.png");
             else 
-                if (bi->hasActiveStandardFlag ("arrow-up") )
+                if (key & Task::KeyArrowUp)
                     return QIcon(":/flag-arrow-up.png");
         }
         return QIcon();
@@ -194,7 +199,11 @@ bool TaskModel::removeRows(int position, int rows, const QModelIndex &index)
     beginRemoveRows(QModelIndex(), position, position+rows-1);
 
     for (int row=0; row < rows; ++row) 
-        delete (tasks.takeAt(position)) ;
+    {
+        Task *t = tasks.takeAt(position);
+        unscheduleWakeUp (t);
+        delete (t);
+    }
 
     endRemoveRows();
     return true;
@@ -233,18 +242,15 @@ bool TaskModel::setData(const QModelIndex &index, const QVariant &value, int rol
 
 void TaskModel::emitDataChanged (Task* t)
 {
+    // Color or flags of branch might have changed
+    if (!t) return;
+    t->invalidateBranchPriority();
+    t->invalidateFilterKey();
+
+    // Only the row of this task needs to be updated and refiltered
     QModelIndex ix=index (t);
     if (ix.isValid() )
-    {
-	int row=ix.row();
-	int col=0;
-	while (col<columnCount(QModelIndex() ) )
-	{
-	    ix=createIndex (row, col, t);
-	    if (ix.isValid() ) emit(dataChanged(ix,ix) );
-	    col++;  
-	}    
-    }
+	emit(dataChanged(ix, indexRowEnd (t) ) );
 }
 
 Qt::ItemFlags TaskModel::flags(const QModelIndex &index) const
@@ -295,26 +301,108 @@ void TaskModel::deleteTask (Task* t)
 	removeRows(pos, 1,QModelIndex() );
 }
 
-bool TaskModel::updateAwake(bool force)
+void TaskModel::scheduleWakeUp (Task *t)
 {
-    bool awake_changed = false;
-    foreach (Task *t,tasks)
+    unscheduleWakeUp (t);
+
+    // Only sleeping tasks with a date in the future need an alarm
+    if (t->getAwake() == Task::Sleeping && t->getSleep().isValid() )
+    {
+        wakeUpQueue.insert (t->getSleep(), t);
+        wakeUpTimes.insert (t, t->getSleep() );
+    }
+    restartWakeUpTimer();
+}
+
+void TaskModel::unscheduleWakeUp (Task *t)
+{
+    if (wakeUpTimes.contains (t) )
+    {
+        wakeUpQueue.remove (wakeUpTimes.take (t), t);
+        restartWakeUpTimer();
+    }
+}
+
+void TaskModel::restartWakeUpTimer()
+{
+    if (wakeUpQueue.isEmpty() )
+    {
+        wakeUpTimer->stop();
+        return;
+    }
+
+    // Task::updateAwake works on full seconds, so wait one more second.
+    // Check at least once per hour, in case the system clock has changed
+    qint64 msecs = QDateTime::currentDateTime().msecsTo (wakeUpQueue.firstKey() );
+    msecs = qBound (qint64(0), msecs + 1000, qint64(3600000));
+    wakeUpTimer->start (msecs);
+}
+
+void TaskModel::wakeUpTasks()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    QList <Task*> dueTasks;
+    while (!wakeUpQueue.isEmpty() && wakeUpQueue.firstKey().addSecs(1) <= now)
+    {
+        Task *t = wakeUpQueue.take (wakeUpQueue.firstKey() );
+        wakeUpTimes.remove (t);
+        dueTasks.append (t);
+    }
+
+    // Update flags of affected branches and relayout each map only once
+    QList <VymModel*> models;
+    foreach (Task *t, dueTasks)
     {
-        if (t->updateAwake() || force)
+        if (t->updateAwake() )
         {
-            t->getBranch()->updateTaskFlag(); 
-            awake_changed = true;
+            VymModel *m = t->getBranch()->getModel();
+            if (!models.contains (m) ) models.append (m);
         }
     }
-    return awake_changed;
+    foreach (VymModel *m, models)
+        m->reposition();
+
+    restartWakeUpTimer();
 }
 
-void TaskModel::recalcPriorities() 
+int TaskModel::calcBranchPriority (BranchItem *bi)
+{
+    static const QColor colorLightGreen ("#00aa7f");
+    static const QColor colorOrange ("#d95100");
+    static const QColor colorRed ("#ff0000");
+
+    int p = 0;
+
+    // Color (importance)
+    QColor c = bi->getHeadingColor();
+
+    // light blueish green
+    if (c == colorLightGreen ) p -= 20;
+
+    // green (e.g. from vym < 2.6.3 with #005500)
+    if (c.red() == 0 && c.blue() == 0 && c.green() < 160) p -= 40;
+
+    // orange
+    if (c == colorOrange ) p -= 60;
+
+    // red
+    if (c == colorRed ) p -= 80;
+
+    // Flags
+    if (bi->hasActiveStandardFlag ("stopsign") )  p-=  450;
+    if (bi->hasActiveStandardFlag ("2arrow-up") ) p-= 1000;
+    if (bi->hasActiveStandardFlag ("arrow-up") )  p-=  500;
+
+    return p;
+}
+
+void TaskModel::recalcPriorities(bool forceUpdate) 
 {
-    emit (layoutAboutToBeChanged() );
     int minPrio=1000000;
-    foreach (Task *t,tasks)
+    QVector <int> prios (tasks.size() );
+    for (int i = 0; i < tasks.size(); ++i)
     {   
+        Task *t = tasks.at(i);
 	int p=0;
 	BranchItem *bi=t->getBranch();
 
@@ -334,25 +422,10 @@ void TaskModel::recalcPriorities()
 	    case Task::Sleeping: p+=1000 + t->getDaysSleep(); break;
 	}
 
-	// Color (importance)
-	QColor c = bi->getHeadingColor();
-
-        // light blueish green
-	if (c == QColor ("#00aa7f") ) p -= 20;
-
-        // green (e.g. from vym < 2.6.3 with #005500)
-	if (c.red() == 0 && c.blue() == 0 && c.green() < 160) p -= 40;
-
-        // orange
-	if (c == QColor ("#d95100") ) p -= 60;
-
-        // red
-	if (c == QColor ("#ff0000") ) p -= 80;
-
-	// Flags
-	if (bi->hasActiveStandardFlag ("stopsign") )  p-=  450;
-	if (bi->hasActiveStandardFlag ("2arrow-up") ) p-= 1000;
-	if (bi->hasActiveStandardFlag ("arrow-up") )  p-=  500;
+        // Color and flags only need to be checked, if branch has changed
+        if (!t->hasValidBranchPriority() )
+            t->setBranchPriority (calcBranchPriority (bi) );
+        p += t->getBranchPriority();
 
 	// Age
 	p -= t->getAgeModification();
@@ -365,23 +438,41 @@ void TaskModel::recalcPriorities()
         // Priority delta (set menually)
         p -= t->getPriorityDelta();
 
-        // Set priority finally
-	t->setPriority (p);
+	prios[i] = p;
 	if (p < minPrio) minPrio = p;
     }
+
     // Normalize, so that most important task has prio 1
-    foreach (Task *t,tasks)
-    {   
-	t->setPriority (1-  minPrio + t->getPriority() );
+    bool changed = false;
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        prios[i] = 1 - minPrio + prios.at(i);
+        if (prios.at(i) != tasks.at(i)->getPriority() ) changed = true;
     }
 
+    // Avoid resorting views, if nothing changed at all
+    if (!changed && !forceUpdate) return;
+
+    emit (layoutAboutToBeChanged() );
+    for (int i = 0; i < tasks.size(); ++i)
+        tasks.at(i)->setPriority (prios.at(i) );
     emit (layoutChanged() );
 }
 
+int TaskModel::getMapID (const QString &mapName)
+{
+    QHash <QString, int>::const_iterator it = mapIDs.find (mapName);
+    if (it != mapIDs.end() ) return it.value();
+
+    int id = mapIDs.count();
+    mapIDs.insert (mapName, id);
+    return id;
+}
+
 void TaskModel::setShowParentsLevel(uint i)
 {
     showParentsLevel = i;
-    recalcPriorities(); // Triggers update of view
+    recalcPriorities(true); // Triggers update of view
 }
 
 uint TaskModel::getShowParentsLevel()
@@ -2,12 +2,16 @@
 #define TASKMODEL_H
 
 #include <QAbstractTableModel>
+#include <QDateTime>
+#include <QHash>
 #include <QList>
+#include <QMultiMap>
 
 #include "task.h"
 
 
 class BranchItem;
+class QTimer;
 class VymModel;
 
 class TaskModel : public QAbstractTableModel
@@ -34,8 +38,10 @@ public:
     int count (VymModel *model=NULL);
     Task* createTask (BranchItem *bi);
     void deleteTask (Task* t);
-    bool updateAwake(bool force = false);
-    void recalcPriorities();
+    void scheduleWakeUp (Task *t);
+    void unscheduleWakeUp (Task *t);
+    void recalcPriorities(bool forceUpdate = false);
+    int getMapID (const QString &mapName);
 
     void setShowParentsLevel (uint i);
     uint getShowParentsLevel ();
@@ -47,9 +53,21 @@ public:
     bool dropMimeData(const QMimeData *data, Qt::DropAction action, 
         int row, int column, const QModelIndex &parent);
 
+private slots:
+    void wakeUpTasks();
+
 private:
+    void restartWakeUpTimer();
+    int calcBranchPriority (BranchItem *bi);
+
     QList <Task*> tasks;
     uint showParentsLevel;
+
+    QTimer *wakeUpTimer;                        //! Single timer shared by all maps
+    QMultiMap <QDateTime, Task*> wakeUpQueue;   //! Sleeping tasks ordered by wake up time
+    QHash <Task*, QDateTime> wakeUpTimes;       //! Currently scheduled time per task
+
+    QHash <QString, int> mapIDs;                //! Interned map names used for filtering
  };
 
 #endif
@@ -1,5 +1,11 @@
 #!/bin/bash
 
+# Tests talk to vym via DBus. Without a session bus, e.g. on a build
+# server, start a private one just for the tests
+if [ -z "$DBUS_SESSION_BUS_ADDRESS" ]; then
+    exec dbus-run-session -- "$0" "$@"
+fi
+
 SRCDIR=test
 VYMTESTDIR=$(mktemp -d /tmp/vym-test-XXXX)
 
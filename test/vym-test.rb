@@ -653,6 +653,214 @@ def test_history (vym)
   map.remove
 end  
 
+#######################
+def test_batch (vym)
+  heading "Batch commands"
+  map = init_map( vym )
+  map.select @main_b
+  n = map.branchCount.to_i
+  coms = []
+  coms << "vym.currentMap().addBranch();"
+  coms << "vym.currentMap().selectLatestAdded();"
+  coms << "vym.currentMap().setHeadingPlainText('batch 1');"
+  coms << "vym.currentMap().selectParent();"
+  coms << "vym.currentMap().noSuchCommand();"
+  coms << "vym.currentMap().addBranch();"
+  coms << "vym.currentMap().selectLatestAdded();"
+  coms << "vym.currentMap().setHeadingPlainText('batch 2');"
+  results, errors = map.execute_batch coms
+  expect "Batch returns results for each command", results.length, coms.length
+  expect "Batch reports error for failing command", errors, [0,0,0,0,1,0,0,0]
+  map.select @main_b
+  expect "Batch added branches", map.branchCount.to_i, n + 2
+  map.undo
+  map.select @main_b
+  expect "Undo batch in one step", map.branchCount.to_i, n
+  map.redo
+  map.select @main_b
+  expect "Redo batch in one step", map.branchCount.to_i, n + 2
+  map.selectLastChildBranch
+  expect "Redo batch restores heading", map.getHeadingPlainText, "batch 2"
+  map.undo
+end
+
+#######################
+def test_journal (vym)
+  heading "Journal"
+  map = init_map( vym )
+  journal = map.getDestPath + ".journal"
+  map.select @main_b
+  map.addBranch
+  sleep 2
+  expect "Journal written after change", File.exists?(journal), true
+  expect "Journal contains redo command", File.exists?(journal) && File.read(journal).include?("addBranch"), true
+  map.undo
+
+  map.select @main_a
+  map.copy
+  map.select @main_b
+  map.paste
+  sleep 2
+  expect "Journal contains clipboard instead of paste", File.read(journal).include?("paste ()"), false
+  expect "Journal inserts clipboard map", File.read(journal).include?("addMapInsert"), true
+  map.undo
+
+  map.execute_batch ["vym.currentMap().select('#{@main_b}');", "vym.currentMap().paste();"]
+  map.undo
+  map.redo
+  sleep 2
+  expect "Journal contains clipboard instead of paste in redo of batch", File.read(journal) =~ /paste ?\(/, nil
+  map.undo
+end
+
+#######################
+def start_instance (name, *args)
+  pid = spawn("vym", "-l", "-t", "-n", name, *args)
+  vym = nil
+  20.times do
+    sleep 0.5
+    vym = VymManager.new.find(name) rescue nil
+    break if vym
+  end
+  return pid, vym
+end
+
+def test_recover (vym)
+  heading "Recovery from journal"
+  map = init_map( vym )
+  map.select @main_b
+  n = map.branchCount.to_i
+  map.addBranch
+  map.selectLatestAdded
+  map.setHeadingPlainText "recovered"
+  map.select @main_a
+  map.copy
+  map.select @main_b
+  map.paste
+  sleep 2
+
+  # Replay journal onto a copy of the last saved map
+  src = map.getDestPath
+  copy = src.sub(/\.vym$/, "-recover.vym")
+  system("cp", "-p", src, copy)
+  system("cp", "-p", src + ".journal", copy + ".journal")
+  pid, vym2 = start_instance("test-recover", "-b", "--recover", copy)
+  expect "Recovering instance running", vym2.nil?, false
+  if vym2
+    rec = vym2.currentMapX
+    map.select @main_b
+    rec.select @main_b
+    expect "Recovered map has new branches", map.branchCount.to_i, n + 2
+    expect "Recovered branch count", rec.branchCount.to_i, map.branchCount.to_i
+    map.branchCount.to_i.times do |i|
+      map.select "#{@main_b},bo:#{i}"
+      rec.select "#{@main_b},bo:#{i}"
+      expect "Recovered heading of branch #{i}", rec.getHeadingPlainText, map.getHeadingPlainText
+      expect "Recovered branch count of branch #{i}", rec.branchCount.to_i, map.branchCount.to_i
+    end
+  end
+  Process.kill("TERM", pid)
+  Process.wait(pid)
+  [copy, copy + ".journal"].each { |f| File.delete(f) if File.exists?(f) }
+
+  map.undo
+  map.undo
+  map.undo
+end
+
+#######################
+def wait_for_share (server, client, timeout = 10)
+  t = Time.now
+  while client.getShareSequence.to_i != server.getShareSequence.to_i && Time.now - t < timeout
+    sleep 0.1
+  end
+  Time.now - t
+end
+
+def test_liveshare (vym)
+  heading "Live sharing with second instance"
+  map = init_map( vym )
+  port = map.shareMap(0).to_i
+  expect "shareMap returns port", port > 0, true
+
+  pid, vym2 = start_instance("test-share")
+  expect "Second instance running", vym2.nil?, false
+  return if !vym2
+
+  client = vym2.currentMapX
+  client.connectToServer("localhost", port)
+  wait_for_share map, client
+  client.select @main_a
+  expect "Client received snapshot", client.getHeadingPlainText, "Main A"
+
+  n = 200
+  map.select @main_b
+  t = Time.now
+  n.times { |i| map.setHeadingPlainText "share #{i}" }
+  dt = wait_for_share map, client
+  client.select @main_b
+  expect "Client received #{n} operations", client.getHeadingPlainText, "share #{n - 1}"
+  puts "    #{n} operations in #{'%.2f' % (Time.now - t)}s, client caught up after #{'%.2f' % dt}s"
+
+  h = 'quote " and semicolon ; in heading'
+  map.setHeadingPlainText h
+  wait_for_share map, client
+  expect "Client received heading with quotes", client.getHeadingPlainText, h
+  map.undo
+
+  # Paste depends on local clipboard, client gets a snapshot
+  map.select @main_a
+  map.copy
+  map.select @main_b
+  map.paste
+  wait_for_share map, client
+  map.select @main_b
+  client.select @main_b
+  expect "Client received paste", client.branchCount, map.branchCount
+
+  map.undo
+  n.times { map.undo }
+  Process.kill("TERM", pid)
+  Process.wait(pid)
+end
+
+#######################
+def test_filter (vym)
+  heading "Filter"
+  map = init_map( vym )
+  map.select @main_b
+  h = map.getHeadingPlainText
+  map.setHeadingPlainText "xylophone marimba"
+  expect "findWords finds part of word", map.findWords("xylo").to_i, 1
+  expect "findWords ignores case", map.findWords("MARIMBA xylophone").to_i, 1
+  expect "findWords needs all words", map.findWords("xylophone vibraphone").to_i, 0
+  expect "findWords finds infix", map.findWords("lopho").to_i, 1
+  map.setHeadingPlainText "c++ v1.2 foo-bar"
+  expect "findWords finds term with symbols", map.findWords("c++").to_i, 1
+  expect "findWords finds dotted term", map.findWords("v1.2").to_i, 1
+  expect "findWords finds term as substring", map.findWords("foo-bar").to_i, 1
+  expect "findWords checks whole term", map.findWords("bar-foo").to_i, 0
+  map.undo
+  map.setNotePlainText "vibraphone"
+  expect "findWords finds words in note", map.findWords("xylophone vibraphone").to_i, 1
+  map.undo
+  map.undo
+  expect "findWords after undo of heading", map.findWords("xylophone").to_i, 0
+  expect "findWords after undo of note", map.findWords("vibraphone").to_i, 0
+  expect "Undo restored heading", map.getHeadingPlainText, h
+
+  map.addBranch
+  map.selectLatestAdded
+  map.setHeadingPlainText "glockenspiel"
+  expect "findWords finds new branch", map.findWords("glockenspiel").to_i, 1
+  map.remove
+  expect "findWords after removing branch", map.findWords("glockenspiel").to_i, 0
+  map.undo
+  expect "findWords after undo of remove", map.findWords("glockenspiel").to_i, 1
+  map.undo
+  map.undo
+end
+
 #######################
 def test_xlinks (vym)
   heading "XLinks:"
@@ -900,6 +1108,11 @@ test_delete_parts(vym)
 test_copy_paste(vym)
 test_references(vym)
 test_history(vym)
+test_batch(vym)
+test_journal(vym)
+test_recover(vym)
+test_liveshare(vym)
+test_filter(vym)
 test_xlinks(vym)
 test_tasks(vym)
 test_notes(vym)
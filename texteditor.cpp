@@ -64,6 +64,8 @@ TextEditor::TextEditor()
     
     // Various states
     blockChangedSignal=false;
+    textPending=false;
+    documentCache.setMaxCost (20);
     setInactive();
 
     editorName = "Text editor";
@@ -139,6 +141,7 @@ void TextEditor::init (const QString &scope)
 
 bool TextEditor::isEmpty()
 {
+    flushPendingText();
     if (e->toPlainText().length()>0)
 	return false;
     else
@@ -246,6 +249,7 @@ QString TextEditor::getFilenameHint()
 
 QString TextEditor::getText()
 {
+    flushPendingText();
     if (e->toPlainText().isEmpty()) return QString();
 
     if (actionFormatRichText->isChecked())
@@ -256,6 +260,7 @@ QString TextEditor::getText()
 
 VymText TextEditor::getVymText()
 {
+    flushPendingText();
     VymText vt;
 
     if (actionFormatRichText->isChecked())
@@ -271,6 +276,7 @@ VymText TextEditor::getVymText()
 
 bool TextEditor::findText(const QString &t, const QTextDocument::FindFlags &flags)
 {
+    flushPendingText();
     if (e->find (t,flags))
         return true;
     else
@@ -279,6 +285,7 @@ bool TextEditor::findText(const QString &t, const QTextDocument::FindFlags &flag
 
 bool TextEditor::findText(const QString &t, const QTextDocument::FindFlags &flags, int i)
 {
+    flushPendingText();
     // Position at beginning
     QTextCursor c=e->textCursor();
     c.setPosition (0,QTextCursor::MoveAnchor);
@@ -673,6 +680,12 @@ void TextEditor::textLoad()
     }
 }
 
+void TextEditor::showEvent( QShowEvent* se )
+{
+    flushPendingText();
+    QMainWindow::showEvent (se);
+}
+
 void TextEditor::closeEvent( QCloseEvent* ce )
 {
     ce->accept();   // TextEditor can be reopened with show()
@@ -719,9 +732,22 @@ void TextEditor::setRichText(const QString &t)
 {
     blockChangedSignal=true;
     e->setReadOnly(false);
-    reset();
 
-    e->setHtml(t);
+    QTextDocument *doc = documentCache.object (t);
+    if (doc)
+    {
+        // QTextEdit only deletes its own default document,
+        // previous copies from the cache are deleted here
+        QTextDocument *oldDoc = e->document();
+        e->setDocument (doc->clone (e));
+        if (oldDoc->parent() == e) delete oldDoc;
+        editorChanged();
+    } else
+    {
+        reset();
+        e->setHtml(t);
+        documentCache.insert (t, e->document()->clone() );
+    }
     actionFormatRichText->setChecked (true);
 
     updateActions();
@@ -751,6 +777,26 @@ void TextEditor::setTextAuto(const QString &t)
 }
 
 void TextEditor::setVymText( const VymText &vt)
+{
+    if (!isVisible())
+    {
+        // Parse later, maybe never if the user selects something else before
+        pendingText = vt;
+        textPending = true;
+        return;
+    }
+    textPending = false;
+    applyVymText (vt);
+}
+
+void TextEditor::flushPendingText()
+{
+    if (!textPending) return;
+    textPending = false;
+    applyVymText (pendingText);
+}
+
+void TextEditor::applyVymText( const VymText &vt)
 {
     if (vt.isRichText())
         setRichText(vt.getText());
@@ -760,6 +806,7 @@ void TextEditor::setVymText( const VymText &vt)
 
 void TextEditor::setInactive()
 {
+    textPending=false;
     state=inactiveEditor;
     e->setPlainText("");
     setState (inactiveEditor);
@@ -2,6 +2,7 @@
 #define TEXTEDITOR_H
 
 #include <QtGui>
+#include <QCache>
 #include <QMainWindow>
 
 class QTextEdit;
@@ -45,7 +46,10 @@ protected:
     void setupFormatActions();
     void setupSettingsActions();
     void closeEvent( QCloseEvent* );
+    void showEvent( QShowEvent* );
     bool eventFilter(QObject *obj, QEvent *ev);
+    virtual void applyVymText (const VymText &vt);  //! Fill editor, called only when visible
+    void flushPendingText();
 
 public slots:
     void editorChanged();	    // received when text() changed
@@ -110,6 +114,13 @@ protected:
     EditorState state;
     bool blockChangedSignal;
 
+    // Text is only parsed into the editor while it is visible
+    VymText pendingText;
+    bool textPending;
+
+    // Recently parsed rich text, identified by its HTML
+    QCache <QString, QTextDocument> documentCache;
+
     QColor colorEmptyEditor;
     QColor colorFilledEditor;
     QColor colorInactiveEditor;
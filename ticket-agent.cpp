@@ -0,0 +1,417 @@
+#include "ticket-agent.h"
+
+#include "branchitem.h"
+#include "mainwindow.h"
+#include "settings.h"
+#include "vymmodel.h"
+
+#include <QDebug>
+#include <QRegExp>
+
+extern Main *mainWindow;
+extern Settings settings;
+extern bool debug;
+
+TicketAgent::TicketAgent (const QString &n, const QString &s)
+{
+    name = n;
+    script = s;
+    maxProcesses = settings.value ("/system/tickets/maxProcesses", 4).toInt();
+    batchSize = settings.value ("/system/tickets/batchSize", 10).toInt();
+    cacheTTL = settings.value ("/system/tickets/cacheTTL", 300).toInt();
+    timeout = 10000;
+
+    processesStarted = 0;
+    ticketsRequested = 0;
+    ticketsReceived = 0;
+    cacheHits = 0;
+    updateBatches = 0;
+
+    batchTimer.setSingleShot (true);
+    batchTimer.setInterval (0);
+    connect (&batchTimer, SIGNAL (timeout()), this, SLOT (startJobs()));
+
+    // Merge updates arriving from several processes
+    applyTimer.setSingleShot (true);
+    applyTimer.setInterval (100);
+    connect (&applyTimer, SIGNAL (timeout()), this, SLOT (applyUpdates()));
+}
+
+TicketAgent::~TicketAgent()
+{
+    foreach (Job *job, running)
+    {
+	job->p->disconnect (this);
+	job->p->kill();
+	job->p->waitForFinished (1000);
+	delete job->p;
+	delete job;
+    }
+    foreach (Job *job, queries)
+	delete job;
+}
+
+void TicketAgent::setScript (const QString &s)
+{
+    script = s;
+}
+
+QString TicketAgent::getScript()
+{
+    return script;
+}
+
+void TicketAgent::setMaxProcesses (int n)
+{
+    maxProcesses = qMax (1, n);
+}
+
+void TicketAgent::setBatchSize (int n)
+{
+    batchSize = qMax (1, n);
+}
+
+void TicketAgent::setCacheTTL (int secs)
+{
+    cacheTTL = secs;
+}
+
+void TicketAgent::setTimeout (int msecs)
+{
+    timeout = msecs;
+}
+
+void TicketAgent::requestTicket (BranchItem *bi, const QString &ticketID)
+{
+    if (!bi || ticketID.isEmpty() ) return;
+
+    ticketsRequested++;
+
+    Target t;
+    t.modelID = bi->getModel()->getModelID();
+    t.branchID = bi->getID();
+
+    TicketData data;
+    if (getCached (ticketID, data))
+    {
+	cacheHits++;
+	addUpdate (t, ticketID, true);
+	return;
+    }
+
+    // Branch is already waiting for this ticket
+    foreach (Target w, waiting.value (ticketID))
+	if (w.modelID == t.modelID && w.branchID == t.branchID) return;
+
+    // If ticket is already queued or running, just wait for it, too
+    if (!waiting.contains (ticketID) ) queue.append (ticketID);
+    addTarget (bi, t);
+    waiting[ticketID].append (t);
+
+    if (!batchTimer.isActive() ) batchTimer.start();
+}
+
+void TicketAgent::requestQuery (BranchItem *bi, const QString &query)
+{
+    if (!bi || query.isEmpty() ) return;
+
+    Job *job = new Job;
+    job->p = NULL;
+    job->killTimer = NULL;
+    job->query = query;
+    job->queryTarget.modelID = bi->getModel()->getModelID();
+    job->queryTarget.branchID = bi->getID();
+    queries.append (job);
+
+    if (!batchTimer.isActive() ) batchTimer.start();
+}
+
+void TicketAgent::clearCache()
+{
+    cache.clear();
+}
+
+bool TicketAgent::isIdle()
+{
+    return queue.isEmpty() && queries.isEmpty() && running.isEmpty() && updates.isEmpty();
+}
+
+int TicketAgent::getProcessesStarted()
+{
+    return processesStarted;
+}
+
+int TicketAgent::getTicketsRequested()
+{
+    return ticketsRequested;
+}
+
+int TicketAgent::getTicketsReceived()
+{
+    return ticketsReceived;
+}
+
+int TicketAgent::getCacheHits()
+{
+    return cacheHits;
+}
+
+int TicketAgent::getUpdateBatches()
+{
+    return updateBatches;
+}
+
+void TicketAgent::setQueryBranch (VymModel *, BranchItem *, const QString &)
+{
+}
+
+void TicketAgent::processFinished (int exitCode, QProcess::ExitStatus exitStatus)
+{
+    foreach (Job *job, running)
+	if (job->p == sender() )
+	{
+	    if (exitStatus != QProcess::NormalExit)
+		qWarning() << name << ": Process finished with exitCode=" << exitCode;
+	    finishJob (job, exitStatus == QProcess::NormalExit);
+	    return;
+	}
+}
+
+void TicketAgent::processTimeout()
+{
+    foreach (Job *job, running)
+	if (job->killTimer == sender() )
+	{
+	    qWarning() << name << ": Timeout, killing " << script << job->ticketIDs;
+	    job->p->kill();
+	    return;
+	}
+}
+
+void TicketAgent::applyUpdates()
+{
+    // Group updates by model, so that each model does only one layout
+    QList <uint> modelIDs;
+    foreach (Update u, updates)
+	if (!modelIDs.contains (u.target.modelID) ) modelIDs.append (u.target.modelID);
+
+    QList <Update> list = updates;
+    updates.clear();
+
+    foreach (uint modelID, modelIDs)
+    {
+	VymModel *model = mainWindow->getModel (modelID);
+	if (!model)
+	{
+	    qWarning() << name << ": Couldn't find model #" << modelID;
+	    continue;
+	}
+
+	model->deferUpdates();
+	foreach (Update u, list)
+	{
+	    if (u.target.modelID != modelID) continue;
+
+	    BranchItem *bi = (BranchItem*)(model->findID (u.target.branchID));
+	    if (!bi)
+	    {
+		qWarning() << name << ": Found model, but not branch #" << u.target.branchID;
+		continue;
+	    }
+
+	    if (!u.ok)
+	    {
+		qWarning() << name << ": Couldn't find data for " << (u.ticketID.isEmpty() ? "query" : u.ticketID);
+		if (!u.ticketID.isEmpty() ) model->setHeading (u.target.oldHeading, bi);
+	    } else if (u.ticketID.isEmpty() )
+	    {
+		// Process results of query
+		foreach (QString id, u.queryResult)
+		{
+		    BranchItem *newbi = model->addNewBranch (bi);
+		    if (!newbi)
+			qWarning() << name << ": Couldn't create new branch?!";
+		    else
+		    {
+			setQueryBranch (model, newbi, id);
+			setModelTicketData (model, newbi, id, cache.value (id).data);
+		    }
+		}
+	    } else
+		setModelTicketData (model, bi, u.ticketID, cache.value (u.ticketID).data);
+	}
+	model->resumeUpdates();
+    }
+    updateBatches++;
+
+    if (isIdle() ) emit (idle());
+}
+
+void TicketAgent::addTarget (BranchItem *bi, Target &t)
+{
+    // Visual hint that we are doing something, restored if lookup fails
+    VymModel *model = bi->getModel();
+    t.oldHeading = bi->getHeading();
+    model->setHeadingPlainText ("Updating: " + bi->getHeadingPlain(), bi );
+}
+
+void TicketAgent::startJobs()
+{
+    while (running.count() < maxProcesses)
+    {
+	Job *job;
+	QStringList args;
+	if (!queries.isEmpty() )
+	{
+	    job = queries.takeFirst();
+	    args << "--query" << job->query;
+	} else if (!queue.isEmpty() )
+	{
+	    job = new Job;
+	    job->p = NULL;
+	    job->killTimer = NULL;
+
+	    // Tickets missing in the output of a batch are retried alone
+	    if (retryIDs.contains (queue.first()) )
+		job->ticketIDs << queue.takeFirst();
+	    else
+		while (!queue.isEmpty() && job->ticketIDs.count() < batchSize && !retryIDs.contains (queue.first()) )
+		    job->ticketIDs << queue.takeFirst();
+	    args = job->ticketIDs;
+	} else
+	    return;
+
+	startJob (args, job);
+    }
+}
+
+void TicketAgent::startJob (const QStringList &args, Job *job)
+{
+    job->p = new VymProcess;
+    connect (job->p, SIGNAL (finished(int, QProcess::ExitStatus) ),
+	this, SLOT (processFinished(int, QProcess::ExitStatus) ));
+
+    job->killTimer = new QTimer (this);
+    job->killTimer->setSingleShot (true);
+    job->killTimer->setInterval (timeout * qMax (1, job->ticketIDs.count()) );
+    connect (job->killTimer, SIGNAL (timeout()), this, SLOT (processTimeout()));
+
+    running.append (job);
+    processesStarted++;
+
+    if (debug) qDebug() << name << ": " << script << "  args: " << args;
+
+    job->p->start (script, args);
+    if (!job->p->waitForStarted())
+    {
+	qWarning() << name << ": Couldn't start " << script;
+	finishJob (job, false);
+	return;
+    }
+    job->killTimer->start();
+}
+
+void TicketAgent::finishJob (Job *job, bool ok)
+{
+    running.removeAll (job);
+    job->killTimer->stop();
+
+    QStringList ids;
+    QHash <QString, TicketData> result;
+    if (ok)
+    {
+	QString err = job->p->getErrout();
+	if (!err.isEmpty() ) qWarning() << name << " Error: \n" << err;
+	parseResult (job->p->getStdout(), ids, result);
+    }
+
+    // Script might return the ticket with a normalized ID
+    if (job->ticketIDs.count() == 1 && ids.count() == 1 && ids.first() != job->ticketIDs.first() )
+    {
+	result[job->ticketIDs.first()] = result.value (ids.first());
+	ids[0] = job->ticketIDs.first();
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    foreach (QString id, ids)
+    {
+	CacheEntry e;
+	e.data = result.value (id);
+	e.time = now;
+	cache.insert (id, e);
+	ticketsReceived++;
+    }
+
+    if (job->ticketIDs.isEmpty() )
+	addUpdate (job->queryTarget, QString(), !ids.isEmpty(), ids);
+    else
+	foreach (QString id, job->ticketIDs)
+	{
+	    if (ids.contains (id))
+	    {
+		retryIDs.remove (id);
+		foreach (Target t, waiting.take (id))
+		    addUpdate (t, id, true);
+	    } else if (job->ticketIDs.count() > 1 && !retryIDs.contains (id))
+	    {
+		// e.g. script stopped at a broken ticket, try again alone
+		retryIDs.insert (id);
+		queue.append (id);
+	    } else
+	    {
+		retryIDs.remove (id);
+		foreach (Target t, waiting.take (id))
+		    addUpdate (t, id, false);
+	    }
+	}
+
+    // Process emits finished() from within its own slots
+    job->p->deleteLater();
+    job->killTimer->deleteLater();
+    delete job;
+
+    startJobs();
+}
+
+void TicketAgent::parseResult (const QString &out, QStringList &ids, QHash <QString, TicketData> &result)
+{
+    QRegExp re("([^:]*):(\\S*):\"(.*)\"");
+    re.setMinimal(false);
+
+    foreach (QString line, out.split ("\n"))
+    {
+	if (debug) qDebug() << name << "::parseResult  line=" << line;
+	if (re.indexIn(line) != -1)
+	{
+	    QString id = re.cap(1);
+	    if (re.cap(2) == "short_desc" && !ids.contains (id)) ids.append (id);
+	    result[id][re.cap(2)] = re.cap(3).replace("\\\"","\"");
+	}
+    }
+}
+
+bool TicketAgent::getCached (const QString &ticketID, TicketData &data)
+{
+    if (!cache.contains (ticketID) ) return false;
+
+    CacheEntry e = cache.value (ticketID);
+    if (e.time.secsTo (QDateTime::currentDateTime()) >= cacheTTL)
+    {
+	cache.remove (ticketID);
+	return false;
+    }
+    data = e.data;
+    return true;
+}
+
+void TicketAgent::addUpdate (const Target &t, const QString &ticketID, bool ok, const QStringList &queryResult)
+{
+    Update u;
+    u.target = t;
+    u.ticketID = ticketID;
+    u.queryResult = queryResult;
+    u.ok = ok;
+    updates.append (u);
+
+    if (!applyTimer.isActive() ) applyTimer.start();
+}
@@ -0,0 +1,139 @@
+#ifndef TICKETAGENT_H
+#define TICKETAGENT_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+#include "heading.h"
+#include "vymprocess.h"
+
+class BranchItem;
+class VymModel;
+
+/*! \brief Shared scheduler for ticket lookups by helper scripts
+
+    Requests for tickets are queued instead of starting one process
+    per branch. At most maxProcesses helper scripts run at the same time,
+    each of them gets up to batchSize ticket IDs as arguments.
+    The script prints lines like
+
+	ID:key:"value"
+
+    as scripts/jigger and scripts/bugger do. Results are cached for
+    cacheTTL seconds and applied to the maps in batches, so that
+    updating a large subtree is done with a single layout per map.
+
+    The script can be replaced in the settings, e.g. by a local stub
+    for testing.
+*/
+
+class TicketAgent:public QObject
+{
+    Q_OBJECT
+
+public:
+    TicketAgent (const QString &name, const QString &script);
+    virtual ~TicketAgent();
+
+    void setScript (const QString &s);
+    QString getScript();
+    void setMaxProcesses (int n);
+    void setBatchSize (int n);
+    void setCacheTTL (int secs);
+    void setTimeout (int msecs);	    //! Time limit per ticket in a process
+
+    void requestTicket (BranchItem *bi, const QString &ticketID);
+    void requestQuery (BranchItem *bi, const QString &query);	//! Not batched or cached
+    void clearCache();
+    bool isIdle();
+
+    int getProcessesStarted();
+    int getTicketsRequested();
+    int getTicketsReceived();
+    int getCacheHits();
+    int getUpdateBatches();
+
+signals:
+    void idle();
+
+protected:
+    typedef QHash <QString, QString> TicketData;
+
+    //! Called for every branch, where data of ticketID has been retrieved
+    virtual void setModelTicketData (VymModel *model, BranchItem *bi, const QString &ticketID, const TicketData &data) = 0;
+    //! Called for every branch below a query, before setModelTicketData
+    virtual void setQueryBranch (VymModel *model, BranchItem *bi, const QString &ticketID);
+
+private slots:
+    void processFinished (int exitCode, QProcess::ExitStatus exitStatus);
+    void processTimeout();
+    void startJobs();
+    void applyUpdates();
+
+private:
+    struct Target
+    {
+	uint modelID;
+	uint branchID;
+	Heading oldHeading;
+    };
+
+    struct Job
+    {
+	VymProcess *p;
+	QTimer *killTimer;
+	QStringList ticketIDs;	    //! Empty for query
+	QString query;
+	Target queryTarget;
+    };
+
+    struct Update
+    {
+	Target target;
+	QString ticketID;	    //! Empty for query
+	QStringList queryResult;
+	bool ok;
+    };
+
+    struct CacheEntry
+    {
+	TicketData data;
+	QDateTime time;
+    };
+
+    void addTarget (BranchItem *bi, Target &t);
+    void startJob (const QStringList &args, Job *job);
+    void finishJob (Job *job, bool ok);
+    void parseResult (const QString &out, QStringList &ids, QHash <QString, TicketData> &result);
+    bool getCached (const QString &ticketID, TicketData &data);
+    void addUpdate (const Target &t, const QString &ticketID, bool ok, const QStringList &queryResult = QStringList() );
+
+    QString name;
+    QString script;
+    int maxProcesses;
+    int batchSize;
+    int cacheTTL;
+    int timeout;
+
+    QStringList queue;			    //! Ticket IDs waiting for a process
+    QHash <QString, QList <Target> > waiting; //! Branches waiting for ticket ID
+    QSet <QString> retryIDs;		    //! Retried alone after failed batch
+    QList <Job*> queries;		    //! Queries waiting for a process
+    QList <Job*> running;
+    QHash <QString, CacheEntry> cache;
+    QList <Update> updates;
+    QTimer batchTimer;			    //! Collect requests of a subtree before batching
+    QTimer applyTimer;
+
+    int processesStarted;
+    int ticketsRequested;
+    int ticketsReceived;
+    int cacheHits;
+    int updateBatches;
+};
+#endif
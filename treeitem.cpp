@@ -90,6 +90,7 @@ void TreeItem::init()
 void TreeItem::setModel (VymModel *m)
 {
     model = m;
+    if (model) model->updateWordIndex (this);
 }
 
 VymModel* TreeItem::getModel ()
@@ -333,6 +334,7 @@ void TreeItem::setHeading (const VymText &vt)
 {
     heading = vt;
     itemData[0]= heading.getTextASCII();  // used in TreeEditor
+    if (model) model->updateWordIndex (this);
 }
 
 void TreeItem::setHeadingPlainText (const QString &s)
@@ -365,7 +367,7 @@ std::string TreeItem::getHeadingStd () const
 QString TreeItem::getHeadingPlain() const
 {
     // strip beginning and tailing WS
-    return heading.getTextASCII().trimmed();
+    return heading.getTextPlain().trimmed();
 }
 
 QString TreeItem::getHeadingPlainWithParents(uint numberOfParents = 0) 
@@ -501,6 +503,7 @@ void TreeItem::clearNote()
 {
     note.clear();
     systemFlags.deactivate ("system-note");
+    if (model) model->updateWordIndex (this);
 }
 
 void TreeItem::setNote(const VymText &vt)
@@ -510,6 +513,7 @@ void TreeItem::setNote(const VymText &vt)
 	systemFlags.activate ("system-note");
     if (note.isEmpty() && systemFlags.isActive ("system-note"))
 	systemFlags.deactivate ("system-note");
+    if (model) model->updateWordIndex (this);
 }
 
 void TreeItem::setNote(const VymNote &vn)
@@ -519,6 +523,7 @@ void TreeItem::setNote(const VymNote &vn)
     systemFlags.activate ("system-note");
     if (note.isEmpty() && systemFlags.isActive ("system-note"))
     systemFlags.deactivate ("system-note");
+    if (model) model->updateWordIndex (this);
 }
 
 bool TreeItem::hasEmptyNote()
@@ -541,6 +546,11 @@ QString TreeItem::getNoteASCII()
     return note.getTextASCII();
 }
 
+QString TreeItem::getNotePlain()
+{
+    return note.getTextPlain();
+}
+
 void TreeItem::activateStandardFlag (const QString &name)
 {
     standardFlags.activate (name);
@@ -595,6 +605,11 @@ QStringList TreeItem::activeSystemFlagNames ()
     return systemFlags.activeFlagNames();
 }
 
+FlagRow* TreeItem::getSystemFlagRow()
+{
+    return &systemFlags;
+}
+
 bool TreeItem::canMoveDown()
 {
     switch (type)
@@ -812,6 +827,7 @@ void TreeItem::setHideInExport(bool b)
 	    systemFlags.activate("system-hideInExport");
 	else	
 	    systemFlags.deactivate("system-hideInExport");
+	if (model) model->updateHideExportIndex (this);
     }
 }   
 
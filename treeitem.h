@@ -127,6 +127,7 @@ public:
     virtual VymNote getNote();
     virtual QString getNoteASCII(const QString &indent, const int &width); // returns note  (ASCII)
     virtual QString getNoteASCII();	    // returns note (ASCII)
+    virtual QString getNotePlain();	    // returns note without markup, not wrapped
 
 protected:
     FlagRow standardFlags;
@@ -148,6 +149,7 @@ public:
     virtual FlagRow* getStandardFlagRow ();
 
     virtual QStringList activeSystemFlagNames();
+    virtual FlagRow* getSystemFlagRow ();
 
     virtual bool canMoveDown();
     virtual bool canMoveUp();
@@ -274,11 +274,16 @@ bool TreeModel::removeRows ( int row, int count, const QModelIndex & parent)
     {
 	ti=pi->getChildNum (row);
 	pi->removeChild (row);	// does not delete object!
+	itemAboutToBeDeleted (ti);
 	delete ti;
     }
     return true;
 }
 
+void TreeModel::itemAboutToBeDeleted (TreeItem *)
+{
+}
+
 TreeItem *TreeModel::getItem(const QModelIndex &index) const
 {
     if (index.isValid()) {
@@ -42,6 +42,9 @@ public:
     virtual Link* getXLinkNum (const int &n); 
 
 protected:
+    //! Called by removeRows before ti and its children are deleted
+    virtual void itemAboutToBeDeleted (TreeItem *ti);
+
     BranchItem *rootItem;
 
     QList <Link*> xlinks;
@@ -6,6 +6,7 @@ CONFIG	+= qt warn_on x86_64
 
 QMAKE_MAC_SDK = macosx10.10
 
+QT += concurrent
 QT += network 
 QT += xml 
 QT += script 
@@ -111,20 +112,24 @@ HEADERS	+= \
     geometry.h \
     heading.h \
     headingeditor.h \
+    headinglayout.h \
     headingobj.h \
     highlighter.h \
     historywindow.h \
+    imagecache.h \
     imageitem.h \
     imageobj.h \
     imports.h \
     jira-agent.h \
     lineeditdialog.h \
     linkablemapobj.h \
+    liveshare.h \
     lockedfiledialog.h \
     macros.h \
     mainwindow.h \
     mapeditor.h \
     mapitem.h \
+    maploader.h \
     mapobj.h \
     misc.h \
     mysortfilterproxymodel.h \
@@ -144,6 +149,7 @@ HEADERS	+= \
     task.h\
     taskeditor.h\
     taskmodel.h\
+    ticket-agent.h \
     treedelegate.h \
     treeeditor.h \
     treeitem.h \
@@ -151,6 +157,7 @@ HEADERS	+= \
     texteditor.h \
     userdialog.h \
     version.h \
+    vymjournal.h \
     vymlock.h \
     vymmodel.h \
     vymmodelwrapper.h \
@@ -220,21 +227,25 @@ SOURCES	+= \
     geometry.cpp \
     heading.cpp \
     headingeditor.cpp \
+    headinglayout.cpp \
     headingobj.cpp \
     highlighter.cpp \
     historywindow.cpp \
+    imagecache.cpp \
     imageitem.cpp \
     imageobj.cpp \
     imports.cpp \
     jira-agent.cpp \
     lineeditdialog.cpp \
     linkablemapobj.cpp \
+    liveshare.cpp \
     lockedfiledialog.cpp \
     macros.cpp \
     main.cpp \
     mainwindow.cpp \
     mapeditor.cpp \
     mapitem.cpp \
+    maploader.cpp \
     mapobj.cpp \
     misc.cpp \
     mysortfilterproxymodel.cpp \
@@ -255,12 +266,14 @@ SOURCES	+= \
     taskeditor.cpp \
     taskmodel.cpp \
     texteditor.cpp \
+    ticket-agent.cpp \
     treedelegate.cpp \
     treeeditor.cpp \
     treeitem.cpp \
     treemodel.cpp \
     userdialog.cpp \
     version.cpp \
+    vymjournal.cpp \
     vymlock.cpp \
     vymmodel.cpp \
     vymmodelwrapper.cpp \
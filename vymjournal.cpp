@@ -0,0 +1,358 @@
+#include "vymjournal.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "file.h"
+
+extern bool debug;
+extern QString vymVersion;
+
+// Paths of files in tmpDir are replaced by this tag in the journal
+static const QString fileTag ("$JOURNAL");
+
+VymJournal::VymJournal()
+{
+    active = false;
+    blocked = false;
+    headerWritten = false;
+    nextFileID = 0;
+    batchSize = 10;
+    recordsWritten = 0;
+    flushes = 0;
+
+    flushTimer.setSingleShot (true);
+    flushTimer.setInterval (1000);
+    connect (&flushTimer, SIGNAL (timeout()), this, SLOT (flush()));
+}
+
+VymJournal::~VymJournal()
+{
+    // Journal is only kept after a crash
+    if (active) remove();
+}
+
+void VymJournal::setMapPath (const QString &fn)
+{
+    if (active && fn != mapPath) remove();
+
+    // An existing journal of fn is kept, it might be loaded next
+    mapPath = fn;
+    active = !fn.isEmpty();
+    reset();
+}
+
+QString VymJournal::getMapPath()
+{
+    return mapPath;
+}
+
+QString VymJournal::getJournalPath()
+{
+    return mapPath + ".journal";
+}
+
+void VymJournal::setTmpDir (const QString &dir)
+{
+    tmpDir = dir;
+}
+
+void VymJournal::addFileDir (const QString &dir)
+{
+    if (!dir.isEmpty() && !fileDirs.contains (dir)) fileDirs.append (dir);
+}
+
+void VymJournal::setBatchSize (int n)
+{
+    batchSize = qMax (1, n);
+}
+
+void VymJournal::setInterval (int msecs)
+{
+    flushTimer.setInterval (msecs);
+}
+
+void VymJournal::setBlocked (bool b)
+{
+    blocked = b;
+}
+
+bool VymJournal::isActive()
+{
+    return active;
+}
+
+void VymJournal::invalidateFile (const QString &path)
+{
+    fileIDs.remove (path);
+}
+
+void VymJournal::addCommand (const QString &selection, const QString &command)
+{
+    if (!active || blocked) return;
+
+    addRecord (QString ("C\t%1\t%2").arg(escape (selection)).arg(escape (embedFiles (command))));
+}
+
+void VymJournal::truncate()
+{
+    reset();
+    if (!active) return;
+
+    QFile f (getJournalPath());
+    if (f.exists() && !f.remove() )
+	qWarning() << "VymJournal::truncate  couldn't remove " << getJournalPath();
+}
+
+void VymJournal::remove()
+{
+    reset();
+
+    QFile f (getJournalPath());
+    if (f.exists() && !f.remove() )
+	qWarning() << "VymJournal::remove  couldn't remove " << getJournalPath();
+    active = false;
+}
+
+bool VymJournal::exists()
+{
+    return active && QFile (getJournalPath()).exists();
+}
+
+bool VymJournal::load (QList <Entry> &entries)
+{
+    entries.clear();
+
+    QFile f (getJournalPath());
+    if (!f.open (QIODevice::ReadOnly))
+    {
+	qWarning() << "VymJournal::load  couldn't open " << getJournalPath();
+	return false;
+    }
+    QStringList lines = QString::fromUtf8 (f.readAll()).split ("\n");
+    f.close();
+
+    // Last record might be incomplete, if vym crashed while writing
+    lines.removeLast();
+    if (lines.isEmpty() ) return false;
+
+    QStringList header = lines.takeFirst().split ("\t");
+    if (header.count() != 3 || header.at(0) != "vym-journal")
+    {
+	qWarning() << "VymJournal::load  no journal: " << getJournalPath();
+	return false;
+    }
+
+    // Journal has to continue exactly the map on disk
+    QDateTime t = QDateTime::fromMSecsSinceEpoch (header.at(2).toLongLong());
+    if (t != QFileInfo (mapPath).lastModified() )
+    {
+	qWarning() << "VymJournal::load  map has been saved after journal was started: " << mapPath;
+	return false;
+    }
+
+    QString fileDir = tmpDir + "/journal";
+    makeSubDirs (fileDir);
+
+    fileIDs.clear();
+    nextFileID = 0;
+    foreach (QString line, lines)
+    {
+	QStringList fields = line.split ("\t");
+	if (fields.count() != 3)
+	{
+	    qWarning() << "VymJournal::load  ignoring broken record in " << getJournalPath();
+	    continue;
+	}
+	if (fields.at(0) == "F")
+	{
+	    int id = fields.at(1).toInt();
+	    QString path = QString ("%1/%2.xml").arg(fileDir).arg(id);
+	    if (!saveStringToDisk (path, unescape (fields.at(2))))
+		qWarning() << "VymJournal::load  couldn't restore " << path;
+	    fileIDs.insert (path, id);
+	    nextFileID = qMax (nextFileID, id + 1);
+	} else if (fields.at(0) == "C")
+	{
+	    Entry e;
+	    e.selection = unescape (fields.at(1));
+	    e.command = unescape (fields.at(2)).replace (fileTag, fileDir);
+	    entries.append (e);
+	}
+    }
+
+    // New records are appended to the existing journal
+    baseTime = t;
+    headerWritten = true;
+    if (debug) qDebug() << "VymJournal::load  " << entries.count() << " commands in " << getJournalPath();
+    return true;
+}
+
+bool VymJournal::reject()
+{
+    reset();
+
+    // Keep a backup like for maps, e.g. for manual recovery
+    QString backup = getJournalPath() + "~";
+    QFile::remove (backup);
+    return QFile::rename (getJournalPath(), backup);
+}
+
+int VymJournal::getRecordsWritten()
+{
+    return recordsWritten;
+}
+
+int VymJournal::getFlushes()
+{
+    return flushes;
+}
+
+void VymJournal::flush()
+{
+    flushTimer.stop();
+    if (!active || records.isEmpty() ) return;
+
+    QFile f (getJournalPath());
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (headerWritten)
+	mode |= QIODevice::Append;
+    else
+    {
+	mode |= QIODevice::Truncate;
+	records.prepend (QString ("vym-journal\t%1\t%2").arg(vymVersion).arg(baseTime.toMSecsSinceEpoch()));
+    }
+
+    if (!f.open (mode))
+    {
+	qWarning() << "VymJournal::flush  couldn't write " << getJournalPath();
+	records.clear();
+	return;
+    }
+    f.write ((records.join ("\n") + "\n").toUtf8());
+    f.flush();
+    #ifdef Q_OS_WIN
+    _commit (f.handle());
+    #else
+    fsync (f.handle());
+    #endif
+    f.close();
+
+    if (!headerWritten) records.removeFirst();
+    headerWritten = true;
+    recordsWritten += records.count();
+    flushes++;
+    records.clear();
+}
+
+QString VymJournal::escape (const QString &s)
+{
+    // Records are separated by newlines, fields by tabs
+    QString r;
+    r.reserve (s.length());
+    for (int i = 0; i < s.length(); i++)
+    {
+	QChar c = s.at(i);
+	if (c == '\\')
+	    r += "\\\\";
+	else if (c == '\n')
+	    r += "\\n";
+	else if (c == '\r')
+	    r += "\\r";
+	else if (c == '\t')
+	    r += "\\t";
+	else
+	    r += c;
+    }
+    return r;
+}
+
+QString VymJournal::unescape (const QString &s)
+{
+    QString r;
+    r.reserve (s.length());
+    for (int i = 0; i < s.length(); i++)
+    {
+	QChar c = s.at(i);
+	if (c == '\\' && i + 1 < s.length() )
+	{
+	    c = s.at(++i);
+	    if (c == 'n')
+		r += '\n';
+	    else if (c == 'r')
+		r += '\r';
+	    else if (c == 't')
+		r += '\t';
+	    else
+		r += c;
+	} else
+	    r += c;
+    }
+    return r;
+}
+
+void VymJournal::reset()
+{
+    // Next record starts a new journal on top of the map on disk
+    flushTimer.stop();
+    records.clear();
+    fileIDs.clear();
+    nextFileID = 0;
+    headerWritten = false;
+    baseTime = QFileInfo (mapPath).lastModified();
+}
+
+void VymJournal::addRecord (const QString &record)
+{
+    records.append (record);
+    if (records.count() >= batchSize)
+	flush();
+    else if (!flushTimer.isActive() )
+	flushTimer.start();
+}
+
+QString VymJournal::embedFiles (const QString &command)
+{
+    // Copy files from tmpDir and fileDirs used by command into journal
+    QStringList dirs;
+    if (!tmpDir.isEmpty() ) dirs << QRegExp::escape (tmpDir);
+    foreach (QString d, fileDirs)
+	dirs << QRegExp::escape (d);
+    if (dirs.isEmpty() ) return command;
+
+    QRegExp re ("(" + dirs.join ("|") + ")/[^\"]*");
+    QString r;
+    int last = 0;
+    int pos = 0;
+    while ((pos = re.indexIn (command, pos)) != -1)
+    {
+	QString path = re.cap(0);
+	if (!fileIDs.contains (path))
+	{
+	    QString data;
+	    if (!loadStringFromDisk (path, data))
+	    {
+		qWarning() << "VymJournal  couldn't read " << path;
+		pos += re.matchedLength();
+		continue;
+	    }
+	    fileIDs.insert (path, nextFileID);
+	    addRecord (QString ("F\t%1\t%2").arg(nextFileID).arg(escape (data)));
+	    nextFileID++;
+	}
+	r += command.mid (last, pos - last);
+	r += QString ("%1/%2.xml").arg(fileTag).arg(fileIDs.value (path));
+	pos += re.matchedLength();
+	last = pos;
+    }
+    r += command.mid (last);
+    return r;
+}
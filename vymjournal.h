@@ -0,0 +1,93 @@
+#ifndef VYMJOURNAL_H
+#define VYMJOURNAL_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+/*! \brief Journal of changes since the last full save of a map
+
+    Each change of a map already has a redo command, which is written
+    by VymModel::saveState. These commands (and the commands of undo and
+    redo) are appended to mapPath + ".journal". Records are collected
+    and written with fsync in small batches, at most after "ms"
+    milliseconds.
+
+    Maps used by commands like addMapReplace are written to the temporary
+    directory of the model and lost after a crash. When a command refers
+    to such a file, its content is copied into the journal once, so that
+    the journal can be replayed onto the last saved version of the map.
+    The same is done for files in directories added with addFileDir,
+    e.g. the clipboard.
+
+    The journal is truncated after each successful full save and removed,
+    when the map is closed. So if it exists when the map is loaded,
+    vym probably crashed.
+*/
+
+class VymJournal:public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+	QString selection;
+	QString command;
+    };
+
+    VymJournal();
+    ~VymJournal();
+    void setMapPath (const QString &fn);
+    QString getMapPath();
+    QString getJournalPath();
+    void setTmpDir (const QString &dir);
+    void addFileDir (const QString &dir);	//! Also embed files from dir
+    void setBatchSize (int n);
+    void setInterval (int msecs);
+    void setBlocked (bool b);		//! Ignore commands, e.g. during replay
+    bool isActive();
+
+    void invalidateFile (const QString &path);	//! File in tmpDir has been rewritten
+    void addCommand (const QString &selection, const QString &command);
+    void truncate();			//! Called after full save
+    void remove();			//! Called when map is closed
+    bool exists();
+    bool load (QList <Entry> &entries);	//! Restores tmp files and continues journal
+    bool reject();			//! Move journal out of the way
+
+    int getRecordsWritten();
+    int getFlushes();
+
+public slots:
+    void flush();
+
+private:
+    static QString escape (const QString &s);
+    static QString unescape (const QString &s);
+    void reset();
+    void addRecord (const QString &record);
+    QString embedFiles (const QString &command);
+
+    QString mapPath;
+    QString tmpDir;
+    QStringList fileDirs;	    //! Besides tmpDir
+    QDateTime baseTime;		    //! Modification time of saved map
+    bool active;		    //! Map path set and journal owned by us
+    bool blocked;
+    bool headerWritten;
+
+    QStringList records;	    //! Waiting to be written
+    QHash <QString, int> fileIDs;   //! Files in tmpDir already in journal
+    int nextFileID;
+    QTimer flushTimer;
+    int batchSize;
+
+    int recordsWritten;
+    int flushes;
+};
+
+#endif
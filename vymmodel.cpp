@@ -12,12 +12,16 @@
 #endif
 
 #include <QColorDialog>
+#include <QEventLoop>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QMessageBox>
 #include <QPrinter>
+#include <QtConcurrent>
 
 #include "vymmodel.h"
 
+#include "animpoint.h"
 #include "attributeitem.h"
 #include "branchitem.h"
 #include "bug-agent.h"
@@ -34,7 +38,9 @@
 #include "export-orgmode.h"
 #include "file.h"
 #include "findresultmodel.h"
+#include "imports.h"
 #include "jira-agent.h"
+#include "liveshare.h"
 #include "lockedfiledialog.h"
 #include "mainwindow.h"
 #include "misc.h"
@@ -61,6 +67,7 @@
 extern bool debug;
 extern bool testmode;
 extern bool recoveryMode;  
+extern bool batchMode;
 extern QStringList ignoredLockedFiles;
 
 extern Main *mainWindow;
@@ -93,6 +100,8 @@ extern QDir lastExportDir;
 
 extern bool jiraClientAvailable;
 extern bool bugzillaClientAvailable;
+extern BugAgent *bugAgent;
+extern JiraAgent *jiraAgent;
 
 extern Settings settings;
 
@@ -145,6 +154,18 @@ void VymModel::init ()
     mapDefault      = true;
     mapUnsaved      = false;
 
+    // Scheduled updates
+    updateTimer = new QTimer (this);
+    updateTimer->setSingleShot (true);
+    connect(updateTimer, SIGNAL(timeout()), this, SLOT(flushUpdates()));
+    dirtyUpdates    = 0;
+    updatesDeferred = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        updatesRequested.append (0);
+        updatesDone.append (0);
+    }
+
     // Selection history
     selModel        = NULL;
     selectionBlocked= false;
@@ -157,12 +178,15 @@ void VymModel::init ()
     
     // Files
     readonly        = false;
+    interactive     = true;
     zipped          = true;
     filePath        = "";
     fileName        = tr("unnamed");
     mapName         = fileName;
     blockReposition = false;
     blockSaveState  = false;
+    historyBatch    = 0;
+    historyBatchCount = 0;
 
     autosaveTimer   = new QTimer (this);
     connect(autosaveTimer, SIGNAL(timeout()), this, SLOT(autosave()));
@@ -171,20 +195,16 @@ void VymModel::init ()
     connect(fileChangedTimer, SIGNAL(timeout()), this, SLOT(fileChanged()));
     fileChangedTimer->start(3000);
 
-    taskAlarmTimer   = new QTimer (this);
-    connect(taskAlarmTimer, SIGNAL(timeout()), this, SLOT(updateTasksAlarm()));
-    taskAlarmTimer->start(3000);
-    
     // find routine
     findReset();
 
     // animations   // FIXME-4 switch to new animation system 
     animationUse    = settings.value ("/animation/use",false).toBool();    // FIXME-4 add options to control _what_ is animated
-    animationTicks  = settings.value("/animation/ticks",20).toInt();
-    animationInterval=settings.value("/animation/interval",5).toInt();
-    animObjList.clear();    
-    animationTimer  = new QTimer (this);
-    connect(animationTimer, SIGNAL(timeout()), this, SLOT(animate()));
+    // Former settings used 20 ticks with 5ms interval
+    animationDuration = settings.value("/animation/duration",
+	settings.value("/animation/ticks",20).toInt() * settings.value("/animation/interval",5).toInt() ).toInt();
+    animObjects.clear();    
+    animationDriver = new AnimationDriver (this);
 
     // View - map
     defaultFont.setPointSizeF (16);
@@ -210,12 +230,14 @@ void VymModel::init ()
     // Initialize presentation slides
     slideModel      = new SlideModel (this);
     blockSlideSelection=false;
+    layoutGeneration= 0;
 
     // Avoid recursions later
     cleaningUpLinks = false;
 
     // Network
     netstate        = Offline;
+    liveShare       = NULL;
 
 #if defined(VYM_DBUS)
      // Announce myself on DBUS
@@ -257,7 +279,78 @@ bool VymModel::isRepositionBlocked()
 void VymModel::updateActions()	
 {
     // Tell mainwindow to update states of actions
-    mainWindow->updateActions();
+    scheduleUpdate (UpdateActions);
+}
+
+void VymModel::scheduleUpdate (int flags)
+{
+    for (int i = 0; i < updatesRequested.count(); i++)
+        if (flags & (1 << i)) updatesRequested[i]++;
+
+    dirtyUpdates |= flags;
+
+    // Updates are done when control returns to event loop
+    if (updatesDeferred == 0 && !updateTimer->isActive() )
+        updateTimer->start (0);
+}
+
+void VymModel::deferUpdates()
+{
+    updatesDeferred++;
+}
+
+void VymModel::resumeUpdates()
+{
+    if (updatesDeferred > 0) updatesDeferred--;
+    if (updatesDeferred == 0 && dirtyUpdates) flushUpdates();
+}
+
+void VymModel::flushLayout()
+{
+    // Also while updates are deferred, positions are needed now
+    if (!(dirtyUpdates & UpdateLayout) || blockReposition) return;
+
+    repositionNow();
+    dirtyUpdates &= ~UpdateLayout;
+    updatesDone[0]++;
+}
+
+void VymModel::flushUpdates()
+{
+    updateTimer->stop();
+
+    // Layout first, it might request more updates 
+    flushLayout();
+
+    // Layout stays pending, if it could not be done yet
+    int flags = dirtyUpdates & ~UpdateLayout;
+    dirtyUpdates &= UpdateLayout;
+    for (int i = 1; i < updatesDone.count(); i++)
+        if (flags & (1 << i)) updatesDone[i]++;
+
+    if (flags & UpdateSelection && selModel) emitSelectionChanged();
+    if (flags & UpdateShowSelection && !blockReposition) emit (showSelection() );
+    if (flags & UpdateHistory) mainWindow->updateHistory (undoSet);
+    if (flags & UpdateActions) mainWindow->updateActions();
+
+    // Selection requested by reposition above is already done
+    if (!dirtyUpdates) updateTimer->stop();
+}
+
+QString VymModel::getUpdateStats()
+{
+    QStringList names;
+    names << "layout" << "selection" << "show selection" << "actions" << "history";
+    QString s;
+    for (int i = 0; i < names.count(); i++)
+        s += QString ("  %1: %2 requested, %3 merged\n")
+            .arg(names.at(i), -15)
+            .arg(updatesRequested.at(i))
+            .arg(updatesRequested.at(i) - updatesDone.at(i));
+    s += QString ("  journal: %1 records written in %2 flushes\n")
+        .arg(journal.getRecordsWritten())
+        .arg(journal.getFlushes());
+    return s;
 }
 
 
@@ -479,6 +572,19 @@ bool VymModel::parseVymText (const QString &s)
     return ok;
 }
 
+void VymModel::setInteractive (bool b)
+{
+    interactive = b;
+}
+
+void VymModel::loadError (const QString &title, const QString &text)
+{
+    if (interactive)
+	QMessageBox::critical (0, title, text);
+    else
+	qWarning() << qPrintable (title) << ": " << qPrintable (text);
+}
+
 File::ErrorCode VymModel::loadMap (
     QString fname,
     const LoadMode &lmode, 
@@ -505,12 +611,13 @@ File::ErrorCode VymModel::loadMap (
 	    break;
 	case FreemindMap : handler = new parseFreemindHandler; break;
 	default: 
-	    QMessageBox::critical( 0, tr( "Critical Parse Error" ),
+	    loadError (tr( "Critical Parse Error" ),
 		   "Unknown FileType in VymModel::load()");
 	return File::Aborted;	
     }
 
     bool zipped_org = zipped;
+    bool checkJournal = false;
 
     if (lmode == NewMap)
     {
@@ -525,7 +632,7 @@ File::ErrorCode VymModel::loadMap (
     QString tmpZipDir = makeTmpDir (ok, tmpDirPath(), "unzip");
     if (!ok)
     {
-	QMessageBox::critical( 0, tr( "Critical Load Error" ),
+	loadError (tr( "Critical Load Error" ),
 	   tr("Couldn't create temporary directory before load\n"));
 	return File::Aborted; 
     }
@@ -535,7 +642,10 @@ File::ErrorCode VymModel::loadMap (
     else
     {
         // Try to unzip file
-        err = unzipDir (tmpZipDir, fname);
+        if (interactive)
+            err = unzipDir (tmpZipDir, fname);
+        else
+            err = unzipDirQuiet (tmpZipDir, fname);
     }
     QString xmlfile;
     if (err == File::NoZip)
@@ -575,8 +685,8 @@ File::ErrorCode VymModel::loadMap (
 
         if (flist.isEmpty() )
         {
-            QMessageBox::critical( 0, tr( "Critical Load Error" ),
-                                   tr("Couldn't find a map (*.xml) in .vym archive.\n"));
+            loadError (tr( "Critical Load Error" ),
+                       tr("Couldn't find a map (*.xml) in .vym archive.\n"));
             err=File::Aborted;
         }
 	} //file doesn't exist	
@@ -590,7 +700,7 @@ File::ErrorCode VymModel::loadMap (
     // according to check in mainwindow.
     if (!file.exists() )
     {
-	QMessageBox::critical( 0, tr( "Critical Parse Error" ),
+	loadError (tr( "Critical Parse Error" ),
 		   tr(QString("Couldn't open map %1").arg(file.fileName()).toUtf8()));
 	err = File::Aborted;	
     } else
@@ -629,7 +739,7 @@ File::ErrorCode VymModel::loadMap (
 	if ( ok ) 
 	{
 	    reposition();   // to generate bbox sizes
-	    emitSelectionChanged();
+	    scheduleUpdate (UpdateSelection);
 
 	    if (lmode == NewMap)
 	    {
@@ -641,15 +751,25 @@ File::ErrorCode VymModel::loadMap (
 		resetHistory();
 		resetSelectionHistory();
 
-                if (! tryVymLock() && debug ) 
-                    qWarning() << "VM::loadMap  no lockfile created!";
+                // Changes in journal are replaced by reloaded map
+                if (journal.isActive() ) journal.truncate();
+
+                // Maps received from a server or loaded without 
+                // user interaction are not locked
+                if (netstate != Client && interactive)
+                {
+                    if (tryVymLock() )
+                        checkJournal = true;
+                    else if (debug)
+                        qWarning() << "VM::loadMap  no lockfile created!";
+                }
             }
 
-	    // Recalc priorities and sort   
-	    taskModel->recalcPriorities();
+	    // Recalc priorities and sort, also refilter tasks of new map
+	    taskModel->recalcPriorities(true);
 	} else 
 	{
-	    QMessageBox::critical( 0, tr( "Critical Parse Error" ),
+	    loadError (tr( "Critical Parse Error" ),
 		       tr( handler->errorProtocol().toUtf8() ) );
 	    // returnCode=1;	
 	    // Still return "success": the map maybe at least
@@ -675,6 +795,8 @@ File::ErrorCode VymModel::loadMap (
 
     if (vymView) vymView->readSettings();  
 
+    if (checkJournal) initJournal();
+
     qApp->processEvents();  // Update view (scene()->update() is not enough)
     return err;
 }
@@ -771,7 +893,8 @@ File::ErrorCode VymModel::save (const SaveMode &savemode)
     makeSubDirs (fileDir);
 
     QString saveFile;
-    if (savemode==CompleteMap || selModel->selection().isEmpty())
+    bool completeMap = savemode==CompleteMap || selModel->selection().isEmpty();
+    if (completeMap)
     {
 	// Save complete map
         if (zipped)
@@ -821,6 +944,18 @@ File::ErrorCode VymModel::save (const SaveMode &savemode)
 
     updateActions();
     fileChangedTime=QFileInfo (destPath).lastModified();
+
+    // All changes are in the map on disk now, start a new journal
+    if (err==File::Success && completeMap)
+    {
+	if (journal.getMapPath()!=destPath)
+	{
+	    journal.setMapPath (destPath);
+	    journal.setTmpDir (tmpMapDir);
+	    journal.addFileDir (clipboardDir);
+	}
+	journal.truncate();
+    }
     return err;
 }
 
@@ -928,72 +1063,98 @@ void VymModel::saveImage (ImageItem *ii, QString format, QString fn)
 }
 
 
-void VymModel::importDirInt(BranchItem *dst, QDir d) 
+static void createMapObjsInt (BranchItem *bi, QGraphicsScene *scene)
 {
-    bool oldSaveState = blockSaveState;
-    blockSaveState = true;
-    BranchItem *bi = dst;
-    if (bi)
-    {
-	int beginDepth = bi->depth();
-
-	d.setFilter(QDir::AllEntries | QDir::Hidden);
-	QFileInfoList list = d.entryInfoList();
-	QFileInfo fi;
+    bi->createMapObj (scene);
+    for (int i = 0; i < bi->branchCount(); i++)
+	createMapObjsInt (bi->getBranchNum (i), scene);
+}
 
-	// Traverse directories
-	for (int i = 0; i < list.size(); ++i) 
+void VymModel::importDirInt(BranchItem *dst, const ImportDirEntry &e, int level) 
+{
+    // Only build the items here, MapObjs are created afterwards 
+    // by importDir, when the whole subtree is in place
+    // level is the depth of dst below the branch we import into
+    foreach (const ImportDirEntry &c, e.children)
+    {
+	QList<QVariant> cData;
+	cData << "" << "undef";
+	BranchItem *bi = new BranchItem (cData);
+	dst->appendChild (bi);
+	bi->setHeadingPlainText (c.name);
+	if (c.isDir)
 	{
-	    fi = list.at(i);
-	    if (fi.isDir() && fi.fileName() != "." && fi.fileName() != ".." )
-	    {
-		bi = addNewBranchInt(dst, -2);
-                bi->setHeadingPlainText (fi.fileName() );
-		bi->setHeadingColor (QColor("blue"));
-                if (debug) qDebug() << "Added subdir: " << fi.fileName();
-		if ( !d.cd(fi.fileName()) ) 
-		    QMessageBox::critical (0,tr("Critical Import Error"),tr("Cannot find the directory %1").arg(fi.fileName()));
-		else 
-		{
-		    // Recursively add subdirs
-		    importDirInt (bi, d);
-		    d.cdUp();
-		}
-		emitDataChanged(bi);
-	    }	
-	}	
+	    bi->setHeadingColor (QColor("blue"));
+	    importDirInt (bi, c, level + 1);
 
-	for (int i = 0; i < list.size(); ++i) 
+	    // Scroll at least some stuff. Scrolled branches get
+	    // invisible children, when MapObjs are created
+	    if (bi->branchCount() > 1 && level + 1 > 2) bi->toggleScroll();
+	} else
 	{
-	    fi = list.at(i);
-	    if (fi.isFile())
-	    {
-		bi = addNewBranchInt (dst,-2);
-                bi->setHeadingPlainText (fi.fileName() );
-		bi->setHeadingColor (QColor("black"));
-		if (fi.fileName().right(4) == ".vym" )
-		    bi->setVymLink (fi.filePath());
-		emitDataChanged(bi);
-	    }
-	}   
-
-	// Scroll at least some stuff
-	if (dst->branchCount()>1 && dst->depth()-beginDepth>2)
-	    dst->toggleScroll();
-    }	    
-    blockSaveState=oldSaveState;
+	    bi->setHeadingColor (QColor("black"));
+	    if (c.name.right(4) == ".vym" )
+		bi->setVymLink (c.path);
+	}
+    }
 }
 
-void VymModel::importDir (const QString &s)	
+void VymModel::importDir (const QString &s, int maxDepth, const QString &filter, qint64 maxSize)
 {
     BranchItem *selbi = getSelectedBranch();
-    if (selbi)
-    {
-	saveStateChangingPart (selbi, selbi, QString ("importDir (\"%1\")").arg(s),QString("Import directory structure from %1").arg(s));
+    if (!selbi) return;
 
-	QDir d(s);
-	importDirInt (selbi, d);
+    if (!QDir (s).exists() )
+    {
+	QMessageBox::critical (0,tr("Critical Import Error"),tr("Cannot find the directory %1").arg(s));
+	return;
     }
+
+    // Scan directory in background, large trees might take a while
+    ImportDirScan scanner;
+    scanner.setMaxDepth (maxDepth);
+    scanner.setFilters (filter.split (' ', QString::SkipEmptyParts) );
+    scanner.setMaxSize (maxSize);
+
+    QFutureWatcher <ImportDirEntry> watcher;
+    QEventLoop loop;
+    connect (&watcher, SIGNAL (finished()), &loop, SLOT (quit()));
+    watcher.setFuture (QtConcurrent::run (scanner, &ImportDirScan::scan, s));
+    if (!watcher.isFinished() ) 
+	loop.exec (QEventLoop::ExcludeUserInputEvents);
+    ImportDirEntry root = watcher.result();
+
+    int count = root.children.count();
+    if (debug) qDebug() << "VM::importDir " << s << " entries: " << ImportDirScan::count (root);
+    if (count == 0) return;
+
+    // selbi might have been deleted while waiting, e.g. by a script 
+    selbi = getSelectedBranch();
+    if (!selbi) return;
+
+    QString redo = QString ("importDir (\"%1\"").arg(s);
+    if (maxDepth >= 0 || !filter.isEmpty() || maxSize >= 0)
+	redo += QString (",%1,\"%2\",%3").arg(maxDepth).arg(filter).arg(maxSize);
+    redo += ")";
+    saveStateChangingPart (selbi, selbi, redo, QString("Import directory structure from %1").arg(s));
+
+    deferUpdates();
+
+    // Insert all rows in one go, branches are always at the end
+    emit (layoutAboutToBeChanged() );
+    int first = selbi->branchCount();
+    int n = selbi->childCount();
+    beginInsertRows (index(selbi), n, n + count - 1);
+    importDirInt (selbi, root, 0);
+    endInsertRows ();
+    emit (layoutChanged() );
+
+    // MapObjs need the MapObj of their parent, so create them top down
+    for (int i = first; i < selbi->branchCount(); i++)
+	createMapObjsInt (selbi->getBranchNum (i), mapEditor->getScene() );
+
+    reposition();
+    resumeUpdates();
 }   
 
 void VymModel::importDir()  
@@ -1122,6 +1283,117 @@ bool VymModel::isReadOnly()
     return readonly;
 }
 
+void VymModel::initJournal()
+{
+    if (journal.isActive() ) return;
+
+    journal.setMapPath (filePath);
+    journal.setTmpDir (tmpMapDir);
+    journal.addFileDir (clipboardDir);
+    journal.setBatchSize (settings.value ("/system/journal/batchSize", 10).toInt());
+    journal.setInterval (settings.value ("/system/journal/ms", 1000).toInt());
+    if (!journal.exists() ) return;
+
+    // Journal left over after a crash: Replay changes since last save
+    QList <VymJournal::Entry> entries;
+    if (!journal.load (entries))
+    {
+        journal.reject();
+        mainWindow->statusMessage (tr("Couldn't recover unsaved changes of %1").arg(mapName));
+        return;
+    }
+    if (entries.isEmpty() ) return;
+
+    if (!recoveryMode && batchMode)
+    {
+        qWarning() << "Unsaved changes of " << filePath << " not recovered, use --recover";
+        journal.reject();
+        return;
+    } else if (!recoveryMode)
+    {
+        QMessageBox mb (vymName,
+            tr("The map\n\n   %1\n\nhas %2 changes, which have not been saved, "
+               "probably because vym crashed.\n\nDo you want to recover these changes?")
+               .arg(filePath).arg(entries.count()),
+            QMessageBox::Question,
+            QMessageBox::Yes | QMessageBox::Default,
+            QMessageBox::No | QMessageBox::Escape,
+            QMessageBox::NoButton );
+        mb.setButtonText (QMessageBox::Yes, tr("Recover"));
+        mb.setButtonText (QMessageBox::No, tr("Discard"));
+        if (mb.exec() != QMessageBox::Yes)
+        {
+            journal.reject();
+            return;
+        }
+    }
+
+    // Replayed commands are in journal already
+    journal.setBlocked (true);
+    deferUpdates();
+    foreach (VymJournal::Entry e, entries)
+    {
+        if (!e.selection.isEmpty() ) select (e.selection);
+        execute (QString ("model = vym.currentMap(); model.%1").arg(e.command));
+    }
+    resumeUpdates();
+    journal.setBlocked (false);
+
+    mainWindow->statusMessage (tr("Recovered %1 unsaved changes of %2").arg(entries.count()).arg(mapName));
+}
+
+static QStringList splitChainedCommand (const QString &command)
+{
+    // Commands of a history batch are joined by "; model.",
+    // which might also be part of a string argument
+    static const QString sep = "; model.";
+    QStringList list;
+    QChar quote;
+    int start = 0;
+    for (int i = 0; i < command.length(); i++)
+    {
+	QChar c = command.at(i);
+	if (!quote.isNull() )
+	{
+	    if (c == '\\')
+		i++;
+	    else if (c == quote)
+		quote = QChar();
+	} else if (c == '"' || c == '\'')
+	    quote = c;
+	else if (command.midRef (i, sep.length()) == sep)
+	{
+	    list << command.mid (start, i - start);
+	    i += sep.length() - 1;
+	    start = i + 1;
+	}
+    }
+    list << command.mid (start);
+    return list;
+}
+
+void VymModel::journalCommand (const QString &selection, const QString &command)
+{
+    // paste reads the clipboard shared by all maps, which might have
+    // changed before replay. Journal its current content instead,
+    // also in chained commands of a history batch.
+    QStringList commands;
+    foreach (QString c, splitChainedCommand (command))
+    {
+	if (c.trimmed().startsWith ("paste"))
+	{
+	    for (uint i = 1; i <= clipboardItemCount; i++)
+	    {
+		QString fn = QString("%1/%2-%3.xml").arg(clipboardDir).arg(clipboardFile).arg(i);
+		journal.invalidateFile (fn);
+		commands << QString ("addMapInsert (\"%1\",-1,%2)").arg(fn).arg(SlideContent);
+	    }
+	} else
+	    commands << c;
+    }
+    if (!commands.isEmpty() ) journal.addCommand (selection, commands.join ("; model."));
+}
+
 void VymModel::autosave()
 {
     if (filePath=="") 
@@ -1157,7 +1429,7 @@ void VymModel::autosave()
 void VymModel::fileChanged()
 {
     // Check if file on disk has changed meanwhile
-    if (!filePath.isEmpty())
+    if (!filePath.isEmpty() && interactive)
     {
         if (readonly)
         {
@@ -1217,7 +1489,7 @@ bool VymModel::hasChanged()
 void VymModel::setChanged()
 {
     if (!mapChanged)
-	autosaveTimer->start(settings.value("/system/autosave/ms/",300000).toInt());
+	autosaveTimer->start(settings.value("/system/autosave/ms/",900000).toInt());
     mapChanged=true;
     mapDefault=false;
     mapUnsaved=true;
@@ -1244,6 +1516,8 @@ QString VymModel::getObjectName (TreeItem *ti)
 
 void VymModel::redo()
 {
+    writeHistoryBatch();
+
     // Can we undo at all?
     if (redosAvail<1) return;
 
@@ -1295,12 +1569,16 @@ void VymModel::redo()
     errMsg = QVariant( execute(redoScript) ).toString();
     blockSaveState=blockSaveStateOrg;
 
+    journalCommand (redoSelection, redoCommand);
+
+    if (netstate == Server) liveShare->sendOp (redoSelection, redoCommand);
+
     undoSet.setValue ("/history/undosAvail",QString::number(undosAvail));
     undoSet.setValue ("/history/redosAvail",QString::number(redosAvail));
     undoSet.setValue ("/history/curStep",QString::number(curStep));
     undoSet.writeSettings(histPath);
 
-    mainWindow->updateHistory (undoSet);
+    scheduleUpdate (UpdateHistory);
     updateActions();
 
     /* TODO remove testing
@@ -1321,6 +1599,9 @@ bool VymModel::isRedoAvailable()
 
 void VymModel::undo()	
 {
+    // Changes of a running batch become a step of their own
+    writeHistoryBatch();
+
     // Can we undo at all?
     if (undosAvail < 1) return;
 
@@ -1376,6 +1657,10 @@ void VymModel::undo()
     QString undoScript = QString("model = vym.currentMap(); model.%1").arg( undoCommand );
     errMsg = QVariant(execute(undoScript)).toString();
 
+    journalCommand (undoSelection, undoCommand);
+
+    if (netstate == Server) liveShare->sendOp (undoSelection, undoCommand);
+
     undosAvail--;
     curStep--; 
     if (curStep < 1) curStep = stepsTotal;
@@ -1396,7 +1681,7 @@ void VymModel::undo()
     undoSet.setValue ("/history/curStep",QString::number(curStep));
     undoSet.writeSettings(histPath);
 
-    mainWindow->updateHistory (undoSet);
+    scheduleUpdate (UpdateHistory);
     updateActions();
 }
 
@@ -1445,9 +1730,14 @@ void VymModel::resetHistory()
     redosAvail=0;
     undosAvail=0;
 
+    // Changes collected so far belong to the old history
+    historyBatchCount=0;
+    historyBatchUndo.clear();
+    historyBatchRedo.clear();
+
     stepsTotal=settings.value("/history/stepsTotal",100).toInt();
     undoSet.setValue ("/history/stepsTotal",QString::number(stepsTotal));
-    mainWindow->updateHistory (undoSet);
+    scheduleUpdate (UpdateHistory);
 }
 
 void VymModel::saveState(
@@ -1460,21 +1750,24 @@ void VymModel::saveState(
     TreeItem *saveSel, 
     QString dataXML)
 {
-    sendData(redoCom);	//FIXME-4 testing
-
     // Main saveState
 
     if (blockSaveState) return;
 
     if (debug) qDebug() << "VM::saveState() for  "<<mapName;
     
-    // Find out current undo directory
-    if (undosAvail<stepsTotal) undosAvail++;
-    curStep++;
-    if (curStep>stepsTotal) curStep=1;
+    // Find out current undo directory. In a batch all changes share one step
+    if (historyBatch==0 || historyBatchCount==0)
+    {
+	if (undosAvail<stepsTotal) undosAvail++;
+	curStep++;
+	if (curStep>stepsTotal) curStep=1;
+    }
     
     QString histDir=getHistoryPath();
     QString bakMapPath=histDir+"/map.xml";
+    if (historyBatch>0)
+	bakMapPath=histDir+QString("/map-%1.xml").arg(historyBatchCount);
 
     // Create histDir if not available
     QDir d(histDir);
@@ -1494,14 +1787,39 @@ void VymModel::saveState(
 	redoCommand.replace ("PATH",bakMapPath);
     }
 
+    if (netstate == Server) liveShare->sendOp (redoSelection, redoCommand);
+
     if (!dataXML.isEmpty())
+    {
 	// Write XML Data to disk
 	saveStringToDisk (bakMapPath,dataXML);
+	journal.invalidateFile (bakMapPath);
+    }
+
+    // Also changes collected in a batch are journaled one by one
+    journalCommand (redoSelection, redoCommand);
 
     // We would have to save all actions in a tree, to keep track of 
     // possible redos after a action. Possible, but we are too lazy: forget about redos.
     redosAvail=0;
 
+    if (historyBatch>0)
+    {
+	// Step is written once by endHistoryBatch, undo in reverse order
+	QString s=undoCommand;
+	if (!undoSelection.isEmpty())
+	    s=QString("select (\"%1\"); model.%2").arg(undoSelection).arg(undoCommand);
+	historyBatchUndo.prepend (s);
+	s=redoCommand;
+	if (!redoSelection.isEmpty())
+	    s=QString("select (\"%1\"); model.%2").arg(redoSelection).arg(redoCommand);
+	historyBatchRedo.append (s);
+	historyBatchCount++;
+
+	setChanged();
+	return;
+    }
+
     // Write the current state to disk
     undoSet.setValue ("/history/undosAvail",QString::number(undosAvail));
     undoSet.setValue ("/history/redosAvail",QString::number(redosAvail));
@@ -1531,13 +1849,48 @@ void VymModel::saveState(
         qDebug() << "    ---------------------------";
     }
 
-    mainWindow->updateHistory (undoSet);
+    scheduleUpdate (UpdateHistory);
 
     setChanged();
     updateActions();
 }
 
 
+void VymModel::beginHistoryBatch (const QString &comment)
+{
+    if (historyBatch==0) historyBatchComment=comment;
+    historyBatch++;
+}
+
+void VymModel::endHistoryBatch()
+{
+    if (historyBatch>0 && --historyBatch==0) writeHistoryBatch();
+}
+
+void VymModel::writeHistoryBatch()
+{
+    if (historyBatchCount==0) return;
+
+    undoSet.setValue ("/history/undosAvail",QString::number(undosAvail));
+    undoSet.setValue ("/history/redosAvail",QString::number(redosAvail));
+    undoSet.setValue ("/history/curStep",QString::number(curStep));
+    undoSet.setValue (QString("/history/step-%1/undoCommand").arg(curStep),historyBatchUndo.join ("; model."));
+    undoSet.setValue (QString("/history/step-%1/undoSelection").arg(curStep),"");
+    undoSet.setValue (QString("/history/step-%1/redoCommand").arg(curStep),historyBatchRedo.join ("; model."));
+    undoSet.setValue (QString("/history/step-%1/redoSelection").arg(curStep),"");
+    undoSet.setValue (QString("/history/step-%1/comment").arg(curStep),
+	QString("%1 (%2 changes)").arg(historyBatchComment).arg(historyBatchCount));
+    undoSet.setValue (QString("/history/version"),vymVersion);
+    undoSet.writeSettings(histPath);
+
+    historyBatchCount=0;
+    historyBatchUndo.clear();
+    historyBatchRedo.clear();
+
+    scheduleUpdate (UpdateHistory);
+    updateActions();
+}
+
 void VymModel::saveStateChangingPart(TreeItem *undoSel, TreeItem* redoSel, const QString &rc, const QString &comment)
 {
     // save the selected part of the map, Undo will replace part of map 
@@ -2019,7 +2372,7 @@ bool  VymModel::findAll (FindResultModel *rmodel, QString s, Qt::CaseSensitivity
     while (cur)
     {
 	lastParent = NULL;
-        if (cur->getHeading().getTextASCII().contains (s,cs))
+        if (cur->getHeadingPlain().contains (s,cs))
             {
                 lastParent = rmodel->addItem (cur);
                 hit = true;
@@ -2027,7 +2380,7 @@ bool  VymModel::findAll (FindResultModel *rmodel, QString s, Qt::CaseSensitivity
 
         if (searchNotes)
         {
-            QString n = cur->getNoteASCII();
+            QString n = cur->getNotePlain();
             int i = 0;
             int j = 0;
             while ( i >= 0)
@@ -2089,17 +2442,17 @@ BranchItem* VymModel::findText (QString s,Qt::CaseSensitivity cs)     // FIXME-2
 	if (findCurrent)
 	{
 	    // Searching in Note
-        if (findCurrent->getNoteASCII().contains(findString,cs))
+        if (findCurrent->getNotePlain().contains(findString,cs))
 	    {
 		select (findCurrent);
-		if (noteEditor->findText(findString,flags)) 
+		if (noteEditor && noteEditor->findText(findString,flags)) 
 		{
 		    searching=false;
 		    foundNote=true;
 		}   
 	    }
 	    // Searching in Heading
-        if (searching && findCurrent->getHeading().getTextASCII().contains (findString,cs) )
+        if (searching && findCurrent->getHeadingPlain().contains (findString,cs) )
 	    {
 		select(findCurrent);
 		searching=false;
@@ -2125,6 +2478,143 @@ void VymModel::findReset()
     EOFind=false;
 }
 
+QSet <TreeItem*> VymModel::findWords (const QString &s)
+{
+    updateWordIndex();
+
+    // Items must contain every word of s. Suffixes starting with a word
+    // are a range in the sorted suffix index, they belong to all indexed
+    // words containing it.
+    QSet <TreeItem*> result;
+    bool first=true;
+    foreach (QString w, splitWords (s))
+    {
+	QSet <QString> words;
+	QMap <QString, QSet <QString> >::const_iterator it;
+	for (it=wordSuffixes.lowerBound (w); it!=wordSuffixes.constEnd() && it.key().startsWith (w); ++it)
+	    words.unite (it.value());
+
+	QSet <TreeItem*> items;
+	foreach (QString word, words)
+	    items.unite (wordIndex.value (word));
+
+	if (first)
+	    result=items;
+	else
+	    result.intersect (items);
+	first=false;
+	if (result.isEmpty() ) return result;
+    }
+
+    // Terms like "c++" or "v1.2" are not words of the index,
+    // check them as substrings of the remaining items
+    QStringList terms;
+    foreach (QString t, s.split (QRegExp ("\\s+"), QString::SkipEmptyParts))
+	if (t.contains (QRegExp ("\\W"))) terms << t;
+    if (terms.isEmpty() ) return result;
+
+    if (first)
+	result=findRegExp (QRegExp (QRegExp::escape (terms.first()), Qt::CaseInsensitive));
+    foreach (TreeItem *ti, result)
+    {
+	QString heading=ti->getHeadingPlain();
+	QString note=ti->getNotePlain();
+	foreach (QString t, terms)
+	    if (!heading.contains (t, Qt::CaseInsensitive) && !note.contains (t, Qt::CaseInsensitive))
+	    {
+		result.remove (ti);
+		break;
+	    }
+    }
+    return result;
+}
+
+QSet <TreeItem*> VymModel::findRegExp (const QRegExp &re)
+{
+    QSet <TreeItem*> result;
+    QList <TreeItem*> todo;
+    for (int i=0; i<rootItem->childCount(); i++)
+	todo.append (rootItem->child(i));
+    while (!todo.isEmpty() )
+    {
+	TreeItem *ti=todo.takeLast();
+	if (ti->getHeadingPlain().contains (re) || ti->getNotePlain().contains (re))
+	    result.insert (ti);
+	for (int i=0; i<ti->childCount(); i++)
+	    todo.append (ti->child(i));
+    }
+    return result;
+}
+
+void VymModel::updateWordIndex (TreeItem *ti)
+{
+    // Only remember, index is updated with next query
+    wordIndexDirty.insert (ti);
+}
+
+QStringList VymModel::splitWords (const QString &s)
+{
+    static const QRegExp re ("\\W+");
+    return s.toLower().split (re, QString::SkipEmptyParts);
+}
+
+void VymModel::updateWordIndex()
+{
+    foreach (TreeItem *ti, wordIndexDirty)
+    {
+	removeWords (ti);
+	if (ti==rootItem || ti->getType()==TreeItem::Undefined) continue;
+
+	QStringList words=splitWords (ti->getHeadingPlain());
+	if (!ti->hasEmptyNote() ) words+=splitWords (ti->getNotePlain());
+	words.removeDuplicates();
+	foreach (QString w, words)
+	{
+	    QHash <QString, QSet <TreeItem*> >::iterator it=wordIndex.find (w);
+	    if (it==wordIndex.end() )
+	    {
+		it=wordIndex.insert (w, QSet <TreeItem*> () );
+		indexSuffixes (w, true);
+	    }
+	    it.value().insert (ti);
+	}
+	itemWords.insert (ti, words);
+    }
+    wordIndexDirty.clear();
+}
+
+void VymModel::removeWords (TreeItem *ti)
+{
+    foreach (QString w, itemWords.take (ti))
+    {
+	QHash <QString, QSet <TreeItem*> >::iterator it=wordIndex.find (w);
+	if (it==wordIndex.end() ) continue;
+	it.value().remove (ti);
+	if (it.value().isEmpty() )
+	{
+	    wordIndex.erase (it);
+	    indexSuffixes (w, false);
+	}
+    }
+}
+
+void VymModel::indexSuffixes (const QString &w, bool add)
+{
+    for (int i=0; i<w.length(); i++)
+    {
+	QString suffix=w.mid (i);
+	if (add)
+	    wordSuffixes[suffix].insert (w);
+	else
+	{
+	    QMap <QString, QSet <QString> >::iterator it=wordSuffixes.find (suffix);
+	    if (it==wordSuffixes.end() ) continue;
+	    it.value().remove (w);
+	    if (it.value().isEmpty() ) wordSuffixes.erase (it);
+	}
+    }
+}
+
 void VymModel::setURL(QString url) 
 {
     TreeItem *selti = getSelectedItem();
@@ -2409,7 +2899,7 @@ void VymModel::setHideExport(bool b, TreeItem *ti)
 	    QString ("Set HideExport flag of %1 to %2").arg(getObjectName(ti)).arg (r)
 	);  
 	    emitDataChanged(ti);
-	    emitSelectionChanged();
+	    scheduleUpdate (UpdateSelection);
 	reposition(); 
     }
 }
@@ -2441,13 +2931,13 @@ void VymModel::toggleTask()
 	if (!task )
 	{
 	    task=taskModel->createTask (selbi);
-	    taskEditor->select(task); 
+	    if (taskEditor) taskEditor->select(task); 
 	}
 	else
 	    taskModel->deleteTask (task);
 
 	emitDataChanged(selbi);
-	emitSelectionChanged();
+	scheduleUpdate (UpdateSelection);
 	reposition();
     }
 }
@@ -2469,7 +2959,7 @@ bool VymModel::cycleTaskStatus(bool reverse)
 	    task->setDateModification();
 	    
 	    // make sure task is still visible
-	    taskEditor->select (task);
+	    if (taskEditor) taskEditor->select (task);
             emitDataChanged(selbi);
             reposition();
             return true;
@@ -2621,14 +3111,6 @@ int VymModel::taskCount()
     return taskModel->count (this);
 }
 
-void VymModel::updateTasksAlarm(bool force)
-{
-    if (taskModel->updateAwake( force) || force)
-    {
-        reposition();
-    }
-}
-
 BranchItem* VymModel::addTimestamp()	//FIXME-4 new function, localize
 {
     BranchItem *selbi = addNewBranch();
@@ -2816,6 +3298,7 @@ void VymModel::detach()
 	int n=selbi->num();
 	QPointF p;
 	BranchObj *bo=selbi->getBranchObj();
+	flushLayout();
 	if (bo) p=bo->getAbsPos();
 	QString parsel=getSelectString(selbi->parent());
 	if ( relinkBranch (selbi,rootItem,-1,true) )	
@@ -3070,6 +3553,7 @@ BranchItem* VymModel::addMapCenter (bool saveStateFlag)
 	contextPos=QPointF();
 	BranchItem *bi;
 	BranchObj *bo;
+	flushLayout();
 	for (int i=0;i<rootItem->branchCount();++i)
 	{
 	    bi=rootItem->getBranchNum (i);
@@ -3202,8 +3686,8 @@ BranchItem* VymModel::addNewBranch(BranchItem *bi, int pos)
             // so we have to pass on this information via saveState.
             // TODO: Get rid of this positioning workaround
             /* FIXME-4  network problem:  QString ps=qpointfToString (newbo->getAbsPos());
-               sendData ("selectLatestAdded ()");
-               sendData (QString("move %1").arg(ps));
+               liveShare->sendOp ("", "selectLatestAdded ()");
+               liveShare->sendOp ("", QString("move %1").arg(ps));
                sendSelection();
                */
         }
@@ -3301,6 +3785,7 @@ bool VymModel::relinkBranch (
 
 	QPointF savePos;
 	LinkableMapObj *lmosel=branch->getLMO();
+	flushLayout();
 	if (lmosel) savePos=lmosel->getAbsPos();
 
 	if (!blockSaveState)
@@ -3387,7 +3872,7 @@ bool VymModel::relinkTo ( const QString &dest, int num, QPointF pos)
             // Now try to relink to branch
             if ( relinkBranch (selbi,(BranchItem*)dst, num, true))
             {
-                 emitSelectionChanged();
+                 scheduleUpdate (UpdateSelection);
                  return true;
             } else
                 return false;       // Relinking failed
@@ -3403,7 +3888,7 @@ bool VymModel::relinkTo ( const QString &dest, int num, QPointF pos)
                     ((BranchObj*)selbi->getLMO())->setRelPos();
                 }
                 reposition();
-                emitSelectionChanged();
+                scheduleUpdate (UpdateSelection);
                 return true;
             } 
         }
@@ -3528,6 +4013,7 @@ void VymModel::deleteKeepChildren(bool saveStateFlag)
 	}
 
 	QPointF p;
+	flushLayout();
 	if (selbi->getLMO()) p=selbi->getLMO()->getRelPos();
 	if (saveStateFlag) saveStateChangingPart(
 	    pi,
@@ -3677,7 +4163,7 @@ bool VymModel::scrollBranch(BranchItem *bi)
 		QString ("%1 %2").arg(r).arg(getObjectName(bi))
 	    );
 	    emitDataChanged(bi);
-	    emitSelectionChanged();
+	    scheduleUpdate (UpdateSelection);
 	    reposition();
 	    mapEditor->getScene()->update(); //Needed for _quick_ update,  even in 1.13.x 
 	    return true;
@@ -3704,7 +4190,7 @@ bool VymModel::unscrollBranch(BranchItem *bi)
 		QString ("%1 %2").arg(r).arg(getObjectName(bi))
 	    );
 	    emitDataChanged(bi);
-	    emitSelectionChanged();
+	    scheduleUpdate (UpdateSelection);
 	    reposition();
 	    mapEditor->getScene()->update(); //Needed for _quick_ update,  even in 1.13.x 
 	    return true;
@@ -3856,7 +4342,7 @@ ItemList VymModel::getLinkedMaps()
     {
 	if (cur->hasActiveSystemFlag("system-target") && !cur->getVymLink().isEmpty())
         {
-            s = cur->getHeading().getTextASCII();
+            s = cur->getHeadingPlain();
             s.replace(QRegularExpression("\n+"), " "); 
             s.replace(QRegularExpression("\\s+"), " "); 
             s.replace(QRegularExpression("^\\s+"), ""); 
@@ -3888,7 +4374,7 @@ ItemList VymModel::getTargets()
     {
 	if (cur->hasActiveSystemFlag("system-target"))
         {
-            s = cur->getHeading().getTextASCII();
+            s = cur->getHeadingPlain();
             s.replace(QRegularExpression("\n+"), " "); 
             s.replace(QRegularExpression("\\s+"), " "); 
             s.replace(QRegularExpression("^\\s+"), ""); 
@@ -3973,7 +4459,7 @@ void VymModel::colorBranch (QColor c)
 	);  
 	selbi->setHeadingColor(c); // color branch
 	emitDataChanged (selbi);
-	taskEditor->showSelection();
+	if (taskEditor) taskEditor->showSelection();
     }
     mapEditor->getScene()->update();    
 }
@@ -4003,7 +4489,7 @@ void VymModel::colorSubtree (QColor c, BranchItem *b)
             nextBranch (cur,prev,true,bi);
 	}   
     }
-    taskEditor->showSelection();
+    if (taskEditor) taskEditor->showSelection();
     mapEditor->getScene()->update();
 }
 
@@ -4080,6 +4566,9 @@ void VymModel::getJiraData(bool subtree)	    // FIXME-2 update error message, ch
 	QString url;
 	BranchItem *prev = NULL;
 	BranchItem *cur  = NULL;
+
+        // Lookups are queued, only "Updating" headings are set here
+        deferUpdates();
         nextBranch (cur, prev, true, selbi);
 	while (cur) 
 	{
@@ -4103,25 +4592,21 @@ void VymModel::getJiraData(bool subtree)	    // FIXME-2 update error message, ch
                     if (cur->branchCount() == 0 ) 
                     {
                         if (heading.contains(QRegExp("\\w[-|\\s](\\d+)")))
-                        {
-                            new JiraAgent (cur, heading);
-                            mainWindow->statusMessage (tr("Contacting Jira...", "VymModel"));
-                        }
+                            jiraAgent->request (cur, heading);
                     }
                 }
             }
 
 	    if (!url.isEmpty())
-	    {
-                new JiraAgent (cur,url);
-                mainWindow->statusMessage (tr("Contacting Jira...", "VymModel"));
-	    } 
+                jiraAgent->request (cur,url);
 
 	    if (subtree) 
 		nextBranch (cur, prev, true, selbi);
 	    else
 		cur = NULL;
 	}   
+        resumeUpdates();
+        mainWindow->statusMessage (tr("Contacting Jira...", "VymModel"));
     }
 }   
 
@@ -4163,6 +4648,9 @@ void VymModel::getBugzillaData(bool subtree)	    // FIXME-2 no longer reference
 	QString url;
 	BranchItem *prev = NULL;
 	BranchItem *cur  = NULL;
+
+        // Lookups are queued, only "Updating" headings are set here
+        deferUpdates();
         nextBranch (cur, prev, true, selbi);
 	while (cur) 
 	{
@@ -4171,16 +4659,15 @@ void VymModel::getBugzillaData(bool subtree)	    // FIXME-2 no longer reference
 	    {
 		// Don't run query again if we are in update mode
 		if (!subtree || ! url.contains("buglist.cgi") )
-		{
-		    new BugAgent (cur,url);
-		    mainWindow->statusMessage (tr("Contacting Bugzilla...", "VymModel"));
-		}
+		    bugAgent->request (cur,url);
 	    }
 	    if (subtree) 
 		nextBranch (cur, prev, true, selbi);
 	    else
 		cur = NULL;
 	}   
+        resumeUpdates();
+        mainWindow->statusMessage (tr("Contacting Bugzilla...", "VymModel"));
     }
 }   
 
@@ -4403,7 +4890,15 @@ QVariant VymModel::execute (const QString &script)  // FIXME-3 still required???
     // VymModel::updateSlideSelection
 {
     // qDebug()<<"VM::execute called: "<<script;
-    return mainWindow->runScript( script);
+    return mainWindow->runScript( script, this);
+}
+
+QVariantList VymModel::executeBatch (const QStringList &scripts, QList <int> &errorLevels)
+{
+    beginHistoryBatch (tr("Batch of %1 commands").arg(scripts.count()));
+    QVariantList results = mainWindow->runScriptBatch (scripts, this, errorLevels);
+    endHistoryBatch();
+    return results;
 }
 
 void VymModel::setExportMode (bool b)
@@ -4418,6 +4913,9 @@ void VymModel::setExportMode (bool b)
 
 QPointF VymModel::exportImage(QString fname, bool askName, QString format)  
 {
+    // Layout might still be pending, e.g. while running a script
+    flushUpdates();
+
     QPointF offset; // set later, when getting image from MapEditor
 
     if (fname=="")
@@ -4461,6 +4959,7 @@ QPointF VymModel::exportImage(QString fname, bool askName, QString format)
 
 void VymModel::exportPDF (QString fname, bool askName)
 {
+    flushUpdates();
     if (fname == "")
     {
         if (!askName) 
@@ -4514,6 +5013,7 @@ void VymModel::exportPDF (QString fname, bool askName)
 
 QPointF VymModel::exportSVG (QString fname, bool askName) 
 {
+    flushUpdates();
     QPointF offset; // FIXME-3 not needed?
 
     if (fname=="")
@@ -4562,6 +5062,7 @@ QPointF VymModel::exportSVG (QString fname, bool askName)
 
 void VymModel::exportXML (QString dpath, QString fpath, bool useDialog)
 {
+    flushUpdates();
     ExportBase ex;
     ex.setName( "XML" );
     ex.setModel( this );
@@ -4717,6 +5218,7 @@ void VymModel::exportCSV(const QString &fname, bool askName)
 
 void VymModel::exportHTML (const QString &dpath, const QString &fpath,bool useDialog)
 {
+    flushUpdates();
     ExportHTML ex (this);
     ex.setLastCommand( settings.localValue(filePath,"/export/last/command","").toString() );
 
@@ -4896,6 +5398,7 @@ bool VymModel::centerOnID( const QString &id)
         LinkableMapObj *lmo=((MapItem*)ti)->getLMO();
         if (zoomFactor>0 && lmo)
         {
+            flushLayout();
             mapEditor->setViewCenterTarget (
                 lmo->getBBox().center(),
                 zoomFactor,
@@ -4922,6 +5425,8 @@ void VymModel::unsetContextPos()
 
 void VymModel::updateNoteFlag()
 {
+    if (!noteEditor) return;
+
     TreeItem *selti=getSelectedItem();
     if (selti)
     {
@@ -4943,7 +5448,19 @@ void VymModel::updateNoteFlag()
 void VymModel::reposition() //FIXME-4 VM should have no need to reposition, but the views...
 {
     if (blockReposition) return;
+    if (updatesDeferred > 0)
+    {
+        // Done once, when updates are resumed
+        scheduleUpdate (UpdateLayout);
+        return;
+    }
+    repositionNow();
+}
 
+void VymModel::repositionNow()
+{
+    // Links are updated once, after all branches are in place
+    XLinkObj::deferUpdates();
     BranchObj *bo;
     for (int i=0;i<rootItem->branchCount(); i++)
     {
@@ -4953,10 +5470,12 @@ void VymModel::reposition() //FIXME-4 VM should have no need to reposition, but
 	else
 	    qDebug()<<"VM::reposition bo=0";
     }	
+    XLinkObj::resumeUpdates();
+    layoutGeneration++;
     mapEditor->getTotalBBox();	
 
     // required to *reposition* the selection box. size is already correct:
-    emitSelectionChanged();   
+    scheduleUpdate (UpdateSelection);
 }
 
 
@@ -5205,6 +5724,8 @@ void VymModel::move(const double &x, const double &y)
 	LinkableMapObj *lmo=seli->getLMO();
 	if (lmo)
 	{
+	    // Scripts might have changed the map without layout yet
+	    flushLayout();
 	    QPointF ap(lmo->getAbsPos());
 	    QPointF to(x, y);
 	    if (ap != to)
@@ -5217,7 +5738,7 @@ void VymModel::move(const double &x, const double &y)
 		    QString("Move %1 to %2").arg(getObjectName(seli)).arg(ps));
 		lmo->move(x,y);
 		reposition();
-		emitSelectionChanged();
+		scheduleUpdate (UpdateSelection);
 	    }
 	}
     }
@@ -5231,6 +5752,7 @@ void VymModel::moveRel (const double &x, const double &y)
 	LinkableMapObj *lmo=seli->getLMO();
 	if (lmo)
 	{
+	    flushLayout();
 	    QPointF rp(lmo->getRelPos());
 	    QPointF to(x, y);
 	    if (rp != to)
@@ -5244,35 +5766,40 @@ void VymModel::moveRel (const double &x, const double &y)
 		((OrnamentedObj*)lmo)->move2RelPos (x,y);
 		reposition();
 		lmo->updateLinkGeometry();
-		emitSelectionChanged();
+		scheduleUpdate (UpdateSelection);
 	    }
 	}   
     }
 }
 
 
-void VymModel::animate()   
+void VymModel::animate(const int &ms)
 {
-    animationTimer->stop();
-    BranchObj *bo;
-    int i=0;
-    while (i<animObjList.size() )
+    // Advance all animated objects by elapsed time
+    QList <MapObj*> finished;
+    foreach (MapObj *mo, animObjects)
+	if (!((BranchObj*)mo)->animate(ms) ) finished.append (mo);
+
+    // Reposition subtrees of animated objects once. Objects 
+    // with animated parents are repositioned with the parent
+    foreach (MapObj *mo, animObjects)
     {
-	bo=(BranchObj*)animObjList.at(i);
-	if (!bo->animate())
+	bool nested = false;
+	TreeItem *ti = mo->getTreeItem()->parent();
+	while (ti && ti->parent() && !nested)
 	{
-	    if (i>=0) 
-	    {	
-		animObjList.removeAt(i);
-		i--;
-	    }
+	    if (animObjects.contains ( ((MapItem*)ti)->getLMO() ) ) nested = true;
+	    ti = ti->parent();
 	}
-	bo->reposition();
-	i++;
-    } 
-    emitSelectionChanged();
+	if (!nested) ((BranchObj*)mo)->reposition();
+    }
+    layoutGeneration++;
+
+    foreach (MapObj *mo, finished)
+	animObjects.remove (mo);
+    if (animObjects.isEmpty() ) animationDriver->stop();
 
-    if (!animObjList.isEmpty()) animationTimer->start(animationInterval);
+    scheduleUpdate (UpdateSelection);
 }
 
 
@@ -5280,6 +5807,7 @@ void VymModel::startAnimation(BranchObj *bo, const QPointF &v)
 {
     if (!bo) return;
 
+    flushLayout();
     if (bo->getUseRelPos())
 	startAnimation (bo,bo->getRelPos(),bo->getRelPos()+v);
     else
@@ -5294,170 +5822,89 @@ void VymModel::startAnimation(BranchObj *bo, const QPointF &start, const QPointF
 	AnimPoint ap;
 	ap.setStart (start);
 	ap.setDest  (dest);
-	ap.setTicks (animationTicks);
+	ap.setDuration (animationDuration);
 	ap.setAnimated (true);
 	bo->setAnimation (ap);
-	if (!animObjList.contains(bo))
-	    animObjList.append( bo );
-	animationTimer->setSingleShot (true);
-	animationTimer->start(animationInterval);
+	animObjects.insert (bo);
+	if (animationDriver->state() != QAbstractAnimation::Running)
+	    animationDriver->start();
     }
 }
 
 void VymModel::stopAnimation (MapObj *mo)
 {
-    int i=animObjList.indexOf(mo);
-    if (i>=0)
-	animObjList.removeAt (i);
+    animObjects.remove (mo);
+    if (animObjects.isEmpty() ) animationDriver->stop();
 }
 
 void VymModel::stopAllAnimation ()
 {
-    BranchObj *bo;
-    int i=0;
-    while (i<animObjList.size() )
+    animationDriver->stop();
+    foreach (MapObj *mo, animObjects)
     {
-	bo=(BranchObj*)animObjList.at(i);
+	BranchObj *bo=(BranchObj*)mo;
 	bo->stopAnimation();
 	bo->requestReposition();
-	i++;
     } 
+    animObjects.clear();
     reposition();
 }
 
 void VymModel::sendSelection()
 {
-    if (netstate!=Server) return;
-    sendData (QString("select (\"%1\")").arg(getSelectString()) );
+    if (netstate != Server) return;
+    liveShare->sendOp ("", QString("select (\"%1\")").arg(getSelectString()) );
 }
 
-void VymModel::newServer()
-{
-    port=54321;
-    sendCounter=0;
-    tcpServer = new QTcpServer(this);
-    if (!tcpServer->listen(QHostAddress::Any,port)) {
-        QMessageBox::critical(NULL, "vym server",
-                              QString("Unable to start the server: %1.").arg(tcpServer->errorString()));
-        //FIXME-3 needed? we are no widget any longer... close();
-        return;
-    }
-    connect(tcpServer, SIGNAL(newConnection()), this, SLOT(newClient()));
-    netstate=Server;
-    qDebug()<<"Server is running on port "<<tcpServer->serverPort();
-}
-
-void VymModel::connectToServer()
-{
-    port=54321;
-    server="salam.suse.de";
-    server="localhost";
-    clientSocket = new QTcpSocket (this);
-    clientSocket->abort();
-    clientSocket->connectToHost(server ,port);
-    connect(clientSocket, SIGNAL(readyRead()), this, SLOT(readData()));
-    connect(clientSocket, SIGNAL(error(QAbstractSocket::SocketError)),
-            this, SLOT(displayNetworkError(QAbstractSocket::SocketError)));
-    netstate=Client;	    
-    qDebug()<<"connected to "<<qPrintable (server)<<" port "<<port;
-
-    
-}
-
-void VymModel::newClient()
-{
-    QTcpSocket *newClient = tcpServer->nextPendingConnection();
-    connect(newClient, SIGNAL(disconnected()),
-            newClient, SLOT(deleteLater()));
-
-    qDebug() <<"ME::newClient  at "<<qPrintable( newClient->peerAddress().toString() );
-
-    clientList.append (newClient);
-}
-
-
-void VymModel::sendData(const QString &s)
+bool VymModel::newServer(int port, const QString &address)
 {
-    if (clientList.size()==0) return;
+    if (netstate != Offline) return false;
 
-    // Create bytearray to send
-    QByteArray block;
-    QDataStream out(&block, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_4_0);
+    if (port < 0) port = settings.value ("/network/port", 54321).toInt();
 
-    // Reserve some space for blocksize
-    out << (quint16)0;
-
-    // Write sendCounter
-    out << sendCounter++;
-
-    // Write data
-    out << s;
-
-    // Go back and write blocksize so far
-    out.device()->seek(0);
-    quint16 bs=(quint16)(block.size() - 2*sizeof(quint16));
-    out << bs;
-
-    if (debug)
-	qDebug() << "ME::sendData  bs="<<bs<<"  counter="<<sendCounter<<"  s="<<qPrintable(s);
+    // Other hosts may only connect, if an address is given explicitly
+    QHostAddress hostAddress (QHostAddress::LocalHost);
+    if (!address.isEmpty() && !hostAddress.setAddress (address))
+    {
+        QMessageBox::critical(NULL, "vym server",
+                              QString("Unable to start the server: Invalid address %1").arg(address));
+        return false;
+    }
 
-    for (int i=0; i<clientList.size(); ++i)
+    liveShare = new LiveShare (this, this);
+    if (!liveShare->listen (port, hostAddress)) 
     {
-	//qDebug() << "Sending \""<<qPrintable (s)<<"\" to "<<qPrintable (clientList.at(i)->peerAddress().toString());
-	clientList.at(i)->write (block);
+        QMessageBox::critical(NULL, "vym server",
+                              QString("Unable to start the server: %1.").arg(liveShare->errorString()));
+        delete liveShare;
+        liveShare = NULL;
+        return false;
     }
+    netstate = Server;
+    mainWindow->statusMessage (QString ("Sharing map on %1 port %2").arg(hostAddress.toString()).arg(liveShare->serverPort()));
+    return true;
 }
 
-void VymModel::readData ()
+void VymModel::connectToServer(QString server, int port)
 {
-    while (clientSocket->bytesAvailable() >=(int)sizeof(quint16) )
-    {
-	if (debug)
-	    qDebug() <<"readData  bytesAvail="<<clientSocket->bytesAvailable();
-	quint16 recCounter;
-	quint16 blockSize;
+    if (netstate != Offline) return;
 
-	QDataStream in(clientSocket);
-	in.setVersion(QDataStream::Qt_4_0);
-
-	in >> blockSize;
-	in >> recCounter;
-	
-	QString t;
-	in >>t;
-	if (debug)
-	    qDebug() << "VymModel::readData  command="<<qPrintable (t);
-	//bool noErr;
-	//QString errMsg;
-	// parseAtom (t,noErr,errMsg);    //FIXME-2 needs rework using scripts
+    if (server.isEmpty() ) server = settings.value ("/network/server", "localhost").toString();
+    if (port < 0) port = settings.value ("/network/port", 54321).toInt();
+    liveShare = new LiveShare (this, this);
+    liveShare->connectToServer (server, port);
+    netstate = Client;	    
+    mainWindow->statusMessage (QString ("Connecting to %1 port %2").arg(server).arg(port));
+}
 
-    }
-    return;
+VymModel::NetState VymModel::getNetState()
+{
+    return netstate;
 }
 
-void VymModel::displayNetworkError(QAbstractSocket::SocketError socketError)
+LiveShare* VymModel::getLiveShare()
 {
-    switch (socketError) {
-    case QAbstractSocket::RemoteHostClosedError:
-        break;
-    case QAbstractSocket::HostNotFoundError:
-        QMessageBox::information(NULL, vymName +" Network client",
-                                 "The host was not found. Please check the "
-                                    "host name and port settings.");
-        break;
-    case QAbstractSocket::ConnectionRefusedError:
-        QMessageBox::information(NULL, vymName + " Network client",
-                                 "The connection was refused by the peer. "
-                                    "Make sure the fortune server is running, "
-                                    "and check that the host name and port "
-                                    "settings are correct.");
-        break;
-    default:
-        QMessageBox::information(NULL, vymName + " Network client",
-                                 QString("The following error occurred: %1.")
-                                 .arg(clientSocket->errorString()));
-    }
+    return liveShare;
 }
 
 void VymModel::downloadImage (const QUrl &url, BranchItem *bi) 
@@ -5599,17 +6046,96 @@ bool VymModel::nextIterator(const QString &iname)
 void VymModel::setHideTmpMode (TreeItem::HideTmpMode mode)  
 {
     hidemode=mode;
-    for (int i=0;i<rootItem->branchCount();i++)
-	rootItem->getBranchNum(i)->setHideTmp (mode);
-    reposition();
+
+    // Only subtrees below branches with hideExport flag are affected.
+    // Hide the topmost ones or unhide the ones hidden before
+    QList <TreeItem*> roots;
+    if (mode==TreeItem::HideExport)
+    {
+	foreach (TreeItem *ti, hideExportItems)
+	{
+	    TreeItem *pi = ti->parent();
+	    while (pi && !hideExportItems.contains (pi) ) pi = pi->parent();
+	    if (!pi) roots.append (ti);
+	}
+	hiddenTmpItems = roots;
+    } else
+    {
+	roots = hiddenTmpItems;
+	hiddenTmpItems.clear();
+    }
+
+    // Selection is not drawn in exports
     if (mode==TreeItem::HideExport)
 	unselectAll();
     else
 	reselect();
 
+    if (roots.isEmpty() ) return;
+
+    QList <BranchItem*> mapCenters;
+    foreach (TreeItem *ti, roots)
+    {
+	ti->setHideTmp (mode);
+
+	TreeItem *mc = ti;
+	while (mc->parent() && mc->parent() != rootItem) mc = mc->parent();
+	if (!mapCenters.contains ((BranchItem*)mc) ) mapCenters.append ((BranchItem*)mc);
+    }
+
+    // Relayout only the mapcenters containing changed subtrees
+    if (blockReposition) return;
+    if (updatesDeferred > 0)
+	scheduleUpdate (UpdateLayout);
+    else
+    {
+	XLinkObj::deferUpdates();
+	foreach (BranchItem *mc, mapCenters)
+	{
+	    BranchObj *bo = mc->getBranchObj();
+	    if (bo) bo->reposition();
+	}
+	XLinkObj::resumeUpdates();
+	layoutGeneration++;
+	mapEditor->getTotalBBox();	
+	scheduleUpdate (UpdateSelection);
+    }
+
     qApp->processEvents();
 }
 
+void VymModel::updateHideExportIndex (TreeItem *ti)
+{
+    if (!ti->isBranchLikeType() ) return;
+    if (ti->hideInExport() )
+	hideExportItems.insert (ti);
+    else
+	hideExportItems.remove (ti);
+}
+
+void VymModel::itemAboutToBeDeleted (TreeItem *ti)
+{
+    // Remove ti and its children from word index
+    QList <TreeItem*> todo;
+    todo.append (ti);
+    while (!todo.isEmpty() )
+    {
+	TreeItem *cur=todo.takeLast();
+	removeWords (cur);
+	wordIndexDirty.remove (cur);
+	for (int i=0; i<cur->childCount(); i++)
+	    todo.append (cur->child(i));
+    }
+
+    if (hideExportItems.isEmpty() && hiddenTmpItems.isEmpty() ) return;
+
+    // Forget ti and its children
+    foreach (TreeItem *hi, hideExportItems)
+	if (hi == ti || hi->isChildOf (ti) ) hideExportItems.remove (hi);
+    foreach (TreeItem *hi, hiddenTmpItems)
+	if (hi == ti || hi->isChildOf (ti) ) hiddenTmpItems.removeAll (hi);
+}
+
 //////////////////////////////////////////////
 // Selection related
 //////////////////////////////////////////////
@@ -5853,7 +6379,12 @@ void VymModel::appendSelection()    // FIXME-4 history unable to cope with multi
 
 void VymModel::emitShowSelection()  
 {
-    if (!blockReposition) emit (showSelection() );
+    if (blockReposition) return;
+    if (updatesDeferred > 0)
+        // Positions are not updated yet
+        scheduleUpdate (UpdateShowSelection);
+    else
+        emit (showSelection() );
 }
 
 void VymModel::emitNoteChanged (TreeItem *ti)
@@ -5866,13 +6397,19 @@ void VymModel::emitDataChanged (TreeItem *ti)
 {
     QModelIndex ix=index(ti);
     emit ( dataChanged (ix,ix) );
-    emitSelectionChanged();
-    if (!blockReposition)
+    scheduleUpdate (UpdateSelection);
+    if ( ti->isBranchLikeType() && ((BranchItem*)ti)->getTask()  )
     {
-        if ( ti->isBranchLikeType() && ((BranchItem*)ti)->getTask()  )
+        Task *task = ((BranchItem*)ti)->getTask();
+        if (!blockReposition)
         {
-            taskModel->emitDataChanged ( ((BranchItem*)ti)->getTask() );
+            taskModel->emitDataChanged (task);
             taskModel->recalcPriorities();
+        } else
+        {
+            // Flags might change e.g. while loading
+            task->invalidateBranchPriority();
+            task->invalidateFilterKey();
         }
     }
 }
@@ -6324,10 +6861,78 @@ void VymModel::updateSlideSelection (QItemSelection newsel,QItemSelection)
 	QString inScript=si->getInScript();
 
 	// show inScript in ScriptEditor
-	scriptEditor->setSlideScript(modelID, si->getID(), inScript );
+	if (scriptEditor) scriptEditor->setSlideScript(modelID, si->getID(), inScript );
+
+	// Execute inScript, unless it can be done directly
+	if (!showSlide (si)) execute (inScript);
+    }
+}
+
+bool VymModel::showSlide (SlideItem *si)
+{
+    if (!si->hasTarget() || !mapEditor) return false;
+
+    // Cached positions are only valid after a pending layout
+    flushLayout();
+    if (dirtyUpdates & UpdateLayout) return false;
+
+    QPointF p;
+    if (!si->getTargetPos (p, layoutGeneration))
+    {
+	resolveSlideTargets (si->childNumber());
+	if (!si->getTargetPos (p, layoutGeneration)) return false;
+    }
 
-	// Execute inScript 
-	execute (inScript);
+    // Same as map.setMapZoom, map.setMapRotation and map.centerOnID
+    setMapZoomFactor (si->getTargetZoom());
+    setMapRotationAngle (si->getTargetAngle());
+    if (zoomFactor>0)
+	mapEditor->setViewCenterTarget (
+	    p,
+	    zoomFactor,
+	    rotationAngle,
+	    animDuration,
+	    animCurve);
+    return true;
+}
+
+void VymModel::resolveSlideTargets (int n)
+{
+    // Slides are usually shown one after the other, so look up
+    // the next ones, too. Then only every few slides the tree is walked.
+    static const int prefetch = 3;
+
+    QHash <QUuid, QList <SlideItem*> > wanted;
+    QPointF p;
+    for (int i=n; i<=n + prefetch && i<slideModel->count(); i++)
+    {
+	SlideItem *si=slideModel->getSlide (i);
+	if (si && si->hasTarget() && !si->getTargetPos (p, layoutGeneration))
+	    wanted[si->getTargetUuid()].append (si);
+    }
+    if (wanted.isEmpty() ) return;
+
+    // Same items as in findUuid, but all targets in one walk
+    BranchItem *cur=NULL;
+    BranchItem *prev=NULL;
+    nextBranch(cur,prev);
+    while (cur && !wanted.isEmpty() ) 
+    {
+	QList <MapItem*> items;
+	items.append (cur);
+	for (int j=0; j<cur->xlinkCount(); j++)
+	    items.append (cur->getXLinkItemNum (j));
+	for (int j=0; j<cur->imageCount(); j++)
+	    items.append (cur->getImageNum (j));
+
+	foreach (MapItem *mi, items)
+	{
+	    if (!wanted.contains (mi->getUuid())) continue;
+	    LinkableMapObj *lmo=mi->getLMO();
+	    foreach (SlideItem *si, wanted.take (mi->getUuid()))
+		if (lmo) si->setTargetPos (lmo->getBBox().center(), layoutGeneration);
+	}
+	nextBranch(cur,prev);
     }
 }
 
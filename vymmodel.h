@@ -4,6 +4,7 @@
 #include <QtNetwork>
 
 #include <QPointF>
+#include <QSet>
 #include <QTextCursor>
 
 #if defined(VYM_DBUS)
@@ -17,12 +18,16 @@
 #include "treeitem.h"
 #include "treemodel.h"
 #include "vymmodelwrapper.h"
+#include "vymjournal.h"
 #include "vymlock.h"
 
+class AnimationDriver;
 class AttributeItem;
 class BranchItem;
 class FindResultModel;
+struct ImportDirEntry;
 class Link;
+class LiveShare;
 class MapEditor;
 class SlideItem;
 class SlideModel;
@@ -72,6 +77,33 @@ public:
     bool isRepositionBlocked();	    //!< While load or undo there is no need to update graphicsview
     void updateActions();	    //!< Update buttons in mainwindow
 
+////////////////////////////////////////////
+// Scheduled updates of views and mainwindow
+////////////////////////////////////////////
+public:
+    enum UpdateFlag {
+	UpdateLayout	    = 0x01,	//!< reposition()
+	UpdateSelection	    = 0x02,	//!< emitSelectionChanged()
+	UpdateShowSelection = 0x04,	//!< emitShowSelection()
+	UpdateActions	    = 0x08,	//!< Main::updateActions()
+	UpdateHistory	    = 0x10	//!< Main::updateHistory()
+    };
+    void scheduleUpdate (int flags);	//!< Mark as dirty, done once in next frame
+    void deferUpdates();		//!< Merge all updates e.g. while running a script
+    void resumeUpdates();		//!< Flush merged updates, if not nested
+    void flushLayout();			//!< Do pending layout now, e.g. before reading positions
+    QString getUpdateStats();		//!< Number of requested and merged updates
+
+public slots:
+    void flushUpdates();		//!< Do all pending updates now
+
+private:
+    QTimer *updateTimer;
+    int dirtyUpdates;
+    int updatesDeferred;
+    QList <uint> updatesRequested;
+    QList <uint> updatesDone;
+
 
 ////////////////////////////////////////////
 // Load/save 
@@ -136,6 +168,13 @@ public:
 
     bool parseVymText(const QString &s);
 
+    /*! \brief Load maps without dialogs and lockfiles, e.g. for --convert */
+    void setInteractive (bool b);
+private:
+    bool interactive;
+    void loadError (const QString &title, const QString &text);
+
+public:
     /*! \brief Load map
 
 	The data is read from file. Depending on LoadMode the current
@@ -158,9 +197,15 @@ public:
     void saveImage (ImageItem *ii=NULL, QString format="", QString fn="");
 
 private:    
-    void importDirInt(BranchItem *,QDir);
+    void importDirInt(BranchItem *,const ImportDirEntry &, int level);
 public:	
-    void importDir(const QString&);
+    /*! \brief Import directory structure below selected branch
+
+	Optionally limit depth of subdirectories, import only files
+	matching the space separated wildcards in filter and skip
+	files larger than maxSize bytes.
+    */
+    void importDir(const QString&, int maxDepth = -1, const QString &filter = "", qint64 maxSize = -1);
     void importDir();
 
 private:    
@@ -172,7 +217,11 @@ public:
     bool isReadOnly();
 
 private:
+    void initJournal();	    //! Start journal or replay it after crash
+    void journalCommand (const QString &selection, const QString &command);
+
     VymLock  vymLock;       //! Handle lockfiles and related information
+    VymJournal journal;	    //! Changes since last save, for recovery
     bool readonly;          //! if map is locked, it can be opened readonly
 
 private slots:
@@ -196,6 +245,13 @@ private:
     int undosAvail;		//!< Available number of undo steps
     bool blockReposition;	//!< block while load or undo
     bool blockSaveState;	//!< block while load or undo
+
+    int historyBatch;		    //!< > 0 while saveState collects into one step
+    int historyBatchCount;	    //!< Changes collected in current step
+    QStringList historyBatchUndo;   //!< Undo commands, latest first
+    QStringList historyBatchRedo;
+    QString historyBatchComment;
+    void writeHistoryBatch();	    //!< Write collected changes as one step
 public:
     bool isDefault();		//!< true, if map is still the empty default map
     void makeDefault();		//!< Reset changelog, declare this as default map
@@ -220,6 +276,13 @@ public:
     QString getHistoryPath();		//!< Path to directory containing the history
     void resetHistory();		//!< Initialize history
 
+    /*! \brief Collect all following changes into a single history step
+
+	Calls may be nested, the step is written by the last endHistoryBatch.
+    */
+    void beginHistoryBatch (const QString &comment);
+    void endHistoryBatch();
+
     /*! \brief Save the current changes in map 
 
 	Two commands and selections are saved:
@@ -344,8 +407,28 @@ public:
             bool searchNotes = true);
     BranchItem* findText(QString s,Qt::CaseSensitivity cs); // Find object, also in note
     void findReset();			    // Reset Search
+
+    /*! \brief Find items, whose heading or note contain all words of s
+
+	Each word of s may be part of a word in the item, case is ignored.
+	Answered from an index of lowercase words and a sorted index of
+	their suffixes, which are updated only for items changed since the
+	last query. Terms with other characters like "c++" are checked as
+	substrings of the found items.
+    */
+    QSet <TreeItem*> findWords (const QString &s);
+    QSet <TreeItem*> findRegExp (const QRegExp &re);	//!< Scan headings and notes of all items
+    void updateWordIndex (TreeItem *ti);    //!< Called when heading or note of ti changes
+    static QStringList splitWords (const QString &s);
 private:
     QString findString;
+    QHash <QString, QSet <TreeItem*> > wordIndex;   //!< Lowercase word -> items
+    QHash <TreeItem*, QStringList> itemWords;	    //!< Words indexed for item
+    QMap <QString, QSet <QString> > wordSuffixes;   //!< Suffix -> words in wordIndex ending with it
+    QSet <TreeItem*> wordIndexDirty;		    //!< Changed since last query
+    void updateWordIndex();
+    void removeWords (TreeItem *ti);
+    void indexSuffixes (const QString &w, bool add);
 
 public:
     void setURL(QString url);
@@ -390,15 +473,6 @@ public:
     /*! count tasks in this model */
     int taskCount();
 
-    /*! Update task priorities */
-private slots:
-    void updateTasksAlarm(bool force = false);
-
-private:
-    /*! Timer to check if tasks need to be awoken */
-    QTimer *taskAlarmTimer;
-
-public:
     BranchItem*  addTimestamp();	
 
     void copy();			//!< Copy to clipboard
@@ -544,12 +618,20 @@ public:
 public:	
     /* \brief Runs the script */
     QVariant execute (const QString &script);
+    /*! Run scripts as one transaction: Single layout and one undo step.
+	Returns result of each script, errorLevels are set like in Main::runScriptBatch */
+    QVariantList executeBatch (const QStringList &scripts, QList <int> &errorLevels);
 
 ////////////////////////////////////////////
 // Exports
 ////////////////////////////////////////////
 private:
     TreeItem::HideTmpMode hidemode; // true while exporting to hide some stuff
+    QSet <TreeItem*> hideExportItems;	//! Branches with hideExport flag
+    QList <TreeItem*> hiddenTmpItems;	//! Subtrees hidden by current hidemode
+
+protected:
+    virtual void itemAboutToBeDeleted (TreeItem *ti);
 
 public:
     /*! Set or unset temporary hiding of objects during export  */
@@ -628,7 +710,11 @@ public:
 
     void updateNoteFlag();		//!< Signal origination in TextEditor
     void reposition();			//!< Call reposition for all MCOs
+private:
+    void repositionNow();		//!< Reposition, even if updates are deferred
+public:
     void setHideTmpMode (TreeItem::HideTmpMode mode);	
+    void updateHideExportIndex (TreeItem *ti);	//!< Called when hideExport flag changes
 
     void emitNoteChanged  (TreeItem *ti);
     void emitDataChanged  (TreeItem *ti);
@@ -688,16 +774,14 @@ public:
 // Animation  **experimental**
 ////////////////////////////////////////////
 private:    
-    QTimer *animationTimer;
+    AnimationDriver *animationDriver;
     bool animationUse;
-    uint animationTicks;
-    uint animationInterval;
-    int timerId;		// animation timer
-    QList <MapObj*> animObjList;// list with animated objects 
+    int animationDuration;	// ms
+    QSet <MapObj*> animObjects;	// animated objects 
 
-private slots:
-    void animate();			//!< Called by timer to animate stuff
 public:
+    void animate(const int &ms);	//!< Called by AnimationDriver once per frame
+
     void startAnimation(BranchObj *bo, const QPointF &v);
     void startAnimation(BranchObj *bo, const QPointF &start, const QPointF &dest);
     void stopAnimation(MapObj *mo);
@@ -720,26 +804,16 @@ public:
 private:
     // Network connections **Experimental**
     NetState netstate;		// offline, client, server
-    QTcpServer *tcpServer;	// Act as server in conference mode (experimental)
-    QList <QTcpSocket*> clientList;	// List of connected clients
-    quint16 sendCounter;	// Increased with every sent command
-
-    QTcpSocket	*clientSocket;	// socket of this client
-    QString server;		// server address of this client
-    int port;			// server port of this client
+    LiveShare *liveShare;	// Shares map with clients or receives it from server
 
 protected:
     void sendSelection();
 
 public:
-    void newServer();
-    void connectToServer();
-
-private slots:	
-    void newClient();
-    void sendData(const QString &s);
-    void readData();
-    void displayNetworkError (QAbstractSocket::SocketError);
+    bool newServer(int port = -1, const QString &address = QString());	//! Default port is from settings, address is localhost
+    void connectToServer(QString server = QString(), int port = -1);
+    NetState getNetState();
+    LiveShare* getLiveShare();
 
 public:
     void downloadImage (const QUrl &url, BranchItem *bi=NULL);
@@ -866,8 +940,11 @@ public:
 public slots:
     void updateSlideSelection (QItemSelection ,QItemSelection);
 private:
+    bool showSlide (SlideItem *si);	    //! Without script, if inScript is a snapshot
+    void resolveSlideTargets (int n);	    //! Find centers of slide n and the next few slides
     SlideModel* slideModel;
     bool blockSlideSelection;
+    uint layoutGeneration;		    //! Increased whenever objects are moved, invalidates slide targets
 };
 
 #endif
@@ -3,6 +3,7 @@
 #include "branchitem.h"
 #include "branchobj.h"
 #include "imageitem.h"
+#include "liveshare.h"
 #include "misc.h"
 #include "scripting.h"
 #include "vymmodel.h"
@@ -215,6 +216,11 @@ void VymModelWrapper::colorSubtree( const QString &color)
         model->colorSubtree( col );
 }
 
+void VymModelWrapper::connectToServer( const QString &server, int port)
+{
+    model->connectToServer( server, port );
+}
+
 void VymModelWrapper::copy()
 {
     model->copy();
@@ -364,6 +370,12 @@ bool VymModelWrapper::exportMap( )
     return setResult( true );
 }
 
+int VymModelWrapper::findWords( const QString &s)
+{
+    // Same query as used by the filter of the tree editor
+    return setResult( model->findWords( s ).count() );
+}
+
 QString VymModelWrapper::getDestPath()
 {
     QString r = model->getDestPath();
@@ -437,6 +449,15 @@ QString VymModelWrapper::getSelectionString()
     return setResult( model->getSelectString() );
 }
 
+int VymModelWrapper::getShareSequence()
+{
+    // Next operation sent by server or expected by client
+    int r = -1;
+    LiveShare *ls = model->getLiveShare();
+    if (ls) r = ls->getSequence();
+    return setResult( r );
+}
+
 int VymModelWrapper::getTaskPriorityDelta()
 {
     return model->getTaskPriorityDelta();
@@ -542,9 +563,9 @@ bool VymModelWrapper::hasTask()
     return setResult( r );
 }
 
-void VymModelWrapper::importDir( const QString &path)
+void VymModelWrapper::importDir( const QString &path, int maxDepth, const QString &filter, qint64 maxSize)
 {
-    model->importDir( path );    // FIXME-3 error handling missing (in vymmodel and here)
+    model->importDir( path, maxDepth, filter, maxSize );    // FIXME-3 error handling missing (in vymmodel and here)
 }
 
 bool VymModelWrapper::initIterator( const QString &iname, bool deepLevelsFirst)
@@ -1002,6 +1023,13 @@ void VymModelWrapper::setXLinkWidth( int w )
     model->setXLinkWidth( w );
 }
 
+int VymModelWrapper::shareMap( int port, const QString &address)
+{
+    int r = -1;
+    if (model->newServer( port, address )) r = model->getLiveShare()->serverPort();
+    return setResult( r );
+}
+
 void VymModelWrapper::sleep( int n)
 {
     // sleep is not avail on windows VCEE, workaround could be using this->thread()->wait(x ms) 
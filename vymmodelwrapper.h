@@ -45,10 +45,12 @@ public slots:
     void clearFlags();
     void colorBranch( const QString &color);
     void colorSubtree( const QString &color);
+    void connectToServer( const QString &server, int port);
     void copy();
     void cut();
     void cycleTask();
     bool exportMap(); 
+    int findWords( const QString &s);
     QString getDestPath();
     QString getFileDir();
     QString getFileName();
@@ -61,6 +63,7 @@ public slots:
     QString getNotePlainText();
     QString getNoteXML();
     QString getSelectionString();
+    int getShareSequence();
     int  getTaskPriorityDelta();
     QString getTaskSleep();
     int getTaskSleepDays();
@@ -75,7 +78,7 @@ public slots:
     bool hasNote();
     bool hasRichTextNote();
     bool hasTask();
-    void importDir( const QString &path);
+    void importDir( const QString &path, int maxDepth = -1, const QString &filter = "", qint64 maxSize = -1);
     bool initIterator(const QString &iname, bool deepLevelsFirst = false);
     bool isScrolled();
     void loadImage( const QString &filename);
@@ -147,6 +150,7 @@ public slots:
     void setXLinkStyleBegin( const QString &style);
     void setXLinkStyleEnd( const QString &style);
     void setXLinkWidth( int w );
+    int shareMap( int port = -1, const QString &address = QString());
     void sleep( int n);
     void sortChildren( bool b);
     void sortChildren();
@@ -1,8 +1,8 @@
 #include "vymtext.h"
 #include "misc.h"
 
-#include <QRegExp>
 #include <QDebug>
+#include <QStringList>
 #include <QTextDocument>
 
 /////////////////////////////////////////////////////////////////
@@ -51,6 +51,13 @@ void VymText::copy (const VymText &other)
     filenamehint = other.filenamehint;
     textmode = other.textmode;
     color = other.color;
+
+    plainCache = other.plainCache;
+    plainValid = other.plainValid;
+    asciiCache = other.asciiCache;
+    asciiIndent = other.asciiIndent;
+    asciiWidth = other.asciiWidth;
+    asciiValid = other.asciiValid;
 }
 
 void VymText::clear()
@@ -60,6 +67,13 @@ void VymText::clear()
     filenamehint = "";
     textmode = AutoText;
     color = Qt::black;
+    invalidateCache();
+}
+
+void VymText::invalidateCache()
+{
+    plainValid = false;
+    asciiValid = false;
 }
 
 void VymText::setRichText(bool b)
@@ -68,6 +82,7 @@ void VymText::setRichText(bool b)
         textmode = RichText;
     else
         textmode = PlainText;
+    invalidateCache();
 }
 
 bool VymText::isRichText()const
@@ -81,18 +96,21 @@ bool VymText::isRichText()const
 void VymText::setText (const QString &s)
 {
     text = s;
+    invalidateCache();
 }
 
 void VymText::setRichText (const QString &s)
 {
     text = s;
     textmode = RichText;
+    invalidateCache();
 }
 
 void VymText::setPlainText (const QString &s)
 {
     text = s;
     textmode = PlainText;
+    invalidateCache();
 }
 
 void VymText::setAutoText (const QString &s)
@@ -109,125 +127,76 @@ QString VymText::getText() const
     return text;
 }
 
+QString VymText::getTextPlain() const
+{
+    if (plainValid) return plainCache;
+
+    if (isRichText())
+    {
+        // Let Qt parse the HTML, this also takes care of entities and <style>
+        QTextDocument doc;
+        doc.setHtml (text);
+        plainCache = doc.toPlainText();
+        plainCache.replace (QChar::Nbsp, ' ');
+
+        // If string starts with \n now, remove it.
+        // It would be wrong in an OOo export for example
+        int i = 0;
+        while (i < plainCache.length() && plainCache.at(i) == '\n') i++;
+        plainCache.remove (0, i);
+    } else
+        plainCache = text;
+
+    plainValid = true;
+    return plainCache;
+}
+
 QString VymText::getTextASCII() const
 {
     return getTextASCII ("",80);
 }
 
-QString VymText::getTextASCII(QString indent, const int &) const //FIXME-3 use width
+QString VymText::getTextASCII(QString indent, const int &width) const
 {
     if (text.isEmpty()) return text;
 
-    int width = 80;
-    QString s;
-    QRegExp rx;
-    rx.setMinimal(true);
+    if (asciiValid && asciiIndent == indent && asciiWidth == width) return asciiCache;
 
-    if (isRichText())
-        s = text;
-    else
+    QStringList lines;
+    foreach (QString line, getTextPlain().split ('\n'))
     {
-        if ( fonthint == "fixed")
-        {
-            s = text; 
-        } else
+        // Wordwrap, fixed fonts in plaintext are kept as they are
+        if (width > 0 && (isRichText() || fonthint != "fixed"))
         {
-            // Wordwrap
-
-            QString newnote;
-            QString curline;
-            uint n=0;
-            while ( (int)n < text.length() )
+            while (line.length() > width)
             {
-                curline = curline + text.at(n);
-                if ( text.at(n) == '\n' )
-                {
-                    s = s + curline ;
-                    curline = "";
-                }
-
-                if (curline.length() > width)
-                {
-                    // Try to find last previous whitespace in curline
-                    uint i = curline.length() - 1;
-                    while ( i> 0 )
-                    {
-                        if ( curline.at(i) == ' ' )
-                        {
-                            s = s + curline.left(i) + '\n';
-                            curline = curline.right( curline.length() - i - 1 );
-                            break;
-                        }
-                        i--;
-                        if ( i == 0 )
-                        {
-                            // Cannot break this line into smaller parts
-                            s = s + curline;
-                            curline = "";
-                        }
-                    }
-                }
-                n++;
+                // Break at last whitespace within width or at next one
+                int i = line.lastIndexOf (' ', width);
+                if (i <= 0) i = line.indexOf (' ', width + 1);
+                if (i < 0) break;
+                lines.append (indent + line.left(i));
+                line = line.mid (i + 1);
             }
-            s = s + curline;
         }
-
-        // Indent lines
-        rx.setPattern("^");
-        s = s.replace (rx,indent);
-        rx.setPattern("\n");
-        s = s.replace (rx, "\n" + indent) + "\n";
-
-        return s.trimmed();
+        lines.append (indent + line);
     }
 
-    // Remove all <style...> ...</style>
-    rx.setPattern("<style.*>.*</style>");
-    s.replace (rx,"");
-
-    // convert all "<br*>" to "\n"
-    rx.setPattern ("<br.*>");
-    s.replace (rx,"\n");
-
-    // convert all "</p>" to "\n"
-    rx.setPattern ("</p>");
-    s.replace (rx,"\n");
-
-    // remove all remaining tags
-    rx.setPattern ("<.*>");
-    s.replace (rx,"");
-
-    // If string starts with \n now, remove it.
-    // It would be wrong in an OOo export for example
-    while ( s.at(0) == '\n' ) s.remove (0,1);
-
-    // convert "&", "<" and ">"
-    rx.setPattern ("&gt;");
-    s.replace (rx,">");
-    rx.setPattern ("&lt;");
-    s.replace (rx,"<");
-    rx.setPattern ("&amp;");
-    s.replace (rx,"&");
-    rx.setPattern ("&quot;");
-    s.replace (rx,"\"");
-
-    // Indent everything
-    rx.setPattern ("^\n");
-    s.replace (rx,indent);
-    s = indent + s;   // Don't forget first line
-
-/* FIXME-3  wrap text at width
-    if (fonthint !="fixed")
-    {
-    }
-*/
-    return s;
+    // Keep indent of first line, only remove trailing whitespace
+    asciiCache = lines.join ("\n");
+    int n = asciiCache.length();
+    while (n > 0 && asciiCache.at(n - 1).isSpace()) n--;
+    asciiCache.truncate (n);
+    asciiIndent = indent;
+    asciiWidth = width;
+    asciiValid = true;
+    return asciiCache;
 }
 
 void VymText::setFontHint (const QString &s)
 {
     // only for backward compatibility (pre 1.5 )
     fonthint=s;
+    invalidateCache();
 }
 
 QString VymText::getFontHint() const
@@ -27,8 +27,9 @@ public:
     void setPlainText (const QString&);
     void setAutoText (const QString &);
     QString getText() const;
+    QString getTextPlain() const;	//! Text without markup, not wrapped
     QString getTextASCII() const;
-    QString getTextASCII(QString igdent, const int &width=0) const;
+    QString getTextASCII(QString indent, const int &width=0) const;  //! Wrapped at width, if width > 0
     void setRichText(bool b);
     bool isRichText() const;
     void setFontHint (const QString&);
@@ -42,10 +43,20 @@ public:
     QString saveToDir();
 
 protected:
+    void invalidateCache();
     QString text;
     QString fonthint;
     QString filenamehint;
     TextMode textmode;
     QColor color;       // used for plaintext
+
+private:
+    // Plain and ASCII forms are only created again after text changed
+    mutable QString plainCache;
+    mutable bool plainValid;
+    mutable QString asciiCache;
+    mutable QString asciiIndent;
+    mutable int asciiWidth;
+    mutable bool asciiValid;
 };
 #endif
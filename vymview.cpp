@@ -10,6 +10,7 @@
 
 extern Main *mainWindow;
 extern Settings settings;
+extern bool batchMode;
 
 VymView::VymView(VymModel *m)
 {
@@ -46,18 +47,23 @@ VymView::VymView(VymModel *m)
     if (!mapEditor) mapEditor=new MapEditor (model);
     setCentralWidget (mapEditor);
 
-    // Create SlideEditor
-    slideEditor=new SlideEditor (model);
+    // Create SlideEditor, not needed without GUI in batch mode
+    slideEditor=NULL;
+    slideEditorDE=NULL;
+    if (!batchMode)
+    {
+	slideEditor=new SlideEditor (model);
 
-    de = new DockEditor (tr("Slide Editor","Title of dockable editor widget"), this, model);
-    de->setWidget (slideEditor);
-    de->setAllowedAreas (Qt::AllDockWidgetAreas);
-    addDockWidget(Qt::RightDockWidgetArea, de);
-    slideEditorDE=de;
-    slideEditorDE->hide();
-    connect (
-	slideEditorDE, SIGNAL (visibilityChanged(bool) ), 
-	mainWindow,SLOT (updateActions() ) );
+	de = new DockEditor (tr("Slide Editor","Title of dockable editor widget"), this, model);
+	de->setWidget (slideEditor);
+	de->setAllowedAreas (Qt::AllDockWidgetAreas);
+	addDockWidget(Qt::RightDockWidgetArea, de);
+	slideEditorDE=de;
+	slideEditorDE->hide();
+	connect (
+	    slideEditorDE, SIGNAL (visibilityChanged(bool) ), 
+	    mainWindow,SLOT (updateActions() ) );
+    }
 
     // Create Layout 
     /*
@@ -136,10 +142,13 @@ VymView::~VymView()
 
 void VymView::readSettings()
 {
-    if (settings.localValue(model->getFilePath(),"/slideeditor/visible","false").toBool() )
-	slideEditorDE->show();
-    else
-	slideEditorDE->hide();
+    if (slideEditorDE)
+    {
+	if (settings.localValue(model->getFilePath(),"/slideeditor/visible","false").toBool() )
+	    slideEditorDE->show();
+	else
+	    slideEditorDE->hide();
+    }
     if (settings.localValue(model->getFilePath(),"/treeeditor/visible","true").toBool() )
 	treeEditorDE->show();
     else
@@ -163,7 +172,7 @@ bool VymView::treeEditorIsVisible()
 
 bool VymView::slideEditorIsVisible()
 {
-    return slideEditorDE->isVisible();
+    return slideEditorDE && slideEditorDE->isVisible();
 }
 
 void VymView::initFocus()
@@ -173,12 +182,12 @@ void VymView::initFocus()
 
 void VymView::nextSlide()
 {
-    slideEditor->nextSlide();
+    if (slideEditor) slideEditor->nextSlide();
 }
 
 void VymView::previousSlide()
 {
-    slideEditor->previousSlide();
+    if (slideEditor) slideEditor->previousSlide();
 }
 
 void VymView::changeSelection (const QItemSelection &newsel, const QItemSelection &desel)  
@@ -328,6 +337,8 @@ void VymView::toggleTreeEditor()
 
 void VymView::toggleSlideEditor()
 {
+    if (!slideEditorDE) return;
+
     if (slideEditorDE->isVisible() )
     {
 	slideEditorDE->hide();
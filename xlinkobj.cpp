@@ -16,6 +16,11 @@ int XLinkObj::clickBorder = 8;
 int XLinkObj::pointRadius = 10;
 int XLinkObj::d_control = 300;
 
+int XLinkObj::updatesDeferred = 0;
+QSet <XLinkObj*> XLinkObj::pendingUpdates;
+int XLinkObj::updatesDone = 0;
+int XLinkObj::updatesSkipped = 0;
+
 XLinkObj::XLinkObj (QGraphicsItem* parent,Link *l):MapObj(parent)
 {
     //qDebug()<< "Const XLinkObj (parent,Link)";
@@ -28,6 +33,7 @@ XLinkObj::XLinkObj (QGraphicsItem* parent,Link *l):MapObj(parent)
 XLinkObj::~XLinkObj ()
 {
     //qDebug() << "Destr XLinkObj";
+    pendingUpdates.remove (this);
     delete (poly);
     delete (path);
     delete (ctrl_p0);
@@ -43,6 +49,11 @@ void XLinkObj::init ()
 
     stateVis = Hidden;
 
+    dirty = true;
+    doneBeginBO = doneEndBO = NULL;
+    doneBeginOrient = doneEndOrient = LinkableMapObj::UndefinedOrientation;
+    doneBeginVisible = doneEndVisible = false;
+
     QPen pen = link->getPen();
 
     path = scene()->addPath (QPainterPath(), pen, Qt::NoBrush);	
@@ -160,6 +171,7 @@ void XLinkObj::move (QPointF p)
 void XLinkObj::setEnd (QPointF p)
 {
     endPos=p;
+    dirty=true;
 }
 
 void XLinkObj::setSelection (CurrentSelection s)
@@ -302,6 +314,97 @@ void XLinkObj::updateXLink()
 	path->setZValue (dZ_XLINK);
 
     setVisibility();
+
+    // Remember state of ends
+    dirty = false;
+    doneBeginBO = beginBO;
+    doneEndBO = endBO;
+    if (beginBO)
+    {
+	doneBeginPos = beginBO->getChildRefPos();
+	doneBeginOrient = beginBO->getOrientation();
+	doneBeginVisible = beginBO->isVisibleObj();
+    }
+    if (endBO)
+    {
+	doneEndPos = endBO->getChildRefPos();
+	doneEndOrient = endBO->getOrientation();
+	doneEndVisible = endBO->isVisibleObj();
+    }
+    doneC0 = c0;
+    doneC1 = c1;
+}
+
+void XLinkObj::requestUpdate()
+{
+    // During a layout pass links are updated once at the end,
+    // when both ends have their final position
+    if (updatesDeferred > 0)
+	pendingUpdates.insert (this);
+    else if (isDirty() )
+    {
+	updateXLink();
+	updatesDone++;
+    } else
+	updatesSkipped++;
+}
+
+bool XLinkObj::isDirty()
+{
+    if (dirty || c0 != doneC0 || c1 != doneC1) return true;
+
+    BranchObj *beginBO=NULL;
+    BranchObj   *endBO=NULL;
+    BranchItem *bi=link->getBeginBranch();
+    if ( bi) beginBO=(BranchObj*)(bi->getLMO());
+    bi=link->getEndBranch();
+    if (bi) endBO=(BranchObj*)(bi->getLMO());
+
+    if (beginBO != doneBeginBO || endBO != doneEndBO) return true;
+    if (beginBO && 
+	(beginBO->getChildRefPos() != doneBeginPos ||
+	 beginBO->getOrientation() != doneBeginOrient ||
+	 beginBO->isVisibleObj() != doneBeginVisible) )
+	return true;
+    if (endBO && 
+	(endBO->getChildRefPos() != doneEndPos ||
+	 endBO->getOrientation() != doneEndOrient ||
+	 endBO->isVisibleObj() != doneEndVisible) )
+	return true;
+    return false;
+}
+
+void XLinkObj::setDirty()
+{
+    dirty = true;
+}
+
+void XLinkObj::deferUpdates()
+{
+    updatesDeferred++;
+}
+
+void XLinkObj::resumeUpdates()
+{
+    if (updatesDeferred > 0) updatesDeferred--;
+    if (updatesDeferred > 0) return;
+
+    QSet <XLinkObj*> links = pendingUpdates;
+    pendingUpdates.clear();
+    foreach (XLinkObj *xlo, links)
+    {
+	if (xlo->isDirty() )
+	{
+	    xlo->updateXLink();
+	    updatesDone++;
+	} else
+	    updatesSkipped++;
+    }
+}
+
+QString XLinkObj::getUpdateStats()
+{
+    return QString ("%1 updated, %2 skipped").arg(updatesDone).arg(updatesSkipped);
 }
 
 void XLinkObj::positionBBox()
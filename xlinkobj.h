@@ -2,6 +2,7 @@
 #define XLINKOBJ_H
 
 #include <QPen>
+#include <QSet>
 
 #include "arrowobj.h"
 #include "linkablemapobj.h"
@@ -34,6 +35,12 @@ public:
     void setSelection (int cp);
     void setSelection (CurrentSelection s);
     void updateXLink();
+    void requestUpdate();
+    bool isDirty();
+    void setDirty();
+    static void deferUpdates();
+    static void resumeUpdates();
+    static QString getUpdateStats();
     void positionBBox();
     void calcBBoxSize();
     void setVisibility (bool);
@@ -73,6 +80,23 @@ private:
 
     BranchItem *visBranch;  // the "visible" part of a partially scrolled li
     Link *link;
+
+    // State of both ends at last updateXLink, used to detect changes
+    bool dirty;
+    BranchObj *doneBeginBO;
+    BranchObj *doneEndBO;
+    QPointF doneBeginPos;
+    QPointF doneEndPos;
+    QPointF doneC0, doneC1;
+    LinkableMapObj::Orientation doneBeginOrient;
+    LinkableMapObj::Orientation doneEndOrient;
+    bool doneBeginVisible;
+    bool doneEndVisible;
+
+    static int updatesDeferred;
+    static QSet <XLinkObj*> pendingUpdates;
+    static int updatesDone;
+    static int updatesSkipped;
 };
 
 #endif